@@ -0,0 +1,269 @@
+/*
+ *  Automatic report (push) mode with a passive receiver
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Reports received through the transport layer (RTU over TCP)
+ *  V1.2/2026-10-16 Time of the read that completed a report
+ */
+#include <stdio.h>   /* Standard input/output definitions */
+#include <string.h>  /* memset, memcpy */
+#include <errno.h>   /* Error numbers */
+
+#include "autoreport.h"
+#include "transport.h"
+
+/* Reports are read responses */
+#define FUNC_READ_HOLDING 0x03
+#define FUNC_WRITE_SINGLE 0x06
+
+/* Attempts to write the interval register while reports may be on the line */
+#define AUTOREPORT_SET_TRIES 3
+
+/*
+ *  Local function prototypes
+ */
+static FrameState restart(AutoReport *ar, const uint8_t *rest, int n);
+static void deliver(AutoReport *ar);
+static long silence_us(const AutoReport *ar, const struct timespec *now);
+
+/**********************************************************************/
+
+/*
+ *  Initialize receiver
+ */
+void autoreport_init(AutoReport *ar, int fd, BusTiming *bus)
+{
+    memset(ar, 0, sizeof(AutoReport));
+    ar->fd = fd;
+    ar->bus = bus;
+    restart(ar, NULL, 0);
+}
+
+/*
+ *  Route frames of a device address to a callback
+ */
+int autoreport_route(AutoReport *ar, uint8_t addr, AutoReportFrame frame, void *arg)
+{
+    if (ar->n_route >= AUTOREPORT_MAX_ROUTES) {
+        return -1;
+    }
+
+    ar->route[ar->n_route].addr = addr;
+    ar->route[ar->n_route].frame = frame;
+    ar->route[ar->n_route].arg = arg;
+    ar->n_route++;
+
+    return 0;
+}
+
+/*
+ *  Read what the line has and deliver complete frames
+ */
+int autoreport_advance(AutoReport *ar, int readable)
+{
+    FrameAssembler *fa = &ar->fa;
+    uint8_t rest[FRAME_MAX_SIZE];
+    struct timespec now;
+    uint8_t *tail;
+    int room, result, n, delivered = 0;
+    FrameState state;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (!readable) {
+        /* Line silent for t3.5 in the middle of a frame: drop it */
+        if (fa->len > 0 && silence_us(ar, &now) <= 0) {
+            restart(ar, NULL, 0);
+        }
+        return 0;
+    }
+
+    tail = frame_tail(fa, &room);
+    if (room == 0) {
+        restart(ar, NULL, 0);
+        tail = frame_tail(fa, &room);
+    }
+
+    result = transport_read(ar->fd, 0, tail, room);
+    if (result < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        fprintf(stderr, "autoreport: read error: %s\n", strerror(errno));
+        return -1;
+    }
+    if (result == 0) {
+        return 0;
+    }
+
+    ar->last_rx = now;
+    ar->bus->last_activity = now;  /* t3.5 before a request counts from here */
+
+    state = frame_commit(fa, result);
+    while (state == FRAME_COMPLETE) {
+        deliver(ar);
+        delivered++;
+
+        /* Two reports in one read: the next one starts behind this one */
+        n = fa->len - fa->expected;
+        memcpy(rest, fa->buf + fa->expected, (size_t)n);
+        fa->len = fa->expected;
+        state = restart(ar, rest, n);
+    }
+
+    return delivered;
+}
+
+/*
+ *  Get the time of the report being delivered
+ */
+void autoreport_time(const AutoReport *ar, Timestamp *ts)
+{
+    timestamp_at(ts, (int64_t)ar->last_rx.tv_sec * 1000000000 + ar->last_rx.tv_nsec, 0);
+}
+
+/*
+ *  Get milliseconds until a partial frame is given up
+ */
+int autoreport_wait_ms(const AutoReport *ar)
+{
+    struct timespec now;
+    long us;
+
+    if (ar->fa.len == 0) {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    us = silence_us(ar, &now);
+
+    return us > 0 ? (int)((us + 999) / 1000) : 0;
+}
+
+/*
+ *  Set the automatic report interval of a device
+ */
+AppStatus autoreport_set(ModbusCtx *ctx, uint8_t adr, int seconds)
+{
+    PACKET pr;
+    uint8_t arg[4];
+    int resync, i;
+    AppStatus status = ERROR_INVALID_TIME;
+
+    if (seconds < 0 || seconds > AUTOREPORT_MAX) {
+        return ERROR_INVALID_TIME;
+    }
+
+    /* Register address (2 byte) + Interval (2 byte) */
+    arg[0] = (uint8_t)(AUTOREPORT_REG >> 8);
+    arg[1] = (uint8_t)(AUTOREPORT_REG & 0xFF);
+    arg[2] = 0x00;
+    arg[3] = (uint8_t)seconds;
+
+    /* A report on the line in front of the echo is skipped */
+    resync = ctx->bus->resync;
+    ctx->bus->resync = 1;
+    for (i = 0; i < AUTOREPORT_SET_TRIES; i++) {
+        status = modbus_transaction(ctx, adr, FUNC_WRITE_SINGLE, 4, arg, &pr, 0,
+                                    "autoreport_set", RECEIVE_MODE_ACKNOWLEDGE, NULL);
+        if (status == STATUS_OK) {
+            break;
+        }
+    }
+    ctx->bus->resync = resync;
+
+    return status;
+}
+
+/*
+ *  Read the automatic report interval of a device
+ */
+AppStatus autoreport_get(ModbusCtx *ctx, uint8_t adr, int *seconds)
+{
+    PACKET pr;
+    uint8_t *data;
+    uint8_t arg[4];
+    AppStatus status;
+
+    /* Register address (2 byte) + Read number (2 byte) */
+    arg[0] = (uint8_t)(AUTOREPORT_REG >> 8);
+    arg[1] = (uint8_t)(AUTOREPORT_REG & 0xFF);
+    arg[2] = 0x00;
+    arg[3] = 0x01;
+
+    status = modbus_transaction(ctx, adr, FUNC_READ_HOLDING, 4, arg, &pr, 0,
+                                "autoreport_get", RECEIVE_MODE_TEMPERATURE, &data);
+    if (status != STATUS_OK) {
+        return status;
+    }
+    if (pr.len != 2) {
+        return ERROR_RECEIVE_PACKET;
+    }
+
+    *seconds = (data[0] << 8) | data[1];
+    return STATUS_OK;
+}
+
+/* Local functions */
+
+/*
+ *  Start a new frame, feeding bytes already received behind the last one
+ */
+static FrameState restart(AutoReport *ar, const uint8_t *rest, int n)
+{
+    ar->stats.noise_bytes += (unsigned long)ar->fa.discarded;
+    if (ar->fa.expected == 0 || ar->fa.len < ar->fa.expected) {
+        ar->stats.noise_bytes += (unsigned long)ar->fa.len;  /* Partial frame */
+    }
+
+    frame_reset(&ar->fa);
+    frame_expect(&ar->fa, 0, FUNC_READ_HOLDING, 0);  /* Any address */
+    if (n > 0) {
+        return frame_feed(&ar->fa, rest, n);
+    }
+
+    return FRAME_NEED_MORE;
+}
+
+/*
+ *  Hand a complete frame to the route of its address
+ */
+static void deliver(AutoReport *ar)
+{
+    const FrameAssembler *fa = &ar->fa;
+    PACKET p;
+    int i;
+
+    if (fa->buf[1] != FUNC_READ_HOLDING) {
+        ar->stats.unrouted++;  /* Exception of a request by another master */
+        return;
+    }
+
+    p.addr = fa->buf[0];
+    p.inst = fa->buf[1];
+    p.len = fa->buf[2];
+    for (i = 0; i < p.len && i < DMAX; i++) {
+        p.data[i] = fa->buf[3 + i];
+    }
+    p.CRC = UINT16(fa->buf[fa->expected - 2], fa->buf[fa->expected - 1]);
+
+    for (i = 0; i < ar->n_route; i++) {
+        if (ar->route[i].addr == p.addr) {
+            ar->stats.frames++;
+            ar->route[i].frame(p.addr, &p, ar->route[i].arg);
+            return;
+        }
+    }
+    ar->stats.unrouted++;
+}
+
+/*
+ *  Time left until the line has been silent for t3.5
+ */
+static long silence_us(const AutoReport *ar, const struct timespec *now)
+{
+    long gap_us = ar->bus->frame_gap_us + ar->bus->host_latency_us;
+    long since_us = (now->tv_sec - ar->last_rx.tv_sec) * 1000000L +
+                    (now->tv_nsec - ar->last_rx.tv_nsec) / 1000L;
+
+    return gap_us - since_us;
+}
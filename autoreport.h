@@ -0,0 +1,143 @@
+/*
+ *  Automatic report (push) mode with a passive receiver
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Time of the read that completed a report
+ *
+ *  With register 0x00FD set to N, the R4DCB08 sends its temperatures on
+ *  its own every N seconds as a read response (function 0x03). The
+ *  receiver assembles these frames from the line without sending any
+ *  request and hands each one to the route of its device address.
+ */
+#ifndef AUTOREPORT_H
+#define AUTOREPORT_H
+
+#include <stdint.h>     /* For uint8_t */
+#include <time.h>       /* For struct timespec */
+#include "typedef.h"    /* For PACKET */
+#include "error.h"      /* For AppStatus */
+#include "packet.h"     /* For BusTiming */
+#include "frame.h"      /* For FrameAssembler */
+#include "modbus_ctx.h" /* For ModbusCtx */
+
+/* Automatic report interval register, 0 = off (query mode), 1-255 s */
+#define AUTOREPORT_REG 0x00FD
+#define AUTOREPORT_MAX 255
+
+/* Most device addresses routed by one receiver */
+#define AUTOREPORT_MAX_ROUTES 32
+
+/**
+ * Frame callback of a route
+ *
+ * @param addr Device address
+ * @param p    Decoded frame, data holds the temperature registers
+ * @param arg  Argument given to autoreport_route()
+ */
+typedef void (*AutoReportFrame)(uint8_t addr, const PACKET *p, void *arg);
+
+/**
+ * Route of one device address
+ */
+typedef struct {
+    uint8_t addr;              /* Device address */
+    AutoReportFrame frame;     /* Callback */
+    void *arg;                 /* Callback argument */
+} AutoReportRoute;
+
+/**
+ * Receiver statistics
+ */
+typedef struct {
+    unsigned long frames;      /* Frames handed to a route */
+    unsigned long unrouted;    /* Valid frames of addresses without a route */
+    unsigned long noise_bytes; /* Bytes dropped: noise, collisions, partial frames */
+} AutoReportStats;
+
+/**
+ * Passive receiver of one bus
+ */
+typedef struct {
+    int fd;                                    /* File descriptor of the serial port */
+    BusTiming *bus;                            /* Bus timing of the port */
+    FrameAssembler fa;                         /* Frame being received */
+    struct timespec last_rx;                   /* CLOCK_MONOTONIC time of the last byte */
+    AutoReportRoute route[AUTOREPORT_MAX_ROUTES]; /* Routes by address */
+    int n_route;                               /* Number of routes */
+    AutoReportStats stats;                     /* Statistics */
+} AutoReport;
+
+/**
+ * Initialize receiver
+ *
+ * @param ar  Pointer to receiver
+ * @param fd  File descriptor of the serial port (already configured)
+ * @param bus Bus timing of the port (t3.5 gap, host latency)
+ */
+extern void autoreport_init(AutoReport *ar, int fd, BusTiming *bus);
+
+/**
+ * Route frames of a device address to a callback
+ *
+ * @param ar    Pointer to receiver
+ * @param addr  Device address
+ * @param frame Callback
+ * @param arg   Callback argument
+ * @return      0 on success, -1 if the table is full
+ */
+extern int autoreport_route(AutoReport *ar, uint8_t addr, AutoReportFrame frame, void *arg);
+
+/**
+ * Read what the line has and deliver complete frames
+ *
+ * Bytes in front of a frame that cannot start a valid report are
+ * dropped one at a time, a partial frame is dropped after t3.5 silence.
+ *
+ * @param ar       Pointer to receiver
+ * @param readable Non-zero if the fd was reported readable
+ * @return         Number of frames delivered, -1 on read error
+ */
+extern int autoreport_advance(AutoReport *ar, int readable);
+
+/**
+ * Get milliseconds until a partial frame is given up
+ *
+ * @param ar Pointer to receiver
+ * @return   Timeout for poll(), -1 if no frame is partially received
+ */
+extern int autoreport_wait_ms(const AutoReport *ar);
+
+/**
+ * Get the time of the report being delivered
+ *
+ * For the frame callback: the read that brought the last byte of the
+ * report, not the time the callback runs.
+ *
+ * @param ar Pointer to receiver
+ * @param ts Pointer to store the sample time
+ */
+extern void autoreport_time(const AutoReport *ar, Timestamp *ts);
+
+/**
+ * Set the automatic report interval of a device
+ *
+ * The write is retried with resync, since the device may be pushing a
+ * report while it is being switched off.
+ *
+ * @param ctx     Transaction context of the port
+ * @param adr     Device address
+ * @param seconds Interval 1-255 s, 0 = off
+ * @return        STATUS_OK on success, AppStatus error code on failure
+ */
+extern AppStatus autoreport_set(ModbusCtx *ctx, uint8_t adr, int seconds);
+
+/**
+ * Read the automatic report interval of a device
+ *
+ * @param ctx     Transaction context of the port
+ * @param adr     Device address
+ * @param seconds Pointer to store the interval (0 = off)
+ * @return        STATUS_OK on success, AppStatus error code on failure
+ */
+extern AppStatus autoreport_get(ModbusCtx *ctx, uint8_t adr, int *seconds);
+
+#endif /* AUTOREPORT_H */
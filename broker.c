@@ -0,0 +1,363 @@
+/*
+ *  Serial bus broker: Modbus RTU requests of local clients over a Unix socket
+ *  V1.0/2026-10-16
+ */
+#include <stdio.h>      /* Standard input/output definitions */
+#include <stdlib.h>     /* getenv */
+#include <string.h>     /* memset, strrchr */
+#include <unistd.h>     /* close, unlink */
+#include <fcntl.h>      /* fcntl */
+#include <errno.h>      /* Error numbers */
+#include <sys/stat.h>   /* mkdir, stat */
+#include <sys/socket.h> /* socket, accept, recv, send */
+#include <sys/un.h>     /* sockaddr_un */
+#include <sys/epoll.h>  /* epoll */
+
+#include "broker.h"
+#include "crc16.h"
+
+/* Event data of the listening socket, clients use their slot index */
+#define BROKER_LISTEN_EVENT BROKER_MAX_CLIENTS
+
+/*
+ *  Local function prototypes
+ */
+static void accept_clients(Broker *b);
+static int read_request(Broker *b, int k);
+static void drop_client(Broker *b, int k);
+static void send_frame(Broker *b, int k, const uint8_t *buf, int len);
+
+/**********************************************************************/
+
+/*
+ *  Work out the socket path of a serial port
+ */
+int broker_path(const char *dir, const char *port, char *path, size_t size)
+{
+    const char *name = strrchr(port, '/');
+    int n;
+
+    if (dir == NULL || dir[0] == '\0') {
+        dir = getenv("R4DCB08_BROKER_DIR");
+    }
+    if (dir == NULL || dir[0] == '\0') {
+        dir = BROKER_DEFAULT_DIR;
+    }
+
+    n = snprintf(path, size, "%s/%s.sock", dir, name != NULL ? name + 1 : port);
+    return n > 0 && (size_t)n < size && n < BROKER_PATH_MAX ? 0 : -1;
+}
+
+/*
+ *  Listen for clients of a serial port
+ */
+AppStatus broker_open(Broker *b, const char *dir, const char *port)
+{
+    struct sockaddr_un addr;
+    struct epoll_event ev;
+    char *slash;
+
+    memset(b, 0, sizeof(Broker));
+    b->listen_fd = -1;
+    b->epfd = -1;
+    for (int k = 0; k < BROKER_MAX_CLIENTS; k++) {
+        b->client[k].fd = -1;
+    }
+
+    if (broker_path(dir, port, b->path, sizeof(b->path)) != 0) {
+        fprintf(stderr, "broker: socket path for %s too long\n", port);
+        return ERROR_PORT_INIT;
+    }
+
+    /* Directory of the socket (one level, e.g. /run/r4dcb08) */
+    slash = strrchr(b->path, '/');
+    if (slash != NULL && slash != b->path) {
+        *slash = '\0';
+        if (mkdir(b->path, 0755) < 0 && errno != EEXIST) {
+            fprintf(stderr, "broker: mkdir %s: %s\n", b->path, strerror(errno));
+        }
+        *slash = '/';
+    }
+
+    b->listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (b->listen_fd < 0) {
+        fprintf(stderr, "broker: socket: %s\n", strerror(errno));
+        return ERROR_PORT_INIT;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, b->path, strlen(b->path) + 1);  /* Length checked by broker_path() */
+
+    /* Socket of a previous run: nobody accepts on it any more */
+    unlink(b->path);
+    if (bind(b->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(b->listen_fd, BROKER_MAX_CLIENTS) < 0) {
+        fprintf(stderr, "broker: %s: %s\n", b->path, strerror(errno));
+        broker_close(b);
+        return ERROR_PORT_INIT;
+    }
+
+    b->epfd = epoll_create1(EPOLL_CLOEXEC);
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = BROKER_LISTEN_EVENT;
+    if (b->epfd < 0 || epoll_ctl(b->epfd, EPOLL_CTL_ADD, b->listen_fd, &ev) < 0) {
+        fprintf(stderr, "broker: epoll: %s\n", strerror(errno));
+        broker_close(b);
+        return ERROR_PORT_INIT;
+    }
+
+    return STATUS_OK;
+}
+
+/*
+ *  Get the file descriptor to wait on
+ */
+int broker_fd(const Broker *b)
+{
+    return b->epfd;
+}
+
+/*
+ *  Accept new clients and read their requests without blocking
+ */
+int broker_advance(Broker *b)
+{
+    struct epoll_event events[BROKER_MAX_CLIENTS + 1];
+    int n, i, k, queued = 0;
+
+    if (b->epfd < 0) {
+        return 0;
+    }
+
+    n = epoll_wait(b->epfd, events, BROKER_MAX_CLIENTS + 1, 0);
+    for (i = 0; i < n; i++) {
+        k = (int)events[i].data.u32;
+        if (k == BROKER_LISTEN_EVENT) {
+            accept_clients(b);
+        } else {
+            queued += read_request(b, k);
+        }
+    }
+
+    return queued;
+}
+
+/*
+ *  Take the oldest queued request for the bus
+ */
+int broker_next(Broker *b, const WireFrame **req)
+{
+    int best = -1;
+
+    for (int k = 0; k < BROKER_MAX_CLIENTS; k++) {
+        if (b->client[k].queued &&
+            (best < 0 || b->client[k].seq < b->client[best].seq)) {
+            best = k;
+        }
+    }
+    if (best < 0) {
+        return -1;
+    }
+
+    b->client[best].queued = 0;
+    b->client[best].inflight = 1;
+    *req = &b->client[best].req;
+
+    return best;
+}
+
+/*
+ *  Send the result of a request back to its client
+ */
+void broker_reply(Broker *b, int client, const ModbusCtx *ctx, AppStatus status)
+{
+    BrokerClient *c;
+    const FrameAssembler *fa = &ctx->rx.fa;
+    WireFrame exc;
+    uint8_t *data;
+
+    if (client < 0 || client >= BROKER_MAX_CLIENTS) {
+        return;
+    }
+    c = &b->client[client];
+    c->inflight = 0;
+
+    /* Client gone while its request was on the bus */
+    if (c->fd < 0) {
+        b->stats.dropped++;
+        return;
+    }
+
+    /* Response and exception frames go back as the device sent them */
+    if ((status == STATUS_OK || status == ERROR_PACKET_EXCEPTION) &&
+        fa->expected > 0 && fa->len >= fa->expected) {
+        b->stats.replies++;
+        send_frame(b, client, fa->buf, fa->expected);
+        return;
+    }
+
+    b->stats.no_reply++;
+    data = packet_encode_begin(&exc, c->req.buf[0], (uint8_t)(c->req.buf[1] | 0x80));
+    data[0] = BROKER_EXC_NO_RESPONSE;
+    if (packet_encode_end(&exc, 1) == STATUS_OK) {
+        send_frame(b, client, exc.buf, exc.len);
+    }
+}
+
+/*
+ *  Close all connections and remove the socket
+ */
+void broker_close(Broker *b)
+{
+    for (int k = 0; k < BROKER_MAX_CLIENTS; k++) {
+        if (b->client[k].fd >= 0) {
+            close(b->client[k].fd);
+            b->client[k].fd = -1;
+        }
+    }
+    if (b->listen_fd >= 0) {
+        close(b->listen_fd);
+        b->listen_fd = -1;
+        unlink(b->path);
+    }
+    if (b->epfd >= 0) {
+        close(b->epfd);
+        b->epfd = -1;
+    }
+}
+
+/*
+ *  Connect to the broker of a serial port (client side)
+ */
+int broker_connect(const char *port, char *path, size_t size)
+{
+    struct sockaddr_un addr;
+    struct stat st;
+    int fd;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (broker_path(NULL, port, addr.sun_path, sizeof(addr.sun_path)) != 0 ||
+        stat(addr.sun_path, &st) < 0 || !S_ISSOCK(st.st_mode)) {
+        return -1;
+    }
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);  /* Stale socket, nobody listening */
+        return -1;
+    }
+
+    if (path != NULL && size > 0) {
+        strncpy(path, addr.sun_path, size - 1);
+        path[size - 1] = '\0';
+    }
+    return fd;
+}
+
+/* Local functions */
+
+/*
+ *  Accept all pending connections into free slots
+ */
+static void accept_clients(Broker *b)
+{
+    struct epoll_event ev;
+    int fd, k;
+
+    while ((fd = accept(b->listen_fd, NULL, NULL)) >= 0) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        for (k = 0; k < BROKER_MAX_CLIENTS; k++) {
+            if (b->client[k].fd < 0 && !b->client[k].inflight) {
+                break;
+            }
+        }
+        if (k == BROKER_MAX_CLIENTS) {
+            close(fd);  /* Full: the client sees the connection closed */
+            continue;
+        }
+
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u32 = (uint32_t)k;
+        if (epoll_ctl(b->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            continue;
+        }
+
+        memset(&b->client[k], 0, sizeof(BrokerClient));
+        b->client[k].fd = fd;
+        b->stats.clients++;
+    }
+}
+
+/*
+ *  Read one request message of a client, returns 1 if it was queued
+ */
+static int read_request(Broker *b, int k)
+{
+    BrokerClient *c = &b->client[k];
+    uint8_t buf[PACKET_WIRE_SIZE + 1];
+    ssize_t n;
+
+    if (c->fd < 0) {
+        return 0;
+    }
+
+    n = recv(c->fd, buf, sizeof(buf), 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        drop_client(b, k);
+        return 0;
+    }
+    if (n < 0) {
+        return 0;
+    }
+
+    /* One frame per message, CRC over frame and CRC is 0; one request at a time */
+    if (n < 4 || n > PACKET_WIRE_SIZE || crc16_modbus(buf, (size_t)n) != 0 ||
+        c->queued || c->inflight) {
+        b->stats.dropped++;
+        return 0;
+    }
+
+    memcpy(c->req.buf, buf, (size_t)n);
+    c->req.len = (int)n;
+    c->queued = 1;
+    c->seq = b->seq++;
+    b->stats.requests++;
+
+    return 1;
+}
+
+/*
+ *  Close a client connection, a request on the bus keeps the slot
+ */
+static void drop_client(Broker *b, int k)
+{
+    BrokerClient *c = &b->client[k];
+
+    epoll_ctl(b->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+    if (c->queued) {
+        c->queued = 0;
+        b->stats.dropped++;
+    }
+}
+
+/*
+ *  Send one frame to a client, a client that cannot take it is dropped
+ */
+static void send_frame(Broker *b, int k, const uint8_t *buf, int len)
+{
+    if (send(b->client[k].fd, buf, (size_t)len, MSG_NOSIGNAL | MSG_DONTWAIT) != len) {
+        drop_client(b, k);
+    }
+}
@@ -0,0 +1,146 @@
+/*
+ *  Serial bus broker: Modbus RTU requests of local clients over a Unix socket
+ *  V1.0/2026-10-16
+ *
+ *  The process that owns a serial port (and its flock()) listens on a
+ *  SOCK_SEQPACKET socket next to it. Each message from a client is one
+ *  RTU request frame, CRC included; the broker puts it on the bus between
+ *  its own transactions and sends back the response frame as received,
+ *  or a gateway exception (0x0B) when the device did not answer. A client
+ *  thus uses the socket like the tty itself.
+ */
+#ifndef BROKER_H
+#define BROKER_H
+
+#include <stddef.h>      /* For size_t */
+#include "error.h"       /* For AppStatus */
+#include "packet.h"      /* For WireFrame */
+#include "modbus_ctx.h"  /* For ModbusCtx */
+
+/* Directory of the sockets, overridden by $R4DCB08_BROKER_DIR */
+#define BROKER_DEFAULT_DIR "/run/r4dcb08"
+
+/* Most clients connected to one broker */
+#define BROKER_MAX_CLIENTS 16
+
+/* Longest socket path */
+#define BROKER_PATH_MAX 108
+
+/* Client response timeout: queue wait in front of the bus included */
+#define BROKER_CLIENT_TIMEOUT_MS 3000
+
+/* Modbus exception: gateway target device failed to respond */
+#define BROKER_EXC_NO_RESPONSE 0x0B
+
+/**
+ * One connected client
+ */
+typedef struct {
+    int fd;                  /* Connection, -1 = closed */
+    WireFrame req;           /* Last request received */
+    int queued;              /* Request waiting for the bus */
+    int inflight;            /* Request on the bus, slot kept until the reply */
+    unsigned long seq;       /* Arrival order of the queued request */
+} BrokerClient;
+
+/**
+ * Broker statistics
+ */
+typedef struct {
+    unsigned long clients;   /* Connections accepted */
+    unsigned long requests;  /* Requests queued */
+    unsigned long replies;   /* Responses forwarded from the bus */
+    unsigned long no_reply;  /* Gateway exceptions sent (timeout, CRC, ...) */
+    unsigned long dropped;   /* Malformed messages and requests of closed clients */
+} BrokerStats;
+
+/**
+ * Broker of one serial port
+ */
+typedef struct {
+    int listen_fd;                            /* Listening socket, -1 = closed */
+    int epfd;                                 /* epoll over listen_fd and clients */
+    char path[BROKER_PATH_MAX];               /* Socket path */
+    BrokerClient client[BROKER_MAX_CLIENTS];  /* Client slots */
+    unsigned long seq;                        /* Arrival counter */
+    BrokerStats stats;                        /* Statistics */
+} Broker;
+
+/**
+ * Work out the socket path of a serial port
+ *
+ * /dev/ttyUSB0 -> {dir}/ttyUSB0.sock
+ *
+ * @param dir  Socket directory (NULL = $R4DCB08_BROKER_DIR or BROKER_DEFAULT_DIR)
+ * @param port Serial port device
+ * @param path Buffer for the path
+ * @param size Size of the buffer
+ * @return     0 on success, -1 if the path does not fit
+ */
+extern int broker_path(const char *dir, const char *port, char *path, size_t size);
+
+/**
+ * Listen for clients of a serial port
+ *
+ * A stale socket left by a previous run is replaced.
+ *
+ * @param b    Pointer to broker
+ * @param dir  Socket directory (NULL = default), created if missing
+ * @param port Serial port device
+ * @return     STATUS_OK, ERROR_PORT_INIT on failure
+ */
+extern AppStatus broker_open(Broker *b, const char *dir, const char *port);
+
+/**
+ * Get the file descriptor to wait on (readable when a client needs service)
+ *
+ * @param b Pointer to broker
+ * @return  epoll file descriptor, -1 if not open
+ */
+extern int broker_fd(const Broker *b);
+
+/**
+ * Accept new clients and read their requests without blocking
+ *
+ * @param b Pointer to broker
+ * @return  Number of requests queued
+ */
+extern int broker_advance(Broker *b);
+
+/**
+ * Take the oldest queued request for the bus
+ *
+ * @param b   Pointer to broker
+ * @param req Pointer to store the request (valid until broker_reply())
+ * @return    Client index, -1 if nothing is queued
+ */
+extern int broker_next(Broker *b, const WireFrame **req);
+
+/**
+ * Send the result of a request back to its client
+ *
+ * @param b      Pointer to broker
+ * @param client Client index from broker_next()
+ * @param ctx    Context the request ran on (response frame in its receiver)
+ * @param status Result of the transaction
+ */
+extern void broker_reply(Broker *b, int client, const ModbusCtx *ctx, AppStatus status);
+
+/**
+ * Close all connections and remove the socket
+ *
+ * @param b Pointer to broker
+ */
+extern void broker_close(Broker *b);
+
+/**
+ * Connect to the broker of a serial port (client side)
+ *
+ * @param port Serial port device
+ * @param path Buffer for the socket path (may be NULL)
+ * @param size Size of the buffer
+ * @return     Connected socket, -1 if no broker listens for the port
+ */
+extern int broker_connect(const char *port, char *path, size_t size);
+
+#endif /* BROKER_H */
@@ -4,6 +4,7 @@
 #include <unistd.h>
 #include <string.h>
 #include <libgen.h>
+#include <math.h>
 
 #include "config.h"
 #include "error.h"
@@ -17,29 +18,60 @@
 #include "help_functions.h"
 #include "constants.h"
 #include "scan.h"
+#include "modbus_ctx.h"
+#include "broker.h"
+#include "transport.h"
+#include "poller.h"
+#include "realtime.h"
 
 /* External global variables */
 extern char *progname;
 
+/* Contexts of the ports polled together (-p list) */
+static ModbusCtx port_ctx[MAX_PORTS];
+
+/* Single port reached through the socket of a broker that owns it */
+static int brokered = 0;
+
+/* Transport of the single port */
+static TransportType transport = TRANSPORT_SERIAL;
+
 
 /* Initialize configuration */
 void init_config(ProgramConfig *config) {
     config->port = NULL;
     config->address = DEFAULT_ADDRESS;
     config->baudrate = 9600;
-    config->time_step = 1;
+    config->period_ms = 1000;
+    config->catch_up = 0;
+    config->time_format = TS_ISO;
     config->num_channels = 1;
     config->read_correction = 0;
     config->new_address = 0;
     config->baudrate_code = BAUD_INVALID;
     config->channel = -1;
     config->correction_temp = 0.0;
+    config->num_corrections = 0;
     config->enable_median_filter = 0;
     config->enable_maf_filter = 0;
     config->maf_window_size = 5;
     config->one_shot = 0;
     config->factory_reset = 0;
     config->scan_mode = 0;
+    config->detect_baud = 0;
+    config->bench_count = 0;
+    config->resync = 0;
+    config->timeout_floor = 0;
+    config->timeout_ceiling = 0;
+    config->low_latency = 0;
+    config->io_uring = 0;
+    config->realtime.priority = 0;
+    config->realtime.cpu = -1;
+    config->auto_report = -1;
+    config->read_auto_report = 0;
+    config->num_ports = 0;
+    config->scan_first = MIN_DEVICE_ADDRESS;
+    config->scan_last = MAX_DEVICE_ADDRESS;
 }
 
 /* Validate device address */
@@ -52,14 +84,78 @@ static AppStatus validate_device_address(uint8_t address) {
     return STATUS_OK;
 }
 
+/* Parse a time step: seconds with up to 3 decimals (0.25), or milliseconds (250ms) */
+static AppStatus parse_period(const char *text, long *period_ms) {
+    char *end;
+    double v = strtod(text, &end);
+
+    if (end == text || !isfinite(v) || v < 0.0) {
+        return ERROR_INVALID_TIME;
+    }
+    if (*end == '\0' || strcmp(end, "s") == 0) {
+        v *= 1000.0;
+    } else if (strcmp(end, "ms") != 0) {
+        return ERROR_INVALID_TIME;
+    }
+    /* Range checked before the cast, a double beyond long is undefined */
+    if (v + 0.5 >= PERIOD_MAX_MS + 1.0) {
+        return ERROR_INVALID_TIME;
+    }
+    *period_ms = (long)(v + 0.5);
+    return STATUS_OK;
+}
+
+/* Parse a list of corrections Tc1,Tc2,... for channels 1..n */
+static AppStatus parse_corrections(const char *list, ProgramConfig *config) {
+    const char *p = list;
+    char *end;
+    int n = 0;
+
+    while (*p != '\0') {
+        if (n >= MAX_CHANNELS) {
+            return ERROR_INVALID_CHANNEL;
+        }
+        config->corrections[n] = strtof(p, &end);
+        if (end == p || (*end != ',' && *end != '\0')) {
+            return ERROR_INVALID_CHANNEL;
+        }
+        n++;
+        p = (*end == ',') ? end + 1 : end;
+    }
+
+    config->num_corrections = n;
+    return n > 0 ? STATUS_OK : ERROR_INVALID_CHANNEL;
+}
+
+/* Parse a count 1..max, the whole text must be a number */
+static AppStatus parse_count(const char *text, int max, int *count) {
+    char *end;
+    long n = strtol(text, &end, 10);
+
+    if (end == text || *end != '\0' || n < 1 || n > max) {
+        return ERROR_INVALID_ARGUMENT;
+    }
+    *count = (int)n;
+    return STATUS_OK;
+}
+
 /* Process command line arguments */
 AppStatus parse_arguments(int argc, char *argv[], ProgramConfig *config) {
     int c;
 
-    while ((c = getopt(argc, argv, "p:a:b:t:n:cw:s:x:mM:frSh?")) != -1) {
+    while ((c = getopt(argc, argv, "p:a:b:t:n:cw:s:C:x:mM:frSDA:B:RT:Li:IUKF:E:h?")) != -1) {
         switch (c) {
-            case 'p':  /* Port name */
-                config->port = optarg;
+            case 'p':  /* Port name(s), comma separated */
+                config->num_ports = 0;
+                for (char *name = strtok(optarg, ","); name != NULL;
+                     name = strtok(NULL, ",")) {
+                    if (config->num_ports == MAX_PORTS) {
+                        fprintf(stderr, "More than %d ports in -p option!\n", MAX_PORTS);
+                        return ERROR_PORT_INIT;
+                    }
+                    config->ports[config->num_ports++] = name;
+                }
+                config->port = config->num_ports > 0 ? config->ports[0] : NULL;
                 break;
             case 'a':  /* Device address */
                 config->address = (uint8_t)atoi(optarg);
@@ -69,14 +165,29 @@ AppStatus parse_arguments(int argc, char *argv[], ProgramConfig *config) {
                 break;
             case 'b':  /* Baudrate */
                 config->baudrate = (int)atoi(optarg);
+                if (config->baudrate < SERIAL_BAUD_MIN || config->baudrate > SERIAL_BAUD_MAX) {
+                    fprintf(stderr, "Baud rate %d is not %d..%d!\n",
+                            config->baudrate, SERIAL_BAUD_MIN, SERIAL_BAUD_MAX);
+                    return ERROR_INVALID_BAUDRATE;
+                }
                 break;
             case 't':  /* Time step */
-                config->time_step = atoi(optarg);
-                if (config->time_step < 0) {
-                    fprintf(stderr, "Time step must be positive or zero!\n");
+                if (parse_period(optarg, &config->period_ms) != STATUS_OK) {
+                    fprintf(stderr, "Time step %s is not 0..%ld s (e.g. 2, 0.25, 100ms)!\n",
+                            optarg, PERIOD_MAX_MS / 1000);
                     return ERROR_INVALID_TIME;
                 }
                 break;
+            case 'K':  /* Catch up after an overrun */
+                config->catch_up = 1;
+                break;
+            case 'F':  /* Timestamp format */
+                if (timestamp_parse_format(optarg, &config->time_format) != 0) {
+                    fprintf(stderr, "Timestamp format %s is not iso, ms or ns!\n", optarg);
+                    return ERROR_INVALID_TIME;
+                }
+                timestamp_set_format(config->time_format);
+                break;
             case 'n': /* Number of channels */
                 config->num_channels = atoi(optarg);
                 if (config->num_channels < 1 || config->num_channels > MAX_CHANNELS) {
@@ -105,6 +216,12 @@ AppStatus parse_arguments(int argc, char *argv[], ProgramConfig *config) {
                     return ERROR_INVALID_CHANNEL;
                 }
                 break;
+            case 'C':  /* Set corrections of channels 1..n */
+                if (parse_corrections(optarg, config) != STATUS_OK) {
+                    fprintf(stderr, "Invalid format for -C parameter, expected Tc1,Tc2,...\n");
+                    return ERROR_INVALID_CHANNEL;
+                }
+                break;
             case 'x':  /* Set device baudrate */
                 config->baudrate_code = (uint8_t)(atoi(optarg));
                 if (config->baudrate_code > BAUD_19200) {
@@ -139,6 +256,66 @@ AppStatus parse_arguments(int argc, char *argv[], ProgramConfig *config) {
             case 'S':  /* Scan bus */
                 config->scan_mode = 1;
                 break;
+            case 'D':  /* Detect device baud rate */
+                config->detect_baud = 1;
+                break;
+            case 'A':  /* Scan address range */
+                if (sscanf(optarg, "%d-%d", &config->scan_first, &config->scan_last) != 2 ||
+                    config->scan_first < MIN_DEVICE_ADDRESS ||
+                    config->scan_last > MAX_DEVICE_ADDRESS ||
+                    config->scan_first > config->scan_last) {
+                    fprintf(stderr, "Invalid address range '%s' in -A option, expected %d-%d!\n",
+                            optarg, MIN_DEVICE_ADDRESS, MAX_DEVICE_ADDRESS);
+                    return ERROR_INVALID_ADDRESS;
+                }
+                break;
+            case 'B':  /* Poll benchmark */
+                if (parse_count(optarg, BENCH_COUNT_MAX, &config->bench_count) != STATUS_OK) {
+                    fprintf(stderr, "Invalid count '%s' in -B option, expected 1-%d!\n",
+                            optarg, BENCH_COUNT_MAX);
+                    return ERROR_INVALID_ARGUMENT;
+                }
+                break;
+            case 'R':  /* Resync on noisy bus */
+                config->resync = 1;
+                break;
+            case 'T':  /* Adaptive timeouts */
+                if (sscanf(optarg, "%d,%d", &config->timeout_floor,
+                           &config->timeout_ceiling) != 2) {
+                    fprintf(stderr, "Invalid format for -T parameter, expected min,max\n");
+                    return ERROR_INVALID_TIME;
+                }
+                if (config->timeout_floor < 1 ||
+                    config->timeout_ceiling < config->timeout_floor) {
+                    fprintf(stderr, "Invalid timeout range (%d,%d) in -T option!\n",
+                            config->timeout_floor, config->timeout_ceiling);
+                    return ERROR_INVALID_TIME;
+                }
+                break;
+            case 'L':  /* Low-latency RS485 profile */
+                config->low_latency = 1;
+                break;
+            case 'i':  /* Automatic report interval */
+                config->auto_report = atoi(optarg);
+                if (config->auto_report < 0 || config->auto_report > 255) {
+                    fprintf(stderr, "Automatic report interval %d is not 0..255!\n",
+                            config->auto_report);
+                    return ERROR_INVALID_TIME;
+                }
+                break;
+            case 'I':  /* Read automatic report interval */
+                config->read_auto_report = 1;
+                break;
+            case 'U':  /* io_uring backend of the poller */
+                config->io_uring = 1;
+                break;
+            case 'E':  /* Real-time reading */
+                if (realtime_parse(optarg, &config->realtime) != 0) {
+                    fprintf(stderr, "Real-time setting %s is not prio[:cpu], prio 1..99!\n",
+                            optarg);
+                    return ERROR_REALTIME;
+                }
+                break;
             case 'h':  /* Help */
             case '?':  /* Help */
                 help();
@@ -157,72 +334,304 @@ AppStatus parse_arguments(int argc, char *argv[], ProgramConfig *config) {
     return STATUS_OK;
 }
 
+/* Get rate applied by the driver, report if it differs from the request */
+static int applied_baud(const char *device, int fd, int baud) {
+    int actual = serial_get_baud(fd, baud);
+
+    if (actual != baud) {
+        fprintf(stderr, "# %s: %d baud requested, driver applied %d baud\n",
+                device, baud, actual);
+    }
+    return actual;
+}
+
+/* Apply the low-latency profile, report it, return host latency [us] */
+static long low_latency_profile(const char *device, int fd) {
+    SerialTuning tuning;
+
+    serial_tune_low_latency(fd, device, &tuning);
+    serial_tune_print(stdout, device, &tuning);
+    return serial_host_latency_us(&tuning);
+}
+
 /* Initialize port (from main.c) */
-static AppStatus init_port(char *device, int baud, int *fd) {
+static AppStatus init_port(char *device, const ProgramConfig *config, int *fd) {
     int rc;
+    char path[BROKER_PATH_MAX];
+
+    /* A daemon owns the port: its broker queues our requests on the bus */
+    *fd = broker_connect(device, path, sizeof(path));
+    if (*fd >= 0) {
+        fprintf(stderr, "# %s: through broker %s\n", device, path);
+        brokered = 1;
+        packet_set_baudrate(SERIAL_BAUD_MAX);  /* No wire to pace on the socket */
+        packet_set_timeout(BROKER_CLIENT_TIMEOUT_MS);
+        return STATUS_OK;
+    }
 
-    *fd = open_port(device);
+    *fd = transport_open(device);
     if (*fd < 0) {
         return ERROR_PORT_INIT;
     }
-    
-    rc = set_port(*fd, baud);
+    transport = transport_type(device);
+    packet_set_resync(config->resync);
+    packet_set_adaptive_timeout(config->timeout_floor, config->timeout_ceiling);
+
+    /* No termios on a socket, only the gaps of the line behind it */
+    if (transport != TRANSPORT_SERIAL) {
+        packet_set_baudrate(transport_pace_baud(transport, config->baudrate));
+        return STATUS_OK;
+    }
+
+    rc = set_port(*fd, config->baudrate);
     if (rc < 0) {
-        close(*fd);
+        transport_close(*fd);
         *fd = -1;
         return ERROR_PORT_INIT;
     }
-    
+
+    /* Gap timing follows the rate on the wire */
+    packet_set_baudrate(applied_baud(device, *fd, config->baudrate));
+
+    /* With -B the benchmark measures before applying the profile */
+    if (config->low_latency && config->bench_count == 0) {
+        packet_set_host_latency(low_latency_profile(device, *fd));
+    }
+
+    return STATUS_OK;
+}
+
+/* Open all ports of a -p list, one context each */
+static AppStatus open_ports(const ProgramConfig *config) {
+    int fd, serial;
+    TransportType type;
+
+    for (int k = 0; k < config->num_ports; k++) {
+        type = transport_type(config->ports[k]);
+        serial = type == TRANSPORT_SERIAL;
+        fd = transport_open(config->ports[k]);
+        if (fd < 0 || (serial && set_port(fd, config->baudrate) < 0)) {
+            if (fd >= 0) {
+                transport_close(fd);
+            }
+            while (--k >= 0) {
+                transport_close(port_ctx[k].fd);
+            }
+            return ERROR_PORT_INIT;
+        }
+        modbus_ctx_init(&port_ctx[k], fd, serial ?
+                        applied_baud(config->ports[k], fd, config->baudrate) :
+                        transport_pace_baud(type, config->baudrate));
+        modbus_ctx_set_resync(&port_ctx[k], config->resync);
+        modbus_ctx_set_adaptive_timeout(&port_ctx[k], config->timeout_floor,
+                                        config->timeout_ceiling);
+        if (config->low_latency && serial) {
+            modbus_ctx_set_host_latency(&port_ctx[k],
+                                        low_latency_profile(config->ports[k], fd));
+        }
+    }
+
     return STATUS_OK;
 }
 
+/* Enter real-time mode (-E) for the reading loop */
+static AppStatus start_realtime(const ProgramConfig *config) {
+    char msg[256];
+    char spec[REALTIME_SPEC_MAX];
+
+    if (config->realtime.priority == 0) {
+        return STATUS_OK;
+    }
+    if (realtime_prepare(&config->realtime, msg, sizeof(msg)) != 0 ||
+        realtime_enter(&config->realtime, msg, sizeof(msg)) != 0) {
+        fprintf(stderr, "Real-time mode failed: %s!\n", msg);
+        return ERROR_REALTIME;
+    }
+
+    realtime_format(&config->realtime, spec, sizeof(spec));
+    fprintf(stderr, "# Real-time: SCHED_FIFO %s, memory locked\n", spec);
+    return STATUS_OK;
+}
+
+/* Read temperature or run benchmark on all ports of a -p list at once */
+static AppStatus execute_ports(const ProgramConfig *config) {
+    AppStatus status;
+
+    if (config->factory_reset || config->baudrate_code != BAUD_INVALID ||
+        config->new_address || config->channel >= 0 || config->read_correction ||
+        config->num_corrections > 0 || config->auto_report >= 0 ||
+        config->read_auto_report) {
+        fprintf(stderr, "Port list in -p and -U only for reading, -B and -S!\n");
+        return ERROR_INVALID_PORT;
+    }
+    if (config->enable_median_filter || config->enable_maf_filter) {
+        fprintf(stderr, "Filters -m and -M need a single port!\n");
+        return ERROR_INVALID_PORT;
+    }
+
+    status = open_ports(config);
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    status = start_realtime(config);
+    if (status != STATUS_OK) {
+        /* Ports are closed below */
+    } else if (config->bench_count > 0) {
+        status = poll_benchmark_ports(port_ctx, config->ports, config->num_ports,
+                                      config->address, config->num_channels,
+                                      config->bench_count);
+    } else {
+        status = read_temp_ports(port_ctx, config->ports, config->num_ports,
+                                 config->address, config->num_channels,
+                                 config->period_ms,
+                                 config->catch_up ? TICKER_CATCH_UP : TICKER_SKIP,
+                                 config->one_shot);
+    }
+
+    for (int k = 0; k < config->num_ports; k++) {
+        transport_close(port_ctx[k].fd);
+    }
+    return status;
+}
+
 /* Execute command according to configuration */
 AppStatus execute_command(ProgramConfig *config) {
     int fd;
     AppStatus status;
     char *device = config->port ? config->port : DEFAULT_PORT;
+    char msg[256];
+
+    /* Bus scan and baud rate detection open their port(s) themselves */
+    if (config->scan_mode || config->detect_baud) {
+        if (config->num_ports == 0) {
+            config->ports[config->num_ports++] = device;
+        }
+        if (config->detect_baud) {
+            return scan_baud_ports(config->ports, config->num_ports, config->address,
+                                   config->baudrate);
+        }
+        return scan_ports(config->ports, config->num_ports, config->baudrate,
+                          (uint8_t)config->scan_first, (uint8_t)config->scan_last);
+    }
+
+    /* Missing privileges are reported before any port is touched */
+    if (config->realtime.priority > 0 &&
+        realtime_check(&config->realtime, msg, sizeof(msg)) != 0) {
+        fprintf(stderr, "-E: %s!\n", msg);
+        return ERROR_REALTIME;
+    }
+
+    /* Several ports are polled together, io_uring needs the poller too */
+    if (config->io_uring) {
+        poller_set_backend(POLLER_URING);
+        if (config->num_ports == 0) {
+            config->ports[config->num_ports++] = device;
+        }
+    }
+    if (config->num_ports > 1 || config->io_uring) {
+        return execute_ports(config);
+    }
     
     /* Initialize port */
-    status = init_port(device, config->baudrate, &fd);
+    status = init_port(device, config, &fd);
     if (status != STATUS_OK) {
         return status;
     }
     
-    /* Process commands in priority order */
-    if (config->scan_mode) {
-        status = scan_bus(fd, MIN_DEVICE_ADDRESS, MAX_DEVICE_ADDRESS);
-        close(fd);
-        return status;
+    /* The broker forwards request/response pairs, nothing else */
+    if (brokered && (config->auto_report > 0 || config->low_latency)) {
+        fprintf(stderr, "-i and -L need the serial port, %s is in use by a broker!\n",
+                device);
+        transport_close(fd);
+        return ERROR_INVALID_PORT;
     }
 
+    /* Tuning is for a tty, pushed reports have no transaction ID */
+    if ((config->low_latency && transport != TRANSPORT_SERIAL) ||
+        (config->auto_report > 0 && transport == TRANSPORT_MODBUS_TCP)) {
+        fprintf(stderr, "-L needs a serial port, -i a serial port or rtu-tcp://!\n");
+        transport_close(fd);
+        return ERROR_INVALID_PORT;
+    }
+
+    /* Process commands in priority order */
     if (config->factory_reset) {
         status = factory_reset(fd, config->address);
-        close(fd);
+        transport_close(fd);
         return status;
     }
 
     if (config->baudrate_code != BAUD_INVALID) {
         status = write_baudrate(fd, config->address, config->baudrate_code);
-        close(fd);
+        transport_close(fd);
         return status;
     }
     
     if (config->new_address) {
         status = write_address(fd, config->address, config->new_address);
-        close(fd);
+        transport_close(fd);
         return status;
     }
 
     if (config->channel >= 0) {
         status = write_correction(fd, config->address, config->channel, 
                                  config->correction_temp);
-        close(fd);
+        transport_close(fd);
+        return status;
+    }
+
+    if (config->num_corrections > 0) {
+        status = write_corrections(fd, config->address, config->corrections,
+                                   config->num_corrections);
+        transport_close(fd);
         return status;
     }
 
     if (config->read_correction) {
         status = read_correction(fd, config->address);
-        close(fd);
+        transport_close(fd);
+        return status;
+    }
+
+    if (config->read_auto_report) {
+        status = read_auto_report(fd, config->address);
+        transport_close(fd);
+        return status;
+    }
+
+    if (config->auto_report == 0) {
+        status = write_auto_report(fd, config->address, 0);
+        transport_close(fd);
+        return status;
+    }
+
+    /* Everything below is a reading loop */
+    status = start_realtime(config);
+    if (status != STATUS_OK) {
+        transport_close(fd);
+        return status;
+    }
+
+    if (config->auto_report > 0) {
+        status = read_temp_auto(fd, config->address, config->num_channels,
+                                config->auto_report, config->one_shot);
+        fflush(stdout);
+        transport_close(fd);
+        return status;
+    }
+
+    if (config->bench_count > 0 && config->low_latency) {
+        status = latency_benchmark(fd, device, config->address, config->num_channels,
+                                   config->bench_count);
+        transport_close(fd);
+        return status;
+    }
+
+    if (config->bench_count > 0) {
+        status = poll_benchmark(fd, config->address, config->num_channels,
+                                config->bench_count);
+        transport_close(fd);
         return status;
     }
 
@@ -236,11 +645,12 @@ AppStatus execute_command(ProgramConfig *config) {
 
     /* Default action - read temperature */
     status = read_temp(fd, config->address, config->num_channels,
-                     config->time_step, config->enable_median_filter,
+                     config->period_ms, config->catch_up ? TICKER_CATCH_UP : TICKER_SKIP,
+                     config->enable_median_filter,
                      config->enable_maf_filter, config->maf_window_size,
                      config->one_shot);
     
     fflush(stdout);
-    close(fd);
+    transport_close(fd);
     return status;
 }
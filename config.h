@@ -4,25 +4,46 @@
 
 #include <stdint.h>
 #include "error.h"
+#include "constants.h"
+#include "now.h"
+#include "realtime.h"
 
 /* Structure for storing program configuration */
 typedef struct {
     char *port;              /* Port name */
+    char *ports[MAX_PORTS];  /* Port names of a -p list (bus scan) */
+    int num_ports;           /* Number of ports in the -p list */
     uint8_t address;         /* Device address */
     int baudrate;            /* Port baudrate */
-    int time_step;           /* Time step between measurements [s] */
+    long period_ms;          /* Time step between measurements [ms] */
+    int catch_up;            /* 1 to catch up samples missed by an overrun (-K) */
+    TimestampFormat time_format; /* Text of sample timestamps (-F) */
     int num_channels;        /* Number of channels (1..8) */
     int read_correction;     /* 1 to read correction temperature, 0 otherwise */
     uint8_t new_address;     /* New device address */
     uint8_t baudrate_code;   /* Device baudrate code */
     int channel;             /* Channel number for correction */
     float correction_temp;   /* Correction temperature */
+    float corrections[MAX_CHANNELS]; /* Corrections of channels 1..n (-C) */
+    int num_corrections;     /* Number of corrections in -C, 0 = none */
     int enable_median_filter;/* 1 to enable median filter, 0 otherwise */
     int enable_maf_filter;   /* 1 to enable MAF filter, 0 otherwise */
     int maf_window_size;     /* MAF window size (odd, 3-15) */
     int one_shot;            /* 1 enable one shot measure, 0 othervise */
     int factory_reset;       /* 1 to perform factory reset, 0 otherwise */
     int scan_mode;           /* 1 to scan bus for devices, 0 otherwise */
+    int detect_baud;         /* 1 to detect the device baud rate, 0 otherwise */
+    int bench_count;         /* Poll benchmark transactions, 0 = off */
+    int resync;              /* 1 to resynchronize on noisy bus, 0 otherwise */
+    int timeout_floor;       /* Adaptive timeout floor [ms], 0 = fixed timeout */
+    int timeout_ceiling;     /* Adaptive timeout ceiling [ms] */
+    int low_latency;         /* 1 to apply the low-latency RS485 profile */
+    int auto_report;         /* Automatic report interval [s] (-i), -1 = query mode */
+    int read_auto_report;    /* 1 to read the automatic report interval (-I) */
+    int io_uring;            /* 1 to poll the ports through io_uring (-U) */
+    RealtimeConfig realtime; /* Real-time reading (-E), priority 0 = off */
+    int scan_first;          /* Bus scan address range */
+    int scan_last;
 } ProgramConfig;
 
 /**
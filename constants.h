@@ -12,6 +12,9 @@
 /* Serial port constants */
 #define DEFAULT_PORT "/dev/ttyUSB0"      /* Linux */
 #define DEFAULT_ADDRESS '\x01'           /* Default device address */
+#define MAX_PORTS 8                      /* Ports in a -p list (polled at once) */
+#define BENCH_COUNT_MAX 100000000        /* Transactions of one -B benchmark */
+#define PERIOD_MAX_MS 86400000L          /* Longest -t time step: one day */
 
 /* Baudrate codes enumeration */
 typedef enum {
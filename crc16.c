@@ -0,0 +1,220 @@
+/*
+ *  Modbus CRC-16 engine
+ *  V1.0/2026-10-16  Table and slice-by-4/8 variants, streaming update
+ *  V1.1/2026-10-16  Method resolved once before first use, atomic switch
+ *
+ *  Slice-by-N: table[k][b] is the CRC register after byte b followed by
+ *  k zero bytes, so N input bytes can be folded with N independent
+ *  lookups instead of N dependent ones.
+ */
+#include <stdio.h>   /* Standard input/output definitions */
+#include <stdlib.h>  /* getenv */
+#include <string.h>  /* String functions */
+#include <pthread.h> /* pthread_once */
+
+#include "crc16.h"
+
+#define CRC16_POLY   0xA001  /* Reflected 0x8005 */
+#define CRC16_SLICES 8       /* Number of tables for slice-by-8 */
+
+static uint16_t crc_table[CRC16_SLICES][256];
+static Crc16Method crc_method = CRC16_DEFAULT_METHOD;  /* Atomic, set by crc16_build() first */
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+static const char *method_names[CRC16_METHOD_MAX] = {
+    "bitwise", "table", "slice4", "slice8"
+};
+
+/*
+ *  Local function prototypes
+ */
+static void crc16_build(void);
+static uint16_t crc16_bitwise(uint16_t crc, const uint8_t *buf, size_t len);
+static uint16_t crc16_table(uint16_t crc, const uint8_t *buf, size_t len);
+static uint16_t crc16_slice4(uint16_t crc, const uint8_t *buf, size_t len);
+static uint16_t crc16_slice8(uint16_t crc, const uint8_t *buf, size_t len);
+
+/**********************************************************************/
+
+/*
+ *  Build lookup tables and read environment override (run once)
+ */
+static void crc16_build(void)
+{
+    const char *env;
+    int b, k;
+
+    for (b = 0; b < 256; b++) {
+        crc_table[0][b] = crc16_bitwise(0, (const uint8_t[]){ (uint8_t)b }, 1);
+    }
+
+    for (k = 1; k < CRC16_SLICES; k++) {
+        for (b = 0; b < 256; b++) {
+            uint16_t prev = crc_table[k - 1][b];
+            crc_table[k][b] = (prev >> 8) ^ crc_table[0][prev & 0xFF];
+        }
+    }
+
+    env = getenv(CRC16_METHOD_ENV);
+    if (env != NULL && env[0] != '\0') {
+        for (k = 0; k < CRC16_METHOD_MAX; k++) {
+            if (strcmp(env, method_names[k]) == 0) {
+                crc_method = (Crc16Method)k;
+                return;
+            }
+        }
+        fprintf(stderr, "crc16: Unknown method '%s' in %s, using %s\n",
+                env, CRC16_METHOD_ENV, method_names[crc_method]);
+    }
+}
+
+/*
+ *  Build lookup tables
+ */
+void crc16_init(void)
+{
+    pthread_once(&crc_once, crc16_build);
+}
+
+/*
+ *  Select CRC method at runtime
+ */
+int crc16_set_method(Crc16Method method)
+{
+    if (method < 0 || method >= CRC16_METHOD_MAX) {
+        return -1;
+    }
+
+    crc16_init();
+    __atomic_store_n(&crc_method, method, __ATOMIC_RELAXED);
+    return 0;
+}
+
+/*
+ *  Get currently selected CRC method
+ */
+Crc16Method crc16_get_method(void)
+{
+    crc16_init();
+    return __atomic_load_n(&crc_method, __ATOMIC_RELAXED);
+}
+
+/*
+ *  Get method name
+ */
+const char *crc16_method_name(Crc16Method method)
+{
+    if (method < 0 || method >= CRC16_METHOD_MAX) {
+        return "unknown";
+    }
+    return method_names[method];
+}
+
+/*
+ *  Continue CRC computation with an explicit method
+ */
+uint16_t crc16_update_method(Crc16Method method, uint16_t crc,
+                             const uint8_t *buf, size_t len)
+{
+    if (buf == NULL || len == 0) {
+        return crc;
+    }
+
+    crc16_init();
+
+    switch (method) {
+        case CRC16_METHOD_BITWISE:
+            return crc16_bitwise(crc, buf, len);
+        case CRC16_METHOD_TABLE:
+            return crc16_table(crc, buf, len);
+        case CRC16_METHOD_SLICE4:
+            return crc16_slice4(crc, buf, len);
+        case CRC16_METHOD_SLICE8:
+        default:
+            return crc16_slice8(crc, buf, len);
+    }
+}
+
+/*
+ *  Continue CRC computation with the selected method
+ */
+uint16_t crc16_update(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    /* Environment override applied before the method is read */
+    return crc16_update_method(crc16_get_method(), crc, buf, len);
+}
+
+/*
+ *  Calculate Modbus CRC16 of a buffer
+ */
+uint16_t crc16_modbus(const uint8_t *buf, size_t len)
+{
+    return crc16_update(CRC16_INIT, buf, len);
+}
+
+/* Local functions */
+
+/*
+ *  Bit-by-bit reference implementation (former CRC16_2 in packet.c)
+ */
+static uint16_t crc16_bitwise(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    for (size_t pos = 0; pos < len; pos++) {
+        crc ^= (uint16_t)buf[pos];    /* XOR byte into least sig. byte of crc */
+
+        for (int i = 8; i != 0; i--) {    /* Loop over each bit */
+            if ((crc & 0x0001) != 0) {    /* If the LSB is set */
+                crc >>= 1;                /* Shift right and XOR poly */
+                crc ^= CRC16_POLY;
+            }
+            else {                        /* Else LSB is not set */
+                crc >>= 1;                /* Just shift right */
+            }
+        }
+    }
+
+    return crc;
+}
+
+/*
+ *  One table lookup per byte
+ */
+static uint16_t crc16_table(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    while (len--) {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *buf++) & 0xFF];
+    }
+    return crc;
+}
+
+/*
+ *  Four bytes per step
+ */
+static uint16_t crc16_slice4(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    while (len >= 4) {
+        crc ^= (uint16_t)buf[0] | ((uint16_t)buf[1] << 8);
+        crc = crc_table[3][crc & 0xFF] ^ crc_table[2][crc >> 8] ^
+              crc_table[1][buf[2]] ^ crc_table[0][buf[3]];
+        buf += 4;
+        len -= 4;
+    }
+    return crc16_table(crc, buf, len);
+}
+
+/*
+ *  Eight bytes per step
+ */
+static uint16_t crc16_slice8(uint16_t crc, const uint8_t *buf, size_t len)
+{
+    while (len >= 8) {
+        crc ^= (uint16_t)buf[0] | ((uint16_t)buf[1] << 8);
+        crc = crc_table[7][crc & 0xFF] ^ crc_table[6][crc >> 8] ^
+              crc_table[5][buf[2]] ^ crc_table[4][buf[3]] ^
+              crc_table[3][buf[4]] ^ crc_table[2][buf[5]] ^
+              crc_table[1][buf[6]] ^ crc_table[0][buf[7]];
+        buf += 8;
+        len -= 8;
+    }
+    return crc16_slice4(crc, buf, len);
+}
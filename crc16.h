@@ -0,0 +1,102 @@
+/*
+ *  Modbus CRC-16 engine
+ *  V1.0/2026-10-16
+ *
+ *  CRC-16/MODBUS (poly 0xA001 reflected, init 0xFFFF, no final XOR)
+ *  with bitwise, 256-entry table and slice-by-4/8 implementations.
+ */
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stdint.h>  /* For uint8_t, uint16_t */
+#include <stddef.h>  /* For size_t */
+
+/* Initial CRC register value for a new frame */
+#define CRC16_INIT 0xFFFF
+
+/* Environment variable for runtime method selection */
+#define CRC16_METHOD_ENV "R4DCB08_CRC16"
+
+/**
+ * CRC computation methods
+ */
+typedef enum {
+    CRC16_METHOD_BITWISE = 0,  /* Original bit-by-bit loop */
+    CRC16_METHOD_TABLE = 1,    /* One 256-entry table lookup per byte */
+    CRC16_METHOD_SLICE4 = 2,   /* Four bytes per step, 4 tables */
+    CRC16_METHOD_SLICE8 = 3,   /* Eight bytes per step, 8 tables */
+    CRC16_METHOD_MAX
+} Crc16Method;
+
+/* Build-time default (override with -DCRC16_DEFAULT_METHOD=...) */
+#ifndef CRC16_DEFAULT_METHOD
+#define CRC16_DEFAULT_METHOD CRC16_METHOD_SLICE8
+#endif
+
+/**
+ * Build lookup tables and apply R4DCB08_CRC16 environment override
+ *
+ * Safe to call more than once and from several threads; crc16_update()
+ * calls it on first use.
+ */
+extern void crc16_init(void);
+
+/**
+ * Select CRC method at runtime
+ *
+ * @param method CRC method
+ * @return       0 on success, -1 on invalid method
+ */
+extern int crc16_set_method(Crc16Method method);
+
+/**
+ * Get currently selected CRC method
+ *
+ * @return Active method
+ */
+extern Crc16Method crc16_get_method(void);
+
+/**
+ * Get method name ("bitwise", "table", "slice4", "slice8")
+ *
+ * @param method CRC method
+ * @return       Static string, "unknown" for invalid method
+ */
+extern const char *crc16_method_name(Crc16Method method);
+
+/**
+ * Continue CRC computation over another chunk of bytes
+ *
+ * Start with CRC16_INIT; chunks may be of any size, so the CRC can be
+ * accumulated while a frame is being received. Running the update over
+ * a complete frame including its CRC bytes yields 0 for a valid frame.
+ *
+ * @param crc Current CRC register value
+ * @param buf Data bytes
+ * @param len Number of bytes
+ * @return    Updated CRC register value
+ */
+extern uint16_t crc16_update(uint16_t crc, const uint8_t *buf, size_t len);
+
+/**
+ * Same as crc16_update() with an explicit method (for verification)
+ *
+ * @param method CRC method
+ * @param crc    Current CRC register value
+ * @param buf    Data bytes
+ * @param len    Number of bytes
+ * @return       Updated CRC register value
+ */
+extern uint16_t crc16_update_method(Crc16Method method, uint16_t crc,
+                                    const uint8_t *buf, size_t len);
+
+/**
+ * Calculate Modbus CRC16 of a buffer in one call
+ *
+ * @param buf Data bytes
+ * @param len Number of bytes
+ * @return    CRC (low byte is transmitted first)
+ */
+extern uint16_t crc16_modbus(const uint8_t *buf, size_t len);
+
+#endif /* CRC16_H */
@@ -0,0 +1,107 @@
+/*
+ *  Microbenchmark of the CRC-16 methods (make bench)
+ *  V1.0/2026-10-16
+ *
+ *  Checks every method against the bitwise reference, whole and split in
+ *  two chunks, then times each method on frame sizes seen on the bus:
+ *  8 (request), 21 (8 channels), 37 (16 registers) and 256 bytes.
+ */
+#include <stdio.h>   /* Standard input/output definitions */
+#include <stdlib.h>  /* rand, strtol */
+#include <stdint.h>  /* Standard integer types */
+#include <time.h>    /* clock_gettime */
+
+#include "crc16.h"
+
+/* Bytes run through each method per frame size */
+#define BENCH_BYTES 160000000L
+
+/*
+ *  Local function prototypes
+ */
+static double seconds(void);
+static int verify(const uint8_t *buf, size_t len);
+
+/**********************************************************************/
+
+int main(int argc, char *argv[])
+{
+    static const size_t sizes[] = { 8, 21, 37, 256 };
+    uint8_t buf[256];
+    long bytes = argc > 1 ? strtol(argv[1], NULL, 10) : BENCH_BYTES;
+    volatile uint16_t sink = 0;
+    size_t i;
+    int m;
+
+    for (i = 0; i < sizeof(buf); i++) {
+        buf[i] = (uint8_t)rand();
+    }
+
+    if (verify(buf, sizeof(buf)) != 0) {
+        return 1;
+    }
+
+    printf("Default method: %s\n", crc16_method_name(crc16_get_method()));
+    printf("%5s %-8s %10s %10s\n", "len", "method", "ns/frame", "ns/byte");
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        long frames = bytes / (long)sizes[i];
+
+        for (m = 0; m < CRC16_METHOD_MAX; m++) {
+            double t = seconds();
+            for (long k = 0; k < frames; k++) {
+                sink ^= crc16_update_method((Crc16Method)m, CRC16_INIT, buf, sizes[i]);
+            }
+            t = seconds() - t;
+            printf("%5zu %-8s %10.1f %10.2f\n", sizes[i], crc16_method_name((Crc16Method)m),
+                   t / frames * 1e9, t / frames / sizes[i] * 1e9);
+        }
+    }
+
+    return 0;
+}
+
+/* Local functions */
+
+/*
+ *  Monotonic time in seconds
+ */
+static double seconds(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+/*
+ *  Every method equals the bitwise reference, also when streamed
+ */
+static int verify(const uint8_t *buf, size_t len)
+{
+    static const uint8_t request[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x01 };
+    uint16_t ref, crc;
+    size_t n;
+    int m;
+
+    if (crc16_modbus(request, sizeof(request)) != 0x0A84) {
+        fprintf(stderr, "crc16_bench: CRC of 01 03 00 00 00 01 is not 0x0A84\n");
+        return -1;
+    }
+
+    for (n = 0; n <= len; n++) {
+        ref = crc16_update_method(CRC16_METHOD_BITWISE, CRC16_INIT, buf, n);
+        for (m = 0; m < CRC16_METHOD_MAX; m++) {
+            crc = crc16_update_method((Crc16Method)m, CRC16_INIT, buf, n / 3);
+            crc = crc16_update_method((Crc16Method)m, crc, buf + n / 3, n - n / 3);
+            if (crc != ref ||
+                crc16_update_method((Crc16Method)m, CRC16_INIT, buf, n) != ref) {
+                fprintf(stderr, "crc16_bench: %s differs at length %zu\n",
+                        crc16_method_name((Crc16Method)m), n);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
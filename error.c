@@ -19,6 +19,8 @@ const char* get_error_message(AppStatus status) {
             return "Invalid time step";
         case ERROR_TOO_MANY_ARGS:
             return "Too many arguments";
+        case ERROR_INVALID_ARGUMENT:
+            return "Invalid option argument";
         case ERROR_PORT_INIT:
             return "Port initialization failure";
         case ERROR_SEND_PACKET:
@@ -37,6 +39,8 @@ const char* get_error_message(AppStatus status) {
             return "Data length exceeds maximum";
         case ERROR_PACKET_WRITE:
             return "Failed to write packet to port";
+        case ERROR_PACKET_EXCEPTION:
+            return "Device returned Modbus exception";
         case ERROR_WRITE_ADDRESS:
             return "Failed to write address";
         case ERROR_WRITE_BAUDRATE:
@@ -53,6 +57,10 @@ const char* get_error_message(AppStatus status) {
             return "Failed to factory reset";
         case ERROR_MAF_FILTER:
             return "MAF filter failure";
+        case ERROR_AUTO_REPORT:
+            return "Failed to set automatic report";
+        case ERROR_REALTIME:
+            return "Real-time mode not available";
         default:
             return "Unknown error";
     }
@@ -16,6 +16,7 @@ typedef enum {
     ERROR_INVALID_CHANNEL = -13, /* Invalid channel number */
     ERROR_INVALID_TIME = -14,    /* Invalid time step */
     ERROR_TOO_MANY_ARGS = -15,   /* Too many arguments */
+    ERROR_INVALID_ARGUMENT = -16,/* Invalid option argument */
     
     /* Communication errors */
     ERROR_PORT_INIT = -20,       /* Port initialization failure */
@@ -27,6 +28,7 @@ typedef enum {
     ERROR_PACKET_MODE = -26,     /* Invalid receive mode */
     ERROR_PACKET_OVERFLOW = -27, /* Data length exceeds maximum */
     ERROR_PACKET_WRITE = -28,    /* Failed to write packet to port */
+    ERROR_PACKET_EXCEPTION = -29,/* Device answered with Modbus exception */
     
     /* Operation errors */
     ERROR_WRITE_ADDRESS = -30,   /* Failed to write address */
@@ -36,7 +38,9 @@ typedef enum {
     ERROR_READ_CORRECTION = -34, /* Failed to read correction */
     ERROR_MEDIAN_FILTER = -35,   /* Median filter failure */
     ERROR_FACTORY_RESET = -36,   /* Failed to factory reset */
-    ERROR_MAF_FILTER = -37       /* MAF filter failure */
+    ERROR_MAF_FILTER = -37,      /* MAF filter failure */
+    ERROR_AUTO_REPORT = -38,     /* Failed to set automatic report */
+    ERROR_REALTIME = -39         /* Real-time mode not available */
 } AppStatus;
 
 /**
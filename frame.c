@@ -0,0 +1,258 @@
+/*
+ *  Modbus RTU frame assembler
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Resync mode: skip noise in front of the expected response
+ *  V1.2/2026-10-16 Any address in resync mode (unsolicited frames)
+ */
+#include <stdint.h>  /* Specific width integer types */
+#include <string.h>  /* memcpy */
+
+#include "frame.h"
+#include "crc16.h"
+
+/* Function codes with fixed-length responses */
+#define FUNC_READ_HOLDING   0x03
+#define FUNC_READ_INPUT     0x04
+#define FUNC_WRITE_SINGLE   0x06
+#define FUNC_WRITE_MULTIPLE 0x10
+#define FUNC_EXCEPTION_FLAG 0x80
+
+/*
+ *  Local function prototypes
+ */
+static FrameState frame_update(FrameAssembler *fa);
+static FrameState frame_scan(FrameAssembler *fa);
+static int frame_header_matches(const FrameAssembler *fa);
+static void frame_drop(FrameAssembler *fa);
+
+/**********************************************************************/
+
+/*
+ *  Reset assembler for a new frame
+ */
+void frame_reset(FrameAssembler *fa)
+{
+    fa->len = 0;
+    fa->expected = 0;
+    fa->crc_len = 0;
+    fa->crc = CRC16_INIT;
+    fa->match = 0;
+    fa->discarded = 0;
+}
+
+/*
+ *  Enable resync mode for the response to an outstanding request
+ */
+void frame_expect(FrameAssembler *fa, uint8_t addr, uint8_t func, int len)
+{
+    fa->match = 1;
+    fa->match_addr = addr;
+    fa->match_func = func;
+    fa->match_len = len;
+}
+
+/*
+ *  Work out the response length for a request
+ */
+int frame_response_length(const uint8_t *req, int len)
+{
+    if (len < 2) {
+        return 0;
+    }
+
+    switch (req[1]) {
+        case FUNC_READ_HOLDING:
+        case FUNC_READ_INPUT:
+            if (len < 6) {
+                return 0;
+            }
+            return 2 * ((req[4] << 8) | req[5]) + 5;  /* 2 bytes per register */
+        case FUNC_WRITE_SINGLE:
+        case FUNC_WRITE_MULTIPLE:
+            return 8;  /* Echo of register and value/count */
+        default:
+            return 0;
+    }
+}
+
+/*
+ *  Work out total frame length from the frame header
+ */
+int frame_expected_length(const uint8_t *buf, int len)
+{
+    if (len < 2) {
+        return 0;
+    }
+
+    if (buf[1] & FUNC_EXCEPTION_FLAG) {
+        return 5;  /* ADDR + FUNC + CODE + CRC(2) */
+    }
+
+    switch (buf[1]) {
+        case FUNC_READ_HOLDING:
+        case FUNC_READ_INPUT:
+            if (len < 3) {
+                return 0;
+            }
+            return buf[2] + 5;  /* ADDR + FUNC + LEN + DATA + CRC(2) */
+        case FUNC_WRITE_SINGLE:
+        case FUNC_WRITE_MULTIPLE:
+            return 8;  /* ADDR + FUNC + REG(2) + VALUE/COUNT(2) + CRC(2) */
+        default:
+            return 0;  /* Unknown shape, end of frame from silence */
+    }
+}
+
+/*
+ *  Get free space at the end of the assembler buffer
+ */
+uint8_t *frame_tail(FrameAssembler *fa, int *room)
+{
+    *room = FRAME_MAX_SIZE - fa->len;
+    return fa->buf + fa->len;
+}
+
+/*
+ *  Account for n bytes written at frame_tail()
+ */
+FrameState frame_commit(FrameAssembler *fa, int n)
+{
+    if (n < 0 || fa->len + n > FRAME_MAX_SIZE) {
+        return FRAME_ERR_OVERFLOW;
+    }
+    fa->len += n;
+
+    return fa->match ? frame_scan(fa) : frame_update(fa);
+}
+
+/*
+ *  Append received bytes
+ */
+FrameState frame_feed(FrameAssembler *fa, const uint8_t *data, int n)
+{
+    int room;
+    uint8_t *tail = frame_tail(fa, &room);
+
+    if (n > room) {
+        return FRAME_ERR_OVERFLOW;
+    }
+    memcpy(tail, data, (size_t)n);
+
+    return frame_commit(fa, n);
+}
+
+/*
+ *  Close the frame after t3.5 silence on the line
+ */
+FrameState frame_finish(FrameAssembler *fa)
+{
+    if (fa->len < FRAME_MIN_SIZE ||
+        (fa->expected > 0 && fa->len < fa->expected)) {
+        return FRAME_ERR_SHORT;
+    }
+
+    if (fa->expected == 0) {
+        fa->expected = fa->len;
+    }
+
+    return fa->crc == 0 ? FRAME_COMPLETE : FRAME_ERR_CRC;
+}
+
+/* Local functions */
+
+/*
+ *  Derive frame length and extend running CRC over new bytes
+ */
+static FrameState frame_update(FrameAssembler *fa)
+{
+    int limit;
+
+    if (fa->expected == 0) {
+        fa->expected = frame_expected_length(fa->buf, fa->len);
+        if (fa->expected > FRAME_MAX_SIZE) {
+            return FRAME_ERR_OVERFLOW;
+        }
+    }
+
+    /* Extend running CRC, never past the end of the frame */
+    limit = fa->len;
+    if (fa->expected > 0 && limit > fa->expected) {
+        limit = fa->expected;
+    }
+    if (limit > fa->crc_len) {
+        fa->crc = crc16_update(fa->crc, fa->buf + fa->crc_len,
+                               (size_t)(limit - fa->crc_len));
+        fa->crc_len = limit;
+    }
+
+    if (fa->expected > 0 && fa->len >= fa->expected) {
+        /* CRC over data and its own CRC bytes is 0 for a valid frame */
+        return fa->crc == 0 ? FRAME_COMPLETE : FRAME_ERR_CRC;
+    }
+
+    return FRAME_NEED_MORE;
+}
+
+/*
+ *  Resync mode: drop bytes until the buffer starts with the expected frame
+ */
+static FrameState frame_scan(FrameAssembler *fa)
+{
+    FrameState state;
+
+    while (fa->len > 0) {
+        if (!frame_header_matches(fa)) {
+            frame_drop(fa);
+            continue;
+        }
+
+        state = frame_update(fa);
+        if (state == FRAME_ERR_CRC || state == FRAME_ERR_OVERFLOW) {
+            frame_drop(fa);  /* Address byte was noise, try the next one */
+            continue;
+        }
+        return state;
+    }
+
+    return FRAME_NEED_MORE;
+}
+
+/*
+ *  Check the bytes received so far can start the expected response
+ */
+static int frame_header_matches(const FrameAssembler *fa)
+{
+    const uint8_t *buf = fa->buf;
+
+    if (fa->match_addr != 0 && buf[0] != fa->match_addr) {
+        return 0;
+    }
+    if (fa->len < 2) {
+        return 1;
+    }
+    if (buf[1] == (fa->match_func | FUNC_EXCEPTION_FLAG)) {
+        return 1;
+    }
+    if (buf[1] != fa->match_func) {
+        return 0;
+    }
+    if (fa->match_len > 0 && fa->len >= 3 &&
+        (buf[1] == FUNC_READ_HOLDING || buf[1] == FUNC_READ_INPUT)) {
+        return buf[2] + 5 == fa->match_len;
+    }
+
+    return 1;
+}
+
+/*
+ *  Drop the first byte and start the frame over from the next one
+ */
+static void frame_drop(FrameAssembler *fa)
+{
+    fa->len--;
+    memmove(fa->buf, fa->buf + 1, (size_t)fa->len);
+    fa->discarded++;
+    fa->expected = 0;
+    fa->crc_len = 0;
+    fa->crc = CRC16_INIT;
+}
@@ -0,0 +1,130 @@
+/*
+ *  Modbus RTU frame assembler
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Resync mode: skip noise in front of the expected response
+ *  V1.2/2026-10-16 Any address in resync mode (unsolicited frames)
+ *
+ *  Collects bytes of one RTU frame as they arrive, works out the frame
+ *  length from the function code and keeps a running CRC, so the frame
+ *  is verified as soon as its last byte is in.
+ */
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <stdint.h>  /* For uint8_t, uint16_t */
+#include "typedef.h" /* For DMAX */
+
+/* Largest frame: ADDR + FUNC + LEN + DATA(DMAX) + CRC(2) */
+#define FRAME_MAX_SIZE (DMAX + 5)
+
+/* Smallest valid frame: ADDR + FUNC + CRC(2) */
+#define FRAME_MIN_SIZE 4
+
+/**
+ * Frame assembler state returned by frame_feed() and frame_finish()
+ */
+typedef enum {
+    FRAME_NEED_MORE = 0,     /* Frame not complete yet */
+    FRAME_COMPLETE = 1,      /* Complete frame with valid CRC */
+    FRAME_ERR_CRC = -1,      /* Complete frame, CRC mismatch */
+    FRAME_ERR_OVERFLOW = -2, /* Frame longer than FRAME_MAX_SIZE */
+    FRAME_ERR_SHORT = -3     /* Line went silent before frame was complete */
+} FrameState;
+
+/**
+ * Frame assembler
+ */
+typedef struct {
+    uint8_t buf[FRAME_MAX_SIZE]; /* Received bytes */
+    int len;                     /* Number of bytes in buf */
+    int expected;                /* Total frame length, 0 while unknown */
+    int crc_len;                 /* Number of bytes covered by crc */
+    uint16_t crc;                /* Running CRC over buf[0..crc_len) */
+    int match;                   /* Resync mode: scan for the expected frame */
+    uint8_t match_addr;          /* Address of the outstanding request */
+    uint8_t match_func;          /* Function code of the outstanding request */
+    int match_len;               /* Expected response length, 0 = any */
+    int discarded;               /* Bytes dropped while resynchronizing */
+} FrameAssembler;
+
+/**
+ * Reset assembler for a new frame
+ *
+ * @param fa Pointer to assembler
+ */
+extern void frame_reset(FrameAssembler *fa);
+
+/**
+ * Enable resync mode for the response to an outstanding request
+ *
+ * Bytes that cannot start the expected response (wrong address,
+ * function code or length, or a candidate failing its CRC) are dropped
+ * one at a time, so a frame behind line noise is still found.
+ *
+ * @param fa   Pointer to assembler (after frame_reset())
+ * @param addr Address of the request (0 = any, for frames nobody asked for)
+ * @param func Function code of the request
+ * @param len  Expected response length (0 = derive from header)
+ */
+extern void frame_expect(FrameAssembler *fa, uint8_t addr, uint8_t func, int len);
+
+/**
+ * Work out the response length for a request
+ *
+ * @param req Request bytes (ADDR, FUNC, payload)
+ * @param len Number of bytes in req
+ * @return    Length of a normal response, 0 if not known
+ */
+extern int frame_response_length(const uint8_t *req, int len);
+
+/**
+ * Get free space at the end of the assembler buffer
+ *
+ * Lets the caller read() straight into the assembler and then account
+ * for the bytes with frame_commit().
+ *
+ * @param fa   Pointer to assembler
+ * @param room Pointer to store number of free bytes
+ * @return     Pointer to first free byte
+ */
+extern uint8_t *frame_tail(FrameAssembler *fa, int *room);
+
+/**
+ * Account for n bytes written at frame_tail()
+ *
+ * @param fa Pointer to assembler
+ * @param n  Number of bytes
+ * @return   Assembler state
+ */
+extern FrameState frame_commit(FrameAssembler *fa, int n);
+
+/**
+ * Append received bytes
+ *
+ * @param fa   Pointer to assembler
+ * @param data Received bytes
+ * @param n    Number of bytes
+ * @return     Assembler state
+ */
+extern FrameState frame_feed(FrameAssembler *fa, const uint8_t *data, int n);
+
+/**
+ * Close the frame after t3.5 silence on the line
+ *
+ * Used for frames whose length cannot be derived from the header.
+ *
+ * @param fa Pointer to assembler
+ * @return   FRAME_COMPLETE, FRAME_ERR_CRC or FRAME_ERR_SHORT
+ */
+extern FrameState frame_finish(FrameAssembler *fa);
+
+/**
+ * Work out total frame length from the frame header
+ *
+ * @param buf Frame bytes received so far
+ * @param len Number of bytes in buf
+ * @return    Total length, 0 if not known (yet)
+ */
+extern int frame_expected_length(const uint8_t *buf, int len);
+
+#endif /* FRAME_H */
@@ -19,20 +19,34 @@ void help(void)
 {
     static char *msg[] = {
         "-h or -?\tHelp",
-        "-p [name]\tSelect port (default: "PORT")",
+        "-p [name]\tSelect port (default: "PORT"), or a list name,name,... polled at once",
+        "\t\tname may be rtu-tcp://host[:port] (RTU over TCP) or tcp://host[:port] (Modbus TCP)",
         "-a [address]\tSelect address (default: '01H')",
-        "-b [n]\t\tSet baud rate on serial port {1200, 2400, 4800, 9600, 19200}, def. 9600",
-        "-t [time]\tTime step [s], (default 1 s)",
+        "-b [n]\t\tSet baud rate on serial port (any rate, e.g. 19200, 115200, 250000), def. 9600",
+        "-t [time]\tTime step [s], fractions or ms allowed: 0.25, 100ms (default 1 s)",
+        "-K\t\tCatch up samples missed by an overrun of -t (default: skip them)",
+        "-F [fmt]\tTimestamp format: iso (local time, default), ms or ns (since the epoch)",
         "-n [num]\tNumber of channels to read (1-8), def. 1",
-        "-c\t\tRead correction temperature [C]",
+        "-c\t\tRead temperature and correction [C]",
         "-w [address]\tWrite new device address (1..254)",
         "-x [n]\t\tSet baud rate on R4DCB08 device {0:1200, 1:2400, 2:4800, 3:9600, 4:19200}",
         "-s [ch,Tc]\tSet temperature correction Tc for channel ch",
+        "-C [Tc,...]\tSet corrections of channels 1..n in one transaction (0x10)",
         "-m\t\tEnable three point median filter",
         "-M [n]\t\tEnable MAF filter with window size n (odd, 3-15)",
         "-f\t\tEnable one shot measure without timestamp",
         "-r\t\tFactory reset (resets address to 1, baudrate to 9600, corrections to 0)",
         "-S\t\tScan RS485 bus for devices (addresses 1-254)",
+        "-A [lo-hi]\tAddress range for -S (default 1-254)",
+        "-D\t\tDetect baud rate of the device at -a, saved for the MQTT daemon",
+        "-B n\t\tPoll benchmark: n back-to-back reads (required, >= 1), report polls per second",
+        "-R\t\tResync on noisy bus: skip stray bytes in front of responses",
+        "-T [min,max]\tAdaptive response timeout [ms] from measured round trips",
+        "-L\t\tLow-latency RS485 profile (kernel RS485, low_latency, FTDI timer 1 ms)",
+        "-i [s]\t\tAutomatic report every s seconds (1-255), print pushed data; 0 = off",
+        "-I\t\tRead automatic report interval",
+        "-U\t\tio_uring I/O for reading and -B (falls back to epoll if not available)",
+        "-E [p[:cpu]]\tReal-time reading: SCHED_FIFO priority p (1-99), memory locked, pinned to cpu",
         0
     };
   
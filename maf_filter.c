@@ -4,13 +4,13 @@
  *  Weights: [0.5, 1, 1, ..., 1, 0.5]
  *  Formula: MAF = (0.5*x[0] + x[1] + ... + x[n-2] + 0.5*x[n-1]) / (n-1)
  *  V0.1/2025-01-28
+ *  V0.2/2026-10-16 binary timestamps instead of strings
  */
 
 #include <stdio.h>   /* Standard input/output definitions */
-#include <string.h>  /* String operations */
 #include <stdlib.h>  /* For NULL definition */
 
-#include "now.h"            /* Define DBUF */
+#include "now.h"            /* Timestamp */
 #include "define_error_resp.h"
 #include "maf_filter.h"
 #include "constants.h"
@@ -20,7 +20,7 @@ static int window_size = 0;          /* Current window size (0 = not initialized
 static int buffer_index = 0;         /* Current position in circular buffer */
 static int samples_count = 0;        /* Number of samples collected */
 static float val_buffer[MAF_MAX_WINDOW][MAX_CHANNELS];
-static char s_buffer[MAF_MAX_WINDOW][DBUF];
+static Timestamp s_buffer[MAF_MAX_WINDOW];
 
 /*
  *  Operator modulo to properly handle negative values:
@@ -78,8 +78,8 @@ int maf_get_window_size(void)
 /*
  * Apply trapezoidal weighted moving average filter
  */
-int maf_filter(char *sample, int nch, const float val[],
-               char *sample_filtered, float val_filtered[])
+int maf_filter(const Timestamp *sample, int nch, const float val[],
+               Timestamp *sample_filtered, float val_filtered[])
 {
     int i, m;
     int center_idx;
@@ -104,8 +104,7 @@ int maf_filter(char *sample, int nch, const float val[],
     }
 
     /* Store current sample in circular buffer */
-    strncpy(s_buffer[buffer_index], sample, DBUF - 1);
-    s_buffer[buffer_index][DBUF - 1] = '\0';
+    s_buffer[buffer_index] = *sample;
 
     for (m = 0; m < nch; m++) {
         val_buffer[buffer_index][m] = val[m];
@@ -121,8 +120,7 @@ int maf_filter(char *sample, int nch, const float val[],
     center_idx = mod(buffer_index - (window_size - 1) / 2, window_size);
 
     /* Copy timestamp from center sample */
-    strncpy(sample_filtered, s_buffer[center_idx], DBUF - 1);
-    sample_filtered[DBUF - 1] = '\0';
+    *sample_filtered = s_buffer[center_idx];
 
     /* Process each channel */
     for (m = 0; m < nch; m++) {
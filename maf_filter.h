@@ -2,11 +2,14 @@
  *  Moving Average Filter (MAF) with trapezoidal weights header
  *  Centered trapezoidal weighted moving average on odd window size
  *  V0.1/2025-01-28
+ *  V0.2/2026-10-16 binary timestamps instead of strings
  */
 
 #ifndef MAF_FILTER_H
 #define MAF_FILTER_H
 
+#include "now.h"  /* For Timestamp */
+
 /* Return codes */
 #define MAF_SUCCESS      0   /* Operation completed successfully */
 #define MAF_ERR_PARAM   -1   /* Invalid parameter (NULL pointer) */
@@ -41,7 +44,7 @@ void maf_reset(void);
  * Formula: MAF = (0.5*x[0] + x[1] + ... + x[n-2] + 0.5*x[n-1]) / (n-1)
  *
  * Parameters:
- *   sample          - Input timestamp or identifier string
+ *   sample          - Input timestamp
  *   nch             - Number of channels to process
  *   val             - Array of input values for each channel
  *   sample_filtered - Output timestamp (from the middle sample in the window)
@@ -57,8 +60,8 @@ void maf_reset(void);
  *       Call maf_init() before first use.
  *       ERRRESP values are handled specially.
  */
-int maf_filter(char *sample, int nch, const float val[],
-               char *sample_filtered, float val_filtered[]);
+int maf_filter(const Timestamp *sample, int nch, const float val[],
+               Timestamp *sample_filtered, float val_filtered[]);
 
 /**
  * Get current window size
@@ -5,14 +5,14 @@
  *  V0.1/2024-11-25 add ERRRESP
  *  V0.2/2025-03-09 enhanced safety and performance (AI)
  *  V0.3/2025-03-12 changed to return status code
+ *  V0.4/2026-10-16 binary timestamps instead of strings
  */
 
 #include <stdio.h>   /* Standard input/output definitions */
-#include <string.h>  /* String operations */
 #include <stdlib.h>  /* For NULL definition */
 #include <assert.h>  /* For assertions */
 
-#include "now.h"            /* Define DBUF */
+#include "now.h"            /* Timestamp */
 #include "define_error_resp.h"
 #include "median_filter.h"
 #include "constants.h"
@@ -29,13 +29,13 @@ static inline double median(float a, float b, float c);
 /*
  *  Apply three-point median filter
  */
-int median_filter(char *sample, int nch, const float val[], 
-                 char *sample_filtered, float val_filtered[])
+int median_filter(const Timestamp *sample, int nch, const float val[],
+                 Timestamp *sample_filtered, float val_filtered[])
 {
     /* Static state for the filter */
     static int i = 0;
     static float val_vec[MF_WINDOW_SIZE][MAX_CHANNELS];
-    static char s_vec[MF_WINDOW_SIZE][DBUF];
+    static Timestamp s_vec[MF_WINDOW_SIZE];
     static int start = 1;
     
     int j, k, m;
@@ -63,27 +63,15 @@ int median_filter(char *sample, int nch, const float val[],
             val_vec[1][m] = val[m];
             val_vec[2][m] = val[m];
         }
-        
-        /* Safe string copy with bound checking */
-        strncpy(s_vec[0], sample, DBUF-1);
-        s_vec[0][DBUF-1] = '\0';
-        
-        strncpy(s_vec[1], sample, DBUF-1);
-        s_vec[1][DBUF-1] = '\0';
-        
-        strncpy(s_vec[2], sample, DBUF-1);
-        s_vec[2][DBUF-1] = '\0';
-        
+        s_vec[0] = *sample;
+        s_vec[1] = *sample;
+        s_vec[2] = *sample;
         start = 0;
     }
     
-    /* Safe string copy for current sample */
-    strncpy(s_vec[i], sample, DBUF-1);
-    s_vec[i][DBUF-1] = '\0';
-    
-    /* Copy the timestamp from the middle sample */
-    strncpy(sample_filtered, s_vec[j], DBUF-1);
-    sample_filtered[DBUF-1] = '\0';
+    /* Current sample, timestamp of the middle sample */
+    s_vec[i] = *sample;
+    *sample_filtered = s_vec[j];
     
     /* Process each channel */
     for (m = 0; m < nch; m++) {
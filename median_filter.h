@@ -4,11 +4,14 @@
  *  V0.1/2024-11-25 add ERRRESP
  *  V0.2/2025-03-09 enhanced documentation and safety
  *  V0.3/2025-03-12 changed to return status code
+ *  V0.4/2026-10-16 binary timestamps instead of strings
  */
 
 #ifndef MEDIAN_FILTER_H
 #define MEDIAN_FILTER_H
 
+#include "now.h"  /* For Timestamp */
+
 /* Return codes */
 #define MF_SUCCESS      0   /* Operation completed successfully */
 #define MF_ERR_PARAM   -1   /* Invalid parameter */
@@ -22,7 +25,7 @@
  * trends in the data.
  *
  * Parameters:
- *   sample          - Input timestamp or identifier string
+ *   sample          - Input timestamp
  *   nch             - Number of channels to process
  *   val             - Array of input values for each channel
  *   sample_filtered - Output timestamp (from the middle sample in the window)
@@ -36,7 +39,7 @@
  * Note: This function maintains state between calls.
  *       ERRRESP values are handled specially.
  */
-extern int median_filter(char *sample, int nch, const float val[], 
-                        char *sample_filtered, float val_filtered[]);
+extern int median_filter(const Timestamp *sample, int nch, const float val[],
+                        Timestamp *sample_filtered, float val_filtered[]);
 
 #endif /* MEDIAN_FILTER_H */
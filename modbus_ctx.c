@@ -0,0 +1,420 @@
+/*
+ *  Reentrant Modbus RTU transaction context
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Pre-encoded requests sent from the wire buffer
+ *  V1.2/2026-10-16 Non-blocking request start/advance for event loops
+ *  V1.3/2026-10-16 Resync mode switch
+ *  V1.4/2026-10-16 Adaptive per-device timeouts
+ *  V1.5/2026-10-16 Quiet mode for probing
+ *  V1.6/2026-10-16 Host latency switch
+ *  V1.7/2026-10-16 Register block write with 0x10, 0x06 fallback
+ *  V1.8/2026-10-16 Shared context takes the fd-based response timeout
+ *  V1.9/2026-10-16 Requests with I/O queued by the caller (io_uring)
+ *  V1.10/2026-10-16 Sample time of the last response from the transport
+ *  V1.11/2026-10-16 Register address of write echoes checked
+ */
+#include <stdio.h>   /* Standard input/output definitions */
+#include <stdint.h>  /* Standard integer types */
+#include <string.h>  /* String functions */
+
+#include "typedef.h"    /* Data type definitions */
+#include "packet.h"     /* Packet functions declarations */
+#include "modbus_ctx.h" /* Function declarations */
+
+/*
+ *  Local function prototypes
+ */
+static void count_result(ModbusStats *stats, AppStatus status);
+static PacketRxState request_state(ModbusCtx *ctx, PacketRxState state);
+static int echoed_register(const ModbusCtx *ctx);
+
+/**********************************************************************/
+
+/*
+ *  Initialize context for an open serial port
+ */
+void modbus_ctx_init(ModbusCtx *ctx, int fd, int baud)
+{
+    memset(ctx, 0, sizeof(ModbusCtx));
+    ctx->fd = fd;
+    ctx->baudrate = baud;
+    ctx->timeout_ms = PACKET_READ_TIMEOUT_MS;
+    bus_timing_init(&ctx->own_bus, baud);
+    ctx->bus = &ctx->own_bus;
+}
+
+/*
+ *  Initialize context sharing bus timing with the fd-based API
+ */
+void modbus_ctx_init_shared(ModbusCtx *ctx, int fd)
+{
+    modbus_ctx_init(ctx, fd, 0);
+    ctx->bus = packet_default_bus();
+    ctx->timeout_ms = packet_default_timeout_ms();
+}
+
+/*
+ *  Set response timeout
+ */
+void modbus_ctx_set_timeout(ModbusCtx *ctx, int timeout_ms)
+{
+    ctx->timeout_ms = timeout_ms > 0 ? timeout_ms : PACKET_READ_TIMEOUT_MS;
+}
+
+/*
+ *  Enable or disable resync mode on the context's bus
+ */
+void modbus_ctx_set_resync(ModbusCtx *ctx, int enable)
+{
+    ctx->bus->resync = enable;
+}
+
+/*
+ *  Set the gap the host may add inside a frame on the context's bus
+ */
+void modbus_ctx_set_host_latency(ModbusCtx *ctx, long us)
+{
+    ctx->bus->host_latency_us = us > 0 ? us : PACKET_HOST_LATENCY_US;
+}
+
+/*
+ *  Enable adaptive per-device response timeouts on the context's bus
+ */
+void modbus_ctx_set_adaptive_timeout(ModbusCtx *ctx, int floor_ms, int ceiling_ms)
+{
+    if (floor_ms <= 0) {
+        ctx->bus->rtt = NULL;
+        return;
+    }
+
+    rtt_init(&ctx->rtt, floor_ms, ceiling_ms);
+    ctx->bus->rtt = &ctx->rtt;
+}
+
+/*
+ *  Send an instruction to the device and receive the response
+ */
+AppStatus modbus_transaction(ModbusCtx *ctx, uint8_t adr, uint8_t inst,
+                             int in_len, const uint8_t *arg, PACKET *p_r,
+                             int verb, const char *msg, int mode,
+                             uint8_t **data_out)
+{
+    const char *function_name = "monada";
+
+    /* Validate parameters */
+    if (ctx == NULL || mode < 0 || mode >= RECEIVE_MODE_MAX) {
+        fprintf(stderr, "%s: Invalid parameter(s)\n", function_name);
+        return ERROR_INVALID_ADDRESS; /* Use existing AppStatus error */
+    }
+
+    /* Validate input data length */
+    if (in_len > DMAX || in_len < 0) {
+        fprintf(stderr, "%s: Input data too long (%d > %d)\n", function_name, in_len, DMAX);
+        ctx->stats.other_errors++;
+        return ERROR_PACKET_OVERFLOW;
+    }
+
+    /* Encode request straight into the wire buffer */
+    packet_encode(&ctx->tx_wire, adr, inst, arg, in_len);
+
+    return modbus_request(ctx, &ctx->tx_wire, p_r, verb, msg, data_out);
+}
+
+/*
+ *  Send a pre-encoded request and receive the response
+ */
+AppStatus modbus_request(ModbusCtx *ctx, const WireFrame *req, PACKET *p_r,
+                         int verb, const char *msg, uint8_t **data_out)
+{
+    AppStatus result;
+    const char *function_name = "monada";
+
+    /* Validate parameters */
+    if (ctx == NULL || req == NULL || p_r == NULL || msg == NULL || ctx->fd < 0) {
+        fprintf(stderr, "%s: Invalid parameter(s)\n", function_name);
+        return ERROR_INVALID_ADDRESS; /* Use existing AppStatus error */
+    }
+
+    #ifdef DEBUG
+        printf("%s: Send packet:\n", function_name);
+        for (int i = 0; i < req->len; i++) {
+            printf("%02X ", req->buf[i]);
+        }
+        printf("\n");
+    #endif
+
+    /* Send request */
+    ctx->stats.transactions++;
+    result = packet_send_wire(ctx->fd, ctx->bus, req);
+    if (result != STATUS_OK) {
+        if (!ctx->quiet) fprintf(stderr, "%s: In %s - send error!\n", function_name, msg);
+        ctx->stats.other_errors++;
+        return result;
+    }
+
+    /* Receive response */
+    result = packet_receive(ctx->fd, ctx->bus, &ctx->rx, &ctx->rx_packet,
+                            ctx->timeout_ms, ctx->quiet);
+    count_result(&ctx->stats, result);
+    if (result != STATUS_OK) {
+        if (!ctx->quiet) fprintf(stderr, "%s: In %s - receive error!\n", function_name, msg);
+        return result;
+    }
+
+    #ifdef DEBUG
+        printf("%s: Received packet:\n", function_name);
+        print_packet(&ctx->rx_packet);
+    #endif
+
+    /* Print success message if verbose mode is on */
+    if (verb) {
+        printf("%s ... OK\n", msg);
+    }
+
+    /* Copy received packet to output parameter */
+    *p_r = ctx->rx_packet;
+
+    /* Store data pointer if requested */
+    if (data_out != NULL) {
+        *data_out = ctx->rx_packet.data;
+    }
+
+    return STATUS_OK;
+}
+
+/*
+ *  Write a block of registers in one transaction, one by one if rejected
+ */
+AppStatus modbus_write_registers(ModbusCtx *ctx, uint8_t adr, uint16_t reg,
+                                 uint16_t count, const uint16_t *values,
+                                 const char *msg, int *single)
+{
+    PACKET pr;
+    uint8_t arg[4];
+    int quiet, i;
+    AppStatus result;
+
+    if (single != NULL) {
+        *single = 0;
+    }
+
+    result = packet_encode_write_multiple(&ctx->tx_wire, adr, reg, count, values);
+    if (result != STATUS_OK) {
+        ctx->stats.other_errors++;
+        return result;
+    }
+
+    /* A device without 0x10 answers with an exception or not at all */
+    quiet = ctx->quiet;
+    ctx->quiet = 1;
+    result = modbus_request(ctx, &ctx->tx_wire, &pr, 0, msg, NULL);
+    ctx->quiet = quiet;
+
+    if (result == STATUS_OK) {
+        /* Echo of register and count, count in the data */
+        if (echoed_register(ctx) != reg || UINT16(pr.data[1], pr.data[0]) != count) {
+            if (!ctx->quiet) fprintf(stderr, "monada: In %s - wrong echo!\n", msg);
+            return ERROR_RECEIVE_PACKET;
+        }
+        return STATUS_OK;
+    }
+    if (result != ERROR_PACKET_EXCEPTION && result != ERROR_PACKET_TIMEOUT) {
+        return result;
+    }
+
+    /* Write Single Register (0x06) per register, stop at the first failure */
+    if (single != NULL) {
+        *single = 1;
+    }
+    for (i = 0; i < count; i++) {
+        arg[0] = (uint8_t)((reg + i) >> 8);
+        arg[1] = (uint8_t)((reg + i) & 0xFF);
+        arg[2] = (uint8_t)(values[i] >> 8);
+        arg[3] = (uint8_t)(values[i] & 0xFF);
+
+        result = modbus_transaction(ctx, adr, 0x06, 4, arg, &pr, 0, msg,
+                                    RECEIVE_MODE_ACKNOWLEDGE, NULL);
+        if (result != STATUS_OK) {
+            return result;
+        }
+        if (echoed_register(ctx) != reg + i || UINT16(pr.data[1], pr.data[0]) != values[i]) {
+            if (!ctx->quiet) fprintf(stderr, "monada: In %s - wrong echo!\n", msg);
+            return ERROR_RECEIVE_PACKET;
+        }
+    }
+
+    return STATUS_OK;
+}
+
+/*
+ *  Send a pre-encoded request and start receiving without blocking
+ */
+AppStatus modbus_request_start(ModbusCtx *ctx, const WireFrame *req)
+{
+    AppStatus result;
+
+    if (ctx == NULL || req == NULL || ctx->fd < 0) {
+        return ERROR_INVALID_ADDRESS; /* Use existing AppStatus error */
+    }
+
+    ctx->stats.transactions++;
+    result = packet_send_wire(ctx->fd, ctx->bus, req);
+    if (result != STATUS_OK) {
+        ctx->stats.other_errors++;
+        ctx->pending = 0;
+        return result;
+    }
+
+    packet_rx_start(&ctx->rx, ctx->fd, ctx->bus, ctx->timeout_ms);
+    ctx->pending = 1;
+
+    return STATUS_OK;
+}
+
+/*
+ *  Start a request whose write and reads the caller queues itself
+ */
+AppStatus modbus_request_queue(ModbusCtx *ctx, const WireFrame *req, long delay_us)
+{
+    AppStatus result;
+
+    if (ctx == NULL || req == NULL || ctx->fd < 0) {
+        return ERROR_INVALID_ADDRESS;
+    }
+
+    ctx->stats.transactions++;
+    result = packet_send_queued(ctx->bus, req, delay_us);
+    if (result != STATUS_OK) {
+        ctx->stats.other_errors++;
+        ctx->pending = 0;
+        return result;
+    }
+
+    packet_rx_start(&ctx->rx, ctx->fd, ctx->bus, ctx->timeout_ms);
+    packet_rx_delay(&ctx->rx, delay_us);
+    ctx->pending = 1;
+
+    return STATUS_OK;
+}
+
+/*
+ *  Advance a request started with modbus_request_start()
+ */
+PacketRxState modbus_request_advance(ModbusCtx *ctx, int readable)
+{
+    return request_state(ctx, packet_rx_advance(&ctx->rx, readable));
+}
+
+/*
+ *  Advance a request with bytes the caller read into the receiver
+ */
+PacketRxState modbus_request_commit(ModbusCtx *ctx, int result)
+{
+    return request_state(ctx, packet_rx_commit(&ctx->rx, result));
+}
+
+/*
+ *  Get the response of a finished request
+ */
+AppStatus modbus_request_result(ModbusCtx *ctx, PACKET *p_r, uint8_t **data_out)
+{
+    AppStatus result = packet_rx_packet(&ctx->rx, &ctx->rx_packet);
+
+    if (result != STATUS_OK) {
+        return result;
+    }
+
+    if (p_r != NULL) {
+        *p_r = ctx->rx_packet;
+    }
+    if (data_out != NULL) {
+        *data_out = ctx->rx_packet.data;
+    }
+
+    return STATUS_OK;
+}
+
+/*
+ *  Get the time of the last response
+ */
+void modbus_request_time(const ModbusCtx *ctx, Timestamp *ts)
+{
+    const PacketReceiver *rx = &ctx->rx;
+    int64_t sent_ns = (int64_t)rx->sent.tv_sec * 1000000000 + rx->sent.tv_nsec;
+
+    if (rx->last_byte.tv_sec == 0 && rx->last_byte.tv_nsec == 0) {
+        timestamp_now(ts);  /* Nothing received, time of the failure */
+        ts->sent_ns = sent_ns;
+        return;
+    }
+
+    timestamp_at(ts, (int64_t)rx->last_byte.tv_sec * 1000000000 + rx->last_byte.tv_nsec,
+                 sent_ns);
+}
+
+/*
+ *  Get file descriptor to wait on
+ */
+int modbus_ctx_fd(const ModbusCtx *ctx)
+{
+    return ctx->fd;
+}
+
+/*
+ *  Get milliseconds until the deadline of the request in progress
+ */
+int modbus_ctx_wait_ms(const ModbusCtx *ctx)
+{
+    return ctx->pending ? packet_rx_wait_ms(&ctx->rx) : -1;
+}
+
+/* Local functions */
+
+/*
+ *  Update statistics with the result of one receive
+ */
+static void count_result(ModbusStats *stats, AppStatus status)
+{
+    switch (status) {
+        case STATUS_OK:
+            stats->responses++;
+            break;
+        case ERROR_PACKET_TIMEOUT:
+            stats->timeouts++;
+            break;
+        case ERROR_PACKET_CRC:
+            stats->crc_errors++;
+            break;
+        case ERROR_PACKET_EXCEPTION:
+            stats->exceptions++;
+            break;
+        default:
+            stats->other_errors++;
+            break;
+    }
+}
+
+/*
+ *  Count the result of a non-blocking request once it is finished
+ */
+static PacketRxState request_state(ModbusCtx *ctx, PacketRxState state)
+{
+    if (state != PACKET_RX_NEED_MORE && ctx->pending) {
+        ctx->pending = 0;
+        count_result(&ctx->stats, packet_rx_packet(&ctx->rx, &ctx->rx_packet));
+    }
+
+    return state;
+}
+
+/*
+ *  Register address echoed by the last 0x06/0x10 response, -1 if none
+ */
+static int echoed_register(const ModbusCtx *ctx)
+{
+    const uint8_t *frame;
+    int len;
+
+    frame = packet_rx_frame(&ctx->rx, &len);
+    return len >= 8 ? (frame[2] << 8) | frame[3] : -1;
+}
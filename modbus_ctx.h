@@ -0,0 +1,262 @@
+/*
+ *  Reentrant Modbus RTU transaction context
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Pre-encoded requests sent from the wire buffer
+ *  V1.2/2026-10-16 Non-blocking request start/advance for event loops
+ *  V1.3/2026-10-16 Resync mode switch
+ *  V1.4/2026-10-16 Adaptive per-device timeouts
+ *  V1.5/2026-10-16 Quiet mode for probing
+ *  V1.6/2026-10-16 Host latency switch
+ *  V1.7/2026-10-16 Register block write with 0x10, 0x06 fallback
+ *  V1.8/2026-10-16 Requests with I/O queued by the caller (io_uring)
+ *  V1.9/2026-10-16 Sample time of the last response from the transport
+ *
+ *  One context per serial port. The context owns the port descriptor,
+ *  the send/receive buffers, the bus timing and the statistics, so
+ *  several ports can be polled from several threads at once.
+ */
+#ifndef MODBUS_CTX_H
+#define MODBUS_CTX_H
+
+#include <stdint.h>  /* For uint8_t */
+#include "typedef.h" /* For PACKET definition */
+#include "error.h"   /* For AppStatus */
+#include "packet.h"  /* For BusTiming */
+#include "frame.h"   /* For FrameAssembler */
+#include "now.h"     /* For Timestamp */
+
+/**
+ * Transaction statistics
+ */
+typedef struct {
+    unsigned long transactions; /* Requests sent */
+    unsigned long responses;    /* Valid responses received */
+    unsigned long timeouts;     /* No or incomplete response */
+    unsigned long crc_errors;   /* Responses with CRC mismatch */
+    unsigned long exceptions;   /* Modbus exception responses */
+    unsigned long other_errors; /* Send errors, invalid parameters, ... */
+} ModbusStats;
+
+/**
+ * Modbus transaction context
+ */
+typedef struct {
+    int fd;                   /* File descriptor of the serial port */
+    int baudrate;             /* Baud rate of the serial port */
+    int timeout_ms;           /* Response timeout */
+    int quiet;                /* 1 = no error messages (bus probing) */
+    BusTiming *bus;           /* Bus timing in use (own_bus or shared) */
+    BusTiming own_bus;        /* Bus timing owned by this context */
+    RttTable rtt;             /* Round-trip statistics per device address */
+    WireFrame tx_wire;        /* Last request as sent */
+    PACKET rx_packet;         /* Last response */
+    PacketReceiver rx;        /* Response receiver */
+    int pending;              /* Non-blocking request in progress */
+    ModbusStats stats;        /* Transaction statistics */
+} ModbusCtx;
+
+/**
+ * Initialize context for an open serial port
+ *
+ * @param ctx  Pointer to context
+ * @param fd   File descriptor of the serial port (already configured)
+ * @param baud Baud rate of the serial port
+ */
+extern void modbus_ctx_init(ModbusCtx *ctx, int fd, int baud);
+
+/**
+ * Initialize context sharing bus timing with the fd-based API
+ *
+ * For code that mixes the context with send_packet()/received_packet()
+ * on the same port in the same thread. The response timeout is the one
+ * set by packet_set_timeout().
+ *
+ * @param ctx  Pointer to context
+ * @param fd   File descriptor of the serial port (already configured)
+ */
+extern void modbus_ctx_init_shared(ModbusCtx *ctx, int fd);
+
+/**
+ * Set response timeout
+ *
+ * @param ctx        Pointer to context
+ * @param timeout_ms Timeout in milliseconds (<= 0 restores the default)
+ */
+extern void modbus_ctx_set_timeout(ModbusCtx *ctx, int timeout_ms);
+
+/**
+ * Enable or disable resync mode on the context's bus
+ *
+ * @param ctx    Pointer to context
+ * @param enable Non-zero to skip noise in front of responses
+ */
+extern void modbus_ctx_set_resync(ModbusCtx *ctx, int enable);
+
+/**
+ * Set the gap the host may add inside a frame on the context's bus
+ *
+ * @param ctx Pointer to context
+ * @param us  Host latency in microseconds (<= 0 = PACKET_HOST_LATENCY_US)
+ */
+extern void modbus_ctx_set_host_latency(ModbusCtx *ctx, long us);
+
+/**
+ * Enable adaptive per-device response timeouts on the context's bus
+ *
+ * The timeout set by modbus_ctx_set_timeout() is then only used until a
+ * device has answered for the first time.
+ *
+ * @param ctx        Pointer to context
+ * @param floor_ms   Lowest timeout in milliseconds (0 disables)
+ * @param ceiling_ms Highest timeout in milliseconds
+ */
+extern void modbus_ctx_set_adaptive_timeout(ModbusCtx *ctx, int floor_ms, int ceiling_ms);
+
+/**
+ * Send an instruction to the device and receive the response
+ *
+ * Same contract as monada(), with all state kept in ctx. The pointer
+ * stored to data_out points into ctx and stays valid until the next
+ * transaction on the same context.
+ *
+ * @param ctx      Pointer to context
+ * @param adr      Device address
+ * @param inst     Instruction code
+ * @param in_len   Length of input data
+ * @param arg      Pointer to input data buffer (can be NULL for zero-length data)
+ * @param p_r      Pointer to PACKET structure to store the received packet
+ * @param verb     Verbosity flag: 1 = print "OK" message, 0 = silent
+ * @param msg      Operation name for debugging messages
+ * @param mode     Receive mode (RECEIVE_MODE_TEMPERATURE or RECEIVE_MODE_ACKNOWLEDGE)
+ * @param data_out Pointer to store received data pointer (optional, can be NULL)
+ *
+ * @return         STATUS_OK on success, AppStatus error code on failure
+ */
+extern AppStatus modbus_transaction(ModbusCtx *ctx, uint8_t adr, uint8_t inst,
+                                    int in_len, const uint8_t *arg, PACKET *p_r,
+                                    int verb, const char *msg, int mode,
+                                    uint8_t **data_out);
+
+/**
+ * Send a pre-encoded request and receive the response
+ *
+ * The request is written straight from its wire buffer, so a request
+ * encoded once with packet_encode*() can be reused for every poll.
+ *
+ * @param ctx      Pointer to context
+ * @param req      Encoded request
+ * @param p_r      Pointer to PACKET structure to store the received packet
+ * @param verb     Verbosity flag: 1 = print "OK" message, 0 = silent
+ * @param msg      Operation name for debugging messages
+ * @param data_out Pointer to store received data pointer (optional, can be NULL)
+ *
+ * @return         STATUS_OK on success, AppStatus error code on failure
+ */
+extern AppStatus modbus_request(ModbusCtx *ctx, const WireFrame *req, PACKET *p_r,
+                                int verb, const char *msg, uint8_t **data_out);
+
+/**
+ * Write a block of registers in one transaction
+ *
+ * Sends Write Multiple Registers (0x10) and checks the echo. A device
+ * that answers with an exception or not at all gets one Write Single
+ * Register (0x06) per register instead, up to the first failure.
+ *
+ * @param ctx    Pointer to context
+ * @param adr    Device address
+ * @param reg    First register
+ * @param count  Number of registers (1..PACKET_WRITE_MAX)
+ * @param values Register values
+ * @param msg    Operation name for error messages
+ * @param single Set to 1 if the 0x06 fallback was used (can be NULL)
+ * @return       STATUS_OK on success, AppStatus error code on failure
+ */
+extern AppStatus modbus_write_registers(ModbusCtx *ctx, uint8_t adr, uint16_t reg,
+                                        uint16_t count, const uint16_t *values,
+                                        const char *msg, int *single);
+
+/**
+ * Send a pre-encoded request and start receiving without blocking
+ *
+ * Wait for modbus_ctx_fd() to become readable or for the deadline from
+ * modbus_ctx_wait_ms(), then call modbus_request_advance().
+ *
+ * @param ctx Pointer to context
+ * @param req Encoded request
+ * @return    STATUS_OK if the request went out, AppStatus error code otherwise
+ */
+extern AppStatus modbus_request_start(ModbusCtx *ctx, const WireFrame *req);
+
+/**
+ * Advance a request started with modbus_request_start()
+ *
+ * @param ctx      Pointer to context
+ * @param readable Non-zero if the fd was reported readable
+ * @return         PACKET_RX_NEED_MORE, PACKET_RX_COMPLETE or PACKET_RX_ERROR
+ */
+extern PacketRxState modbus_request_advance(ModbusCtx *ctx, int readable);
+
+/**
+ * Start a request whose write and reads the caller queues itself
+ *
+ * For an io_uring event loop: the request is booked as sent and the
+ * receiver started. The caller then writes req delay_us from now and
+ * reads into packet_rx_buffer(&ctx->rx, ...), passing each result to
+ * modbus_request_commit(), and calls modbus_request_advance() with
+ * readable == 0 once the deadline has passed.
+ *
+ * @param ctx      Pointer to context
+ * @param req      Encoded request
+ * @param delay_us Time until the write goes out (rest of the t3.5 gap)
+ * @return         STATUS_OK, AppStatus error code for an invalid request
+ */
+extern AppStatus modbus_request_queue(ModbusCtx *ctx, const WireFrame *req, long delay_us);
+
+/**
+ * Advance a request with a read the caller did into the receiver
+ *
+ * @param ctx    Pointer to context
+ * @param result Bytes read, negative errno on failure
+ * @return       PACKET_RX_NEED_MORE, PACKET_RX_COMPLETE or PACKET_RX_ERROR
+ */
+extern PacketRxState modbus_request_commit(ModbusCtx *ctx, int result);
+
+/**
+ * Get the response of a finished request
+ *
+ * @param ctx      Pointer to context
+ * @param p_r      Pointer to PACKET structure to store the received packet
+ * @param data_out Pointer to store received data pointer (optional, can be NULL)
+ * @return         STATUS_OK on success, AppStatus error code on failure
+ */
+extern AppStatus modbus_request_result(ModbusCtx *ctx, PACKET *p_r, uint8_t **data_out);
+
+/**
+ * Get the time of the last response
+ *
+ * Taken by the receiver when the request was written and when the last
+ * byte of the response was read, not when the caller got to the result.
+ * Without any response byte the sample time is the time of the call.
+ *
+ * @param ctx Pointer to context
+ * @param ts  Pointer to store the sample time
+ */
+extern void modbus_request_time(const ModbusCtx *ctx, Timestamp *ts);
+
+/**
+ * Get file descriptor to wait on
+ *
+ * @param ctx Pointer to context
+ * @return    File descriptor of the serial port
+ */
+extern int modbus_ctx_fd(const ModbusCtx *ctx);
+
+/**
+ * Get milliseconds until the deadline of the request in progress
+ *
+ * @param ctx Pointer to context
+ * @return    Timeout for poll()/epoll_wait(), -1 if no request is in progress
+ */
+extern int modbus_ctx_wait_ms(const ModbusCtx *ctx);
+
+#endif /* MODBUS_CTX_H */
@@ -5,6 +5,8 @@
  *  V1.2/2019-10-30  Autonomous file
  *  V1.3/2019-10-31  Add p_r (pointer to received packet) and verb as parameter
  *  V1.4/2025-04-16  Improved error handling and robustness
+ *  V1.5/2026-10-16  Thin wrapper around modbus_transaction()
+ *  V1.6/2026-10-16  Register block write (0x10 with 0x06 fallback)
  */
 
 #include <stdlib.h>  /* Standard lib */
@@ -12,10 +14,17 @@
 #include <stdint.h>  /* Standard integer types */
 #include <string.h>  /* String functions */
 
-#include "typedef.h"  /* Data type definitions */
-#include "packet.h"   /* Packet functions declarations */
-#include "monada.h"   /* Function declarations */
+#include "typedef.h"    /* Data type definitions */
+#include "packet.h"     /* Packet functions declarations */
+#include "modbus_ctx.h" /* Transaction context */
+#include "monada.h"     /* Function declarations */
 
+/*
+ *  Local function prototypes
+ */
+static ModbusCtx *monada_ctx(int fd);
+
+/**********************************************************************/
 
 /*
  *  Send an instruction to the device and receive the response
@@ -24,75 +33,40 @@ AppStatus monada(int fd, uint8_t adr, uint8_t inst, int in_len,
                 uint8_t *arg, PACKET *p_r, int verb, 
                 const char *msg, int mode, uint8_t **data_out)
 {
-    static uint8_t data[DMAX];  /* Array for data (not thread-safe) */
-    uint8_t *p_data = data;     /* Pointer to data array */
-    static PACKET tx_packet;    /* Send packet */
-    static PACKET rx_packet;    /* Received packet */
-    PACKET *p_tx = &tx_packet;  /* Pointer to send packet */
-    PACKET *p_rx = &rx_packet;  /* Pointer to received packet */
-    int i, result;
-    const char *function_name = "monada";
+    return modbus_transaction(monada_ctx(fd), adr, inst, in_len, arg, p_r, verb,
+                              msg, mode, data_out);
+}
 
-    /* Validate parameters */
-    if (p_r == NULL || msg == NULL || fd < 0 || 
-        mode < 0 || mode >= RECEIVE_MODE_MAX) {
-        fprintf(stderr, "%s: Invalid parameter(s)\n", function_name);
-        return ERROR_INVALID_ADDRESS; /* Use existing AppStatus error */
-    }
+/*
+ *  Write a block of registers in one transaction, one by one if rejected
+ */
+AppStatus monada_write_registers(int fd, uint8_t adr, uint16_t reg, uint16_t count,
+                                 const uint16_t *values, int verb, const char *msg,
+                                 int *single)
+{
+    AppStatus status;
 
-    /* Validate input data length */
-    if (in_len > DMAX || in_len < 0) {
-        fprintf(stderr, "%s: Input data too long (%d > %d)\n", function_name, in_len, DMAX);
-        return ERROR_PACKET_OVERFLOW;
-    }
-    
-    /* Copy input data to local buffer */
-    if (arg != NULL && in_len > 0) {
-        for (i = 0; i < in_len; i++) {
-            data[i] = *(arg++);  /* Using the original style of copying */
-        }
+    status = modbus_write_registers(monada_ctx(fd), adr, reg, count, values, msg, single);
+    if (status == STATUS_OK && verb) {
+        printf("%s ... OK\n", msg);
     }
 
-    /* Form packet to send */
-    form_packet(adr, inst, p_data, in_len, p_tx);
- 
-    #ifdef DEBUG
-        printf("%s: Send packet:\n", function_name);
-        print_packet(p_tx);
-    #endif
+    return status;
+}
 
-    /* Send packet */
-    result = send_packet(fd, p_tx, NULL);
-    if (result != STATUS_OK) {
-        fprintf(stderr, "%s: In %s - send error!\n", function_name, msg);
-        return result; /* Return the actual AppStatus error */
-    }
+/* Local functions */
 
-    /* Receive response */
-    result = received_packet(fd, p_rx, mode);
-    if (result != STATUS_OK) {
-        fprintf(stderr, "%s: In %s - receive error (mode %d)!\n", 
-                function_name, msg, mode);
-        return result; /* Return the actual AppStatus error */
-    }
-
-    #ifdef DEBUG
-        printf("%s: Received packet:\n", function_name);
-        print_packet(p_rx);
-    #endif 
+/*
+ *  Context of the calling thread for fd
+ */
+static ModbusCtx *monada_ctx(int fd)
+{
+    static _Thread_local ModbusCtx ctx = { .fd = -1 };  /* One per thread */
 
-    /* Print success message if verbose mode is on */
-    if (verb) {
-        printf("%s ... OK\n", msg);
+    /* Context follows the fd; timing is shared with the fd-based API */
+    if (ctx.fd != fd) {
+        modbus_ctx_init_shared(&ctx, fd);
     }
 
-    /* Copy received packet to output parameter */
-    *p_r = rx_packet;
-    
-    /* Store data pointer if requested */
-    if (data_out != NULL) {
-        *data_out = p_rx->data;
-    }
-    
-    return STATUS_OK;
+    return &ctx;
 }
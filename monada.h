@@ -1,6 +1,7 @@
 /*
  *  Wrapper function for device communication
  *  V1.4/2025-04-16
+ *  V1.6/2026-10-16  Register block write
  */
 #ifndef MONADA_H
 #define MONADA_H
@@ -34,5 +35,25 @@ extern AppStatus monada(int fd, uint8_t adr, uint8_t inst, int in_len,
                        uint8_t *arg, PACKET *p_r, int verb, 
                        const char *msg, int mode, uint8_t **data_out);
 
+/**
+ * Write a block of registers in one transaction
+ *
+ * Write Multiple Registers (0x10); a device that rejects it gets one
+ * Write Single Register (0x06) per register instead.
+ *
+ * @param fd      File descriptor of the serial port
+ * @param adr     Device address
+ * @param reg     First register
+ * @param count   Number of registers
+ * @param values  Register values
+ * @param verb    Verbosity flag: 1 = print "OK" message, 0 = silent
+ * @param msg     Operation name for debugging messages
+ * @param single  Set to 1 if the 0x06 fallback was used (can be NULL)
+ *
+ * @return        STATUS_OK on success, AppStatus error code on failure
+ */
+extern AppStatus monada_write_registers(int fd, uint8_t adr, uint16_t reg, uint16_t count,
+                                        const uint16_t *values, int verb, const char *msg,
+                                        int *single);
 
 #endif /* MONADA_H */
@@ -1,6 +1,20 @@
 /*
  * MQTT daemon configuration
  * V1.1/2026-01-29
+ * V1.2/2026-10-16 Resync option
+ * V1.3/2026-10-16 Adaptive timeout options
+ * V1.4/2026-10-16 Several serial ports
+ * V1.5/2026-10-16 Any baud rate
+ * V1.6/2026-10-16 Low-latency RS485 profile option
+ * V1.7/2026-10-16 Baud rate detection (auto)
+ * V1.8/2026-10-16 Device list for the bus scheduler
+ * V1.9/2026-10-16 Temperature corrections written at startup
+ * V1.10/2026-10-16 Automatic report (push) mode
+ * V1.11/2026-10-16 Serial bus broker for local clients
+ * V1.12/2026-10-16 Network ports (rtu-tcp://, tcp://)
+ * V1.13/2026-10-16 io_uring backend option
+ * V1.14/2026-10-16 Timestamp format option
+ * V1.15/2026-10-16 Real-time polling thread option
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,6 +27,10 @@
 #include "mqtt_config.h"
 #include "mqtt_error.h"
 #include "mqtt_revision.h"
+#include "../serial.h"
+#include "../constants.h"
+#include "../broker.h"
+#include "../transport.h"
 
 /* Long options for getopt */
 static struct option long_options[] = {
@@ -39,6 +57,17 @@ static struct option long_options[] = {
     {"tls-key",       required_argument, 0, 1003},
     {"tls-insecure",  no_argument,       0, 1004},
     {"diagnostics-interval", required_argument, 0, 'D'},
+    {"resync",        no_argument,       0, 1005},
+    {"timeout",       required_argument, 0, 1006},
+    {"low-latency",   no_argument,       0, 1007},
+    {"devices",       required_argument, 0, 1008},
+    {"corrections",   required_argument, 0, 1009},
+    {"auto-report",   no_argument,       0, 1010},
+    {"broker",        no_argument,       0, 1011},
+    {"broker-dir",    required_argument, 0, 1012},
+    {"io-uring",      no_argument,       0, 1013},
+    {"time-format",   required_argument, 0, 1014},
+    {"realtime",      required_argument, 0, 1015},
     {"help",          no_argument,       0, 'h'},
     {"version",       no_argument,       0, 'V'},
     {0, 0, 0, 0}
@@ -112,6 +141,16 @@ void mqtt_config_init(MqttConfig *config)
     config->daemon_mode = 0;
     config->verbose = 0;
 
+    /* Serial defaults */
+    config->resync = 0;
+    config->low_latency = 0;
+    config->auto_report = 0;
+    config->broker = 0;
+    config->broker_dir[0] = '\0';
+    config->io_uring = 0;
+    config->timeout_min = 0;
+    config->timeout_max = 500;
+
     /* Filter defaults */
     config->enable_median_filter = 0;
     config->enable_maf_filter = 0;
@@ -123,6 +162,9 @@ void mqtt_config_init(MqttConfig *config)
 
     /* Default PID file */
     strncpy(config->pid_file, "/var/run/r4dcb08-mqtt.pid", MQTT_MAX_PATH - 1);
+    config->time_format = TS_ISO;
+    config->realtime.priority = 0;
+    config->realtime.cpu = -1;
 
     /* Diagnostics defaults */
     config->diagnostics_interval = MQTT_DEFAULT_DIAGNOSTICS_INTERVAL;
@@ -218,9 +260,15 @@ MqttStatus mqtt_config_parse_file(const char *filename, MqttConfig *config)
                 mqtt_log_warning("Config line %d: invalid address '%s'", line_num, value);
             }
         } else if (strcmp(key, "baudrate") == 0) {
-            if (mqtt_config_parse_int(value, &config->baudrate, 1200, 115200) != 0) {
+            if (strcmp(value, "auto") == 0) {
+                config->baudrate = MQTT_BAUD_AUTO;
+            } else if (mqtt_config_parse_int(value, &config->baudrate, SERIAL_BAUD_MIN, SERIAL_BAUD_MAX) != 0) {
                 mqtt_log_warning("Config line %d: invalid baudrate '%s'", line_num, value);
             }
+        } else if (strcmp(key, "devices") == 0) {
+            strncpy(config->devices, value, MQTT_MAX_DEVICE_LIST - 1);
+        } else if (strcmp(key, "corrections") == 0) {
+            strncpy(config->corrections, value, MQTT_MAX_CORRECTION_LIST - 1);
         } else if (strcmp(key, "channels") == 0 || strcmp(key, "num_channels") == 0) {
             if (mqtt_config_parse_int(value, &config->num_channels, 1, 8) != 0) {
                 mqtt_log_warning("Config line %d: invalid channels '%s'", line_num, value);
@@ -255,12 +303,42 @@ MqttStatus mqtt_config_parse_file(const char *filename, MqttConfig *config)
             if (mqtt_config_parse_int(value, &config->keepalive, 1, 3600) != 0) {
                 mqtt_log_warning("Config line %d: invalid keepalive '%s'", line_num, value);
             }
+        } else if (strcmp(key, "resync") == 0) {
+            config->resync = PARSE_BOOL(value);
+        } else if (strcmp(key, "low_latency") == 0) {
+            config->low_latency = PARSE_BOOL(value);
+        } else if (strcmp(key, "auto_report") == 0) {
+            config->auto_report = PARSE_BOOL(value);
+        } else if (strcmp(key, "broker") == 0) {
+            config->broker = PARSE_BOOL(value);
+        } else if (strcmp(key, "broker_dir") == 0) {
+            strncpy(config->broker_dir, value, MQTT_MAX_PATH - 1);
+        } else if (strcmp(key, "io_uring") == 0) {
+            config->io_uring = PARSE_BOOL(value);
+        } else if (strcmp(key, "timeout_min") == 0) {
+            if (mqtt_config_parse_int(value, &config->timeout_min, 0, 10000) != 0) {
+                mqtt_log_warning("Config line %d: invalid timeout_min '%s'", line_num, value);
+            }
+        } else if (strcmp(key, "timeout_max") == 0) {
+            if (mqtt_config_parse_int(value, &config->timeout_max, 1, 10000) != 0) {
+                mqtt_log_warning("Config line %d: invalid timeout_max '%s'", line_num, value);
+            }
         } else if (strcmp(key, "interval") == 0) {
             if (mqtt_config_parse_int(value, &config->interval, 1, 86400) != 0) {
                 mqtt_log_warning("Config line %d: invalid interval '%s'", line_num, value);
             }
         } else if (strcmp(key, "pid_file") == 0) {
             strncpy(config->pid_file, value, MQTT_MAX_PATH - 1);
+        } else if (strcmp(key, "time_format") == 0) {
+            if (timestamp_parse_format(value, &config->time_format) != 0) {
+                mqtt_log_warning("Config line %d: invalid time_format '%s'", line_num, value);
+            }
+        } else if (strcmp(key, "realtime") == 0) {
+            if (value[0] == '\0') {
+                config->realtime.priority = 0;  /* Empty: off */
+            } else if (realtime_parse(value, &config->realtime) != 0) {
+                mqtt_log_warning("Config line %d: invalid realtime '%s'", line_num, value);
+            }
         } else if (strcmp(key, "median_filter") == 0) {
             config->enable_median_filter = PARSE_BOOL(value);
         } else if (strcmp(key, "maf_filter") == 0) {
@@ -325,7 +403,9 @@ MqttStatus mqtt_config_parse_args(int argc, char *argv[], MqttConfig *config)
                 }
                 break;
             case 'b':
-                if (mqtt_config_parse_int(optarg, &config->baudrate, 1200, 115200) != 0) {
+                if (strcmp(optarg, "auto") == 0) {
+                    config->baudrate = MQTT_BAUD_AUTO;
+                } else if (mqtt_config_parse_int(optarg, &config->baudrate, SERIAL_BAUD_MIN, SERIAL_BAUD_MAX) != 0) {
                     fprintf(stderr, "Error: invalid baudrate '%s'\n", optarg);
                     return MQTT_ERR_CONFIG_VALUE;
                 }
@@ -407,6 +487,51 @@ MqttStatus mqtt_config_parse_args(int argc, char *argv[], MqttConfig *config)
             case 1004:  /* --tls-insecure */
                 config->tls_insecure = 1;
                 break;
+            case 1005:  /* --resync */
+                config->resync = 1;
+                break;
+            case 1006:  /* --timeout */
+                if (sscanf(optarg, "%d,%d", &config->timeout_min, &config->timeout_max) != 2 ||
+                    config->timeout_min < 1 || config->timeout_max < config->timeout_min) {
+                    fprintf(stderr, "Error: invalid timeout range '%s'\n", optarg);
+                    return MQTT_ERR_CONFIG_VALUE;
+                }
+                break;
+            case 1007:  /* --low-latency */
+                config->low_latency = 1;
+                break;
+            case 1008:  /* --devices */
+                strncpy(config->devices, optarg, MQTT_MAX_DEVICE_LIST - 1);
+                break;
+            case 1009:  /* --corrections */
+                strncpy(config->corrections, optarg, MQTT_MAX_CORRECTION_LIST - 1);
+                break;
+            case 1010:  /* --auto-report */
+                config->auto_report = 1;
+                break;
+            case 1011:  /* --broker */
+                config->broker = 1;
+                break;
+            case 1012:  /* --broker-dir */
+                strncpy(config->broker_dir, optarg, MQTT_MAX_PATH - 1);
+                config->broker = 1;
+                break;
+            case 1013:  /* --io-uring */
+                config->io_uring = 1;
+                break;
+            case 1014:  /* --time-format */
+                if (timestamp_parse_format(optarg, &config->time_format) != 0) {
+                    fprintf(stderr, "Error: time format '%s' is not iso, ms or ns\n", optarg);
+                    return MQTT_ERR_CONFIG_VALUE;
+                }
+                break;
+            case 1015:  /* --realtime */
+                if (realtime_parse(optarg, &config->realtime) != 0) {
+                    fprintf(stderr, "Error: realtime '%s' is not prio[:cpu], prio 1-99\n",
+                            optarg);
+                    return MQTT_ERR_CONFIG_VALUE;
+                }
+                break;
             case 'V':
                 printf("r4dcb08-mqtt version %s (%s)\n", MQTT_VERSION, MQTT_REVDATE);
                 exit(0);
@@ -458,6 +583,68 @@ MqttStatus mqtt_config_validate(const MqttConfig *config)
         return MQTT_ERR_CONFIG_VALUE;
     }
 
+    /* Validate port list */
+    char ports[MQTT_MAX_PORTS][MQTT_MAX_PATH];
+    int n_ports = mqtt_config_ports(config, ports, MQTT_MAX_PORTS);
+    if (n_ports < 1) {
+        mqtt_log_error("Invalid serial port list: %s (1-%d ports)",
+                      config->serial_port, MQTT_MAX_PORTS);
+        return MQTT_ERR_CONFIG_VALUE;
+    }
+    if (n_ports > 1 && (config->enable_median_filter || config->enable_maf_filter)) {
+        mqtt_log_error("Median and MAF filters need a single serial port");
+        return MQTT_ERR_CONFIG_VALUE;
+    }
+
+    MqttDevice devices[MQTT_MAX_DEVICES];
+    int n_devices = mqtt_config_devices(config, devices, MQTT_MAX_DEVICES);
+    if (n_devices < 1) {
+        mqtt_log_error("Invalid device list: %s (1-%d entries addr[:channels[:period]])",
+                      config->devices, MQTT_MAX_DEVICES);
+        return MQTT_ERR_CONFIG_VALUE;
+    }
+    for (int i = 0; i < n_devices; i++) {
+        for (int j = 0; j < i; j++) {
+            if (devices[i].address == devices[j].address) {
+                mqtt_log_error("Device address %d listed twice", devices[i].address);
+                return MQTT_ERR_CONFIG_VALUE;
+            }
+        }
+    }
+    /* Report interval register holds 1-255 s */
+    for (int i = 0; config->auto_report && i < n_devices; i++) {
+        if (devices[i].period > 255) {
+            mqtt_log_error("Automatic report period of address %d is %d s (must be 1-255)",
+                           devices[i].address, devices[i].period);
+            return MQTT_ERR_CONFIG_VALUE;
+        }
+    }
+    /* Client requests need a bus that is polled, not one that pushes */
+    if (config->broker && config->auto_report) {
+        mqtt_log_error("Broker and automatic report mode cannot be combined");
+        return MQTT_ERR_CONFIG_VALUE;
+    }
+    /* A Modbus TCP gateway only forwards responses to its requests */
+    for (int k = 0; config->auto_report && k < n_ports; k++) {
+        if (transport_type(ports[k]) == TRANSPORT_MODBUS_TCP) {
+            mqtt_log_error("Automatic report mode needs a serial or rtu-tcp:// port: %s",
+                           ports[k]);
+            return MQTT_ERR_CONFIG_VALUE;
+        }
+    }
+    if (n_devices > 1 && (config->enable_median_filter || config->enable_maf_filter)) {
+        mqtt_log_error("Median and MAF filters need a single device");
+        return MQTT_ERR_CONFIG_VALUE;
+    }
+
+    int16_t corrections[MQTT_MAX_CORRECTIONS];
+    if (mqtt_config_corrections(config, corrections, MQTT_MAX_CORRECTIONS) < 0) {
+        mqtt_log_error("Invalid correction list: %s (1-%d values %.1f to %.1f)",
+                      config->corrections, MQTT_MAX_CORRECTIONS,
+                      MIN_TEMPERATURE, MAX_TEMPERATURE);
+        return MQTT_ERR_CONFIG_VALUE;
+    }
+
     /* Validate MAF window size if enabled */
     if (config->enable_maf_filter) {
         if (config->maf_window_size < 3 || config->maf_window_size > 15 ||
@@ -468,17 +655,11 @@ MqttStatus mqtt_config_validate(const MqttConfig *config)
         }
     }
 
-    /* Validate baudrate */
-    int valid_bauds[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 0};
-    int valid = 0;
-    for (int i = 0; valid_bauds[i] != 0; i++) {
-        if (config->baudrate == valid_bauds[i]) {
-            valid = 1;
-            break;
-        }
-    }
-    if (!valid) {
-        mqtt_log_error("Invalid baudrate: %d", config->baudrate);
+    /* Validate baudrate, any rate is set through termios2 */
+    if (config->baudrate != MQTT_BAUD_AUTO &&
+        (config->baudrate < SERIAL_BAUD_MIN || config->baudrate > SERIAL_BAUD_MAX)) {
+        mqtt_log_error("Invalid baudrate: %d (must be %d-%d)", config->baudrate,
+                      SERIAL_BAUD_MIN, SERIAL_BAUD_MAX);
         return MQTT_ERR_CONFIG_VALUE;
     }
 
@@ -516,13 +697,52 @@ void mqtt_config_print(const MqttConfig *config)
     mqtt_log_info("Configuration:");
     mqtt_log_info("  Serial port: %s", config->serial_port);
     mqtt_log_info("  Device address: %d", config->device_address);
-    mqtt_log_info("  Baudrate: %d", config->baudrate);
+    if (config->baudrate == MQTT_BAUD_AUTO) {
+        mqtt_log_info("  Baudrate: auto");
+    } else {
+        mqtt_log_info("  Baudrate: %d", config->baudrate);
+    }
     mqtt_log_info("  Channels: %d", config->num_channels);
+    if (config->devices[0] != '\0') {
+        mqtt_log_info("  Devices: %s", config->devices);
+    }
+    if (config->corrections[0] != '\0') {
+        mqtt_log_info("  Corrections: %s", config->corrections);
+    }
+    if (config->resync) {
+        mqtt_log_info("  Resync: enabled");
+    }
+    if (config->low_latency) {
+        mqtt_log_info("  Low-latency RS485 profile: enabled");
+    }
+    if (config->auto_report) {
+        mqtt_log_info("  Automatic report: enabled");
+    }
+    if (config->broker) {
+        mqtt_log_info("  Broker: %s", config->broker_dir[0] != '\0' ? config->broker_dir :
+                      "default directory");
+    }
+    if (config->io_uring) {
+        mqtt_log_info("  I/O: io_uring");
+    }
+    if (config->timeout_min > 0) {
+        mqtt_log_info("  Adaptive timeout: %d-%d ms", config->timeout_min, config->timeout_max);
+    }
     mqtt_log_info("  MQTT host: %s:%d%s", config->mqtt_host, config->mqtt_port,
                  config->use_tls ? " (TLS)" : "");
     mqtt_log_info("  Topic prefix: %s", config->topic_prefix);
     mqtt_log_info("  Client ID: %s", config->client_id);
     mqtt_log_info("  Interval: %d s", config->interval);
+    if (config->time_format != TS_ISO) {
+        mqtt_log_info("  Timestamps: %s since the epoch",
+                      config->time_format == TS_EPOCH_MS ? "ms" : "ns");
+    }
+    if (config->realtime.priority > 0) {
+        char spec[REALTIME_SPEC_MAX];
+
+        realtime_format(&config->realtime, spec, sizeof(spec));
+        mqtt_log_info("  Real-time: SCHED_FIFO %s (priority[:cpu])", spec);
+    }
     mqtt_log_info("  QoS: %d, Retain: %s", config->qos,
                  config->retain ? "yes" : "no");
     if (config->mqtt_user[0] != '\0') {
@@ -559,10 +779,20 @@ void mqtt_config_usage(const char *program_name)
     printf("Usage: %s [OPTIONS]\n\n", program_name);
     printf("R4DCB08 temperature sensor MQTT publisher daemon\n\n");
     printf("Serial options:\n");
-    printf("  -p, --port <device>      Serial port (default: %s)\n", MQTT_DEFAULT_PORT);
+    printf("  -p, --port <device>      Serial port or list dev,dev,... (default: %s)\n", MQTT_DEFAULT_PORT);
     printf("  -a, --address <addr>     Modbus address 1-254 (default: %d)\n", MQTT_DEFAULT_ADDRESS);
-    printf("  -b, --baudrate <baud>    Baudrate (default: %d)\n", MQTT_DEFAULT_BAUDRATE);
+    printf("  -b, --baudrate <baud>    Baudrate or auto (default: %d)\n", MQTT_DEFAULT_BAUDRATE);
     printf("  -n, --channels <num>     Number of channels 1-8 (default: %d)\n", MQTT_DEFAULT_CHANNELS);
+    printf("      --devices <list>     Devices on each bus: addr[:channels[:period]],...\n");
+    printf("      --corrections <list> Write corrections Tc1,Tc2,... [C] to every device\n");
+    printf("      --resync             Skip line noise in front of responses\n");
+    printf("      --timeout <min,max>  Adaptive response timeout range in ms\n");
+    printf("      --low-latency        Kernel RS485, low_latency, FTDI timer 1 ms\n");
+    printf("      --auto-report        Devices push data every period, no read requests\n");
+    printf("      --broker             Let r4dcb08 clients use the ports (Unix socket)\n");
+    printf("      --broker-dir <dir>   Socket directory of the broker (default: %s)\n",
+           BROKER_DEFAULT_DIR);
+    printf("      --io-uring           Poll serial ports through io_uring (else epoll)\n");
     printf("\nMQTT options:\n");
     printf("  -H, --mqtt-host <host>   MQTT broker host (default: %s)\n", MQTT_DEFAULT_HOST);
     printf("  -P, --mqtt-port <port>   MQTT broker port (default: %d, TLS: %d)\n",
@@ -581,6 +811,9 @@ void mqtt_config_usage(const char *program_name)
     printf("  -I, --interval <sec>     Measurement interval in seconds (default: %d)\n", MQTT_DEFAULT_INTERVAL);
     printf("  -c, --config <file>      Configuration file path\n");
     printf("  -F, --pid-file <file>    PID file path (default: /var/run/r4dcb08-mqtt.pid)\n");
+    printf("      --time-format <fmt>  Published timestamps: iso, ms or ns (default: iso)\n");
+    printf("      --realtime <p[:cpu]> Poll under SCHED_FIFO priority p, memory locked,\n");
+    printf("                           pinned to cpu, MQTT thread on the other CPUs\n");
     printf("  -d, --daemon             Run as daemon\n");
     printf("  -v, --verbose            Verbose output\n");
     printf("\nFilter options:\n");
@@ -599,6 +832,155 @@ void mqtt_config_usage(const char *program_name)
     printf("  %s -H broker.example.com --tls --tls-ca /etc/ssl/ca.crt -u user -W /etc/mqtt.pass\n", program_name);
 }
 
+int mqtt_config_ports(const MqttConfig *config, char ports[][MQTT_MAX_PATH], int max)
+{
+    const char *p = config->serial_port;
+    const char *end;
+    size_t len;
+    int n = 0;
+
+    while (*p != '\0') {
+        end = strchr(p, ',');
+        len = end != NULL ? (size_t)(end - p) : strlen(p);
+
+        /* Trim spaces around the name (config file "a, b") */
+        while (len > 0 && isspace((unsigned char)*p)) {
+            p++;
+            len--;
+        }
+        while (len > 0 && isspace((unsigned char)p[len - 1])) {
+            len--;
+        }
+
+        if (len > 0) {
+            if (n == max) {
+                return -1;
+            }
+            if (len >= MQTT_MAX_PATH) {
+                len = MQTT_MAX_PATH - 1;
+            }
+            memcpy(ports[n], p, len);
+            ports[n][len] = '\0';
+            n++;
+        }
+
+        if (end == NULL) {
+            break;
+        }
+        p = end + 1;
+    }
+
+    return n;
+}
+
+int mqtt_config_devices(const MqttConfig *config, MqttDevice devices[], int max)
+{
+    const char *p = config->devices;
+    char *end;
+    long addr, channels, period;
+    int n = 0;
+
+    if (max < 1) {
+        return -1;
+    }
+
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+    if (*p == '\0') {
+        devices[0].address = config->device_address;
+        devices[0].channels = config->num_channels;
+        devices[0].period = config->interval;
+        return 1;
+    }
+
+    while (*p != '\0') {
+        channels = config->num_channels;
+        period = config->interval;
+
+        addr = strtol(p, &end, 10);
+        if (end == p || addr < 1 || addr > 254) {
+            return -1;
+        }
+        p = end;
+        if (*p == ':') {
+            channels = strtol(p + 1, &end, 10);
+            if (end == p + 1 || channels < 1 || channels > 8) {
+                return -1;
+            }
+            p = end;
+            if (*p == ':') {
+                period = strtol(p + 1, &end, 10);
+                if (end == p + 1 || period < 1 || period > 86400) {
+                    return -1;
+                }
+                p = end;
+            }
+        }
+
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p != ',' && *p != '\0') {
+            return -1;
+        }
+        if (n == max) {
+            return -1;
+        }
+
+        devices[n].address = (uint8_t)addr;
+        devices[n].channels = (int)channels;
+        devices[n].period = (int)period;
+        n++;
+
+        if (*p == ',') {
+            p++;
+            while (isspace((unsigned char)*p)) {
+                p++;
+            }
+        }
+    }
+
+    return n;
+}
+
+int mqtt_config_corrections(const MqttConfig *config, int16_t values[], int max)
+{
+    const char *p = config->corrections;
+    char *end;
+    double t;
+    int n = 0;
+
+    while (isspace((unsigned char)*p)) {
+        p++;
+    }
+
+    while (*p != '\0') {
+        t = strtod(p, &end);
+        if (end == p || t < MIN_TEMPERATURE || t > MAX_TEMPERATURE || n == max) {
+            return -1;
+        }
+        p = end;
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p != ',' && *p != '\0') {
+            return -1;
+        }
+
+        values[n++] = (int16_t)(t * 10.0 + (t < 0 ? -0.5 : 0.5));  /* 0.1 C */
+
+        if (*p == ',') {
+            p++;
+            while (isspace((unsigned char)*p)) {
+                p++;
+            }
+        }
+    }
+
+    return n;
+}
+
 MqttStatus mqtt_config_load_password(MqttConfig *config)
 {
     FILE *fp;
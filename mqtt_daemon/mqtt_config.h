@@ -1,17 +1,32 @@
 /*
  * MQTT daemon configuration
  * V1.0/2026-01-29
+ * V1.1/2026-10-16 Resync option
+ * V1.2/2026-10-16 Adaptive timeout options
+ * V1.3/2026-10-16 Several serial ports
+ * V1.4/2026-10-16 Low-latency RS485 profile option
+ * V1.5/2026-10-16 Baud rate detection (auto)
+ * V1.6/2026-10-16 Device list for the bus scheduler
+ * V1.7/2026-10-16 Temperature corrections written at startup
+ * V1.8/2026-10-16 Automatic report (push) mode
+ * V1.9/2026-10-16 Serial bus broker for local clients
+ * V1.10/2026-10-16 io_uring backend option
+ * V1.11/2026-10-16 Timestamp format option
+ * V1.12/2026-10-16 Real-time polling thread option
  */
 #ifndef MQTT_CONFIG_H
 #define MQTT_CONFIG_H
 
 #include <stdint.h>
 #include "mqtt_error.h"
+#include "../now.h"
+#include "../realtime.h"
 
 /* Default values */
 #define MQTT_DEFAULT_PORT "/dev/ttyUSB0"
 #define MQTT_DEFAULT_ADDRESS 1
 #define MQTT_DEFAULT_BAUDRATE 9600
+#define MQTT_BAUD_AUTO 0  /* Baud rate detected at port open */
 #define MQTT_DEFAULT_CHANNELS 8
 #define MQTT_DEFAULT_HOST "localhost"
 #define MQTT_DEFAULT_MQTT_PORT 1883
@@ -32,13 +47,41 @@
 #define MQTT_MAX_CRED 128
 #define MQTT_MAX_CLIENT_ID 64
 
+/* Most serial ports in the port list */
+#define MQTT_MAX_PORTS 8
+
+/* Most devices on one bus, length of the device list */
+#define MQTT_MAX_DEVICES 32
+#define MQTT_MAX_DEVICE_LIST 512
+
+/* Corrections of channels 1..8, length of the correction list */
+#define MQTT_MAX_CORRECTIONS 8
+#define MQTT_MAX_CORRECTION_LIST 128
+
+/* One device of the device list */
+typedef struct {
+    uint8_t address;        /* Modbus address */
+    int channels;           /* Channels to read (1-8) */
+    int period;             /* Read period [s] */
+} MqttDevice;
+
 /* Configuration structure */
 typedef struct {
     /* Serial port settings */
-    char serial_port[MQTT_MAX_PATH];
+    char serial_port[MQTT_MAX_PATH];  /* Port, or comma-separated list of ports */
     uint8_t device_address;
+    char devices[MQTT_MAX_DEVICE_LIST]; /* addr[:channels[:period]],... empty = one device */
     int baudrate;
     int num_channels;
+    int resync;             /* Skip noise in front of responses */
+    int low_latency;        /* Apply the low-latency RS485 profile */
+    int timeout_min;        /* Adaptive timeout floor [ms], 0 = fixed 500 ms */
+    int timeout_max;        /* Adaptive timeout ceiling [ms] */
+    char corrections[MQTT_MAX_CORRECTION_LIST]; /* Tc1,Tc2,... written at startup, empty = none */
+    int auto_report;        /* Devices push their data every period (register 0x00FD) */
+    int broker;             /* Serve local clients (r4dcb08 CLI) over a Unix socket per port */
+    char broker_dir[MQTT_MAX_PATH]; /* Socket directory, empty = default */
+    int io_uring;           /* Poll the serial ports through io_uring */
 
     /* MQTT settings */
     char mqtt_host[MQTT_MAX_HOST];
@@ -57,6 +100,8 @@ typedef struct {
     int verbose;
     char config_file[MQTT_MAX_PATH];
     char pid_file[MQTT_MAX_PATH];
+    TimestampFormat time_format; /* Text of published timestamps */
+    RealtimeConfig realtime;     /* Real-time polling thread, priority 0 = off */
 
     /* Filter settings */
     int enable_median_filter;
@@ -142,6 +187,44 @@ MqttStatus mqtt_config_load_password(MqttConfig *config);
  */
 void mqtt_config_clear_sensitive(MqttConfig *config);
 
+/**
+ * Split the serial port list
+ *
+ * @param config Pointer to configuration structure
+ * @param ports  Array to store port names
+ * @param max    Size of the array
+ * @return Number of ports, -1 if there are more than max
+ */
+int mqtt_config_ports(const MqttConfig *config, char ports[][MQTT_MAX_PATH], int max);
+
+/**
+ * Split the device list
+ *
+ * Entries are addr[:channels[:period]]; channels default to num_channels,
+ * the period to interval. An empty list is the single device at
+ * device_address.
+ *
+ * @param config  Pointer to configuration structure
+ * @param devices Array to store the devices
+ * @param max     Size of the array
+ * @return Number of devices, -1 on a malformed entry or more than max
+ */
+int mqtt_config_devices(const MqttConfig *config, MqttDevice devices[], int max);
+
+/**
+ * Split the correction list
+ *
+ * Entries are corrections of channels 1..n in degrees C, returned in the
+ * register format of the device (0.1 C, signed).
+ *
+ * @param config Pointer to configuration structure
+ * @param values Array to store the register values
+ * @param max    Size of the array
+ * @return Number of corrections (0 = empty list), -1 on a malformed or
+ *         out-of-range entry or more than max
+ */
+int mqtt_config_corrections(const MqttConfig *config, int16_t values[], int max);
+
 /**
  * Safe string to integer conversion with validation
  *
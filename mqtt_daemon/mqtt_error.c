@@ -1,12 +1,14 @@
 /*
  * MQTT daemon error handling and logging
  * V1.1/2026-02-02
+ * V1.2/2026-10-16 Log time from the cached local time formatter
  */
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
 #include <time.h>
 #include "mqtt_error.h"
+#include "../now.h"
 
 static int use_syslog = 0;
 static int verbose_mode = 0;
@@ -38,11 +40,14 @@ static void log_message(int priority, const char *prefix, const char *format, va
         vsnprintf(buffer, sizeof(buffer), format, args);
         syslog(priority, "%s", buffer);
     } else {
-        time_t now = time(NULL);
-        struct tm tm_buf;
-        struct tm *tm_info = localtime_r(&now, &tm_buf);
+        struct timespec now;
         char time_buf[32];
-        strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", tm_info);
+
+        clock_gettime(CLOCK_REALTIME, &now);
+        if (timestamp_local((int64_t)now.tv_sec * 1000000000 + now.tv_nsec, 0,
+                            time_buf, sizeof(time_buf)) != 0) {
+            strcpy(time_buf, "unknown");
+        }
 
         fprintf(stderr, "%s [%s] ", time_buf, prefix);
         vfprintf(stderr, format, args);
@@ -1,6 +1,12 @@
 /*
  * R4DCB08 MQTT daemon main entry point
  * V1.2/2026-02-02
+ * V1.3/2026-10-16 Several serial ports polled at once
+ * V1.4/2026-10-16 Bus scheduler for many devices per port
+ * V1.5/2026-10-16 Devices back in query mode on exit (automatic report)
+ * V1.6/2026-10-16 Broker sockets closed on exit
+ * V1.7/2026-10-16 Timestamp format of the published samples
+ * V1.8/2026-10-16 Real-time polling thread (SCHED_FIFO, mlockall, CPU pinning)
  *
  * Reads temperatures from R4DCB08 sensor via Modbus RTU
  * and publishes to MQTT broker using libmosquitto.
@@ -25,11 +31,15 @@
 #include "mqtt_client.h"
 #include "mqtt_publish.h"
 #include "mqtt_metrics.h"
+#include "mqtt_sched.h"
 
 /* Program name for logging */
 #define PROGRAM_NAME "r4dcb08-mqtt"
 #define PROGRAM_VERSION MQTT_VERSION
 
+/* Scheduler time slice between checks of connection, signals and watchdog */
+#define SCHED_SLICE_MS 1000
+
 /* Global flag for graceful shutdown */
 static volatile sig_atomic_t running = 1;
 static volatile sig_atomic_t reload_config = 0;
@@ -174,17 +184,40 @@ static int daemonize(void)
     return 0;
 }
 
+/* Close all serial ports, devices pushing reports go back to query mode */
+static void close_ports(TempContext temp_ctx[], int n_ports)
+{
+    for (int k = 0; k < n_ports; k++) {
+        if (temp_ctx[k].config->auto_report && temp_ctx[k].fd >= 0) {
+            mqtt_temp_auto_report(&temp_ctx[k], 0);
+        }
+        mqtt_temp_close(&temp_ctx[k]);
+    }
+}
+
 /* Main daemon loop */
 static int daemon_loop(MqttConfig *config)
 {
     MqttClient client;
-    TempContext temp_ctx;
+    static TempContext temp_ctx[MQTT_MAX_PORTS];
+    static MqttSched sched;
+    char ports[MQTT_MAX_PORTS][MQTT_MAX_PATH];
+    MqttDevice devices[MQTT_MAX_DEVICES];
+    int n_ports, n_devices, k, ok, attempted, opened = 0;
     MqttMetrics metrics;
     MqttStatus status;
-    struct timespec ts;
+    SchedSummary summary;
+    struct timespec now, last_diag;
     int consecutive_errors = 0;
     const int max_consecutive_errors = 10;
-    int diag_counter = 0;
+    char msg[256];
+
+    /* Memory locked, MQTT network thread created later off the polling CPU */
+    if (config->realtime.priority > 0 &&
+        realtime_prepare(&config->realtime, msg, sizeof(msg)) != 0) {
+        mqtt_log_error("Real-time mode failed: %s", msg);
+        return 1;
+    }
 
     /* Initialize MQTT client library */
     status = mqtt_client_lib_init();
@@ -193,22 +226,31 @@ static int daemon_loop(MqttConfig *config)
         return 1;
     }
 
-    /* Initialize temperature reading context */
-    status = mqtt_temp_init(&temp_ctx, config);
-    if (status != MQTT_OK) {
-        mqtt_log_error("Failed to initialize temperature context");
-        mqtt_client_lib_cleanup();
-        return 1;
+    /* Initialize temperature reading context of every port */
+    n_ports = mqtt_config_ports(config, ports, MQTT_MAX_PORTS);
+    n_devices = mqtt_config_devices(config, devices, MQTT_MAX_DEVICES);
+    for (k = 0; k < n_ports; k++) {
+        status = mqtt_temp_init(&temp_ctx[k], config, ports[k], n_ports > 1,
+                                devices, n_devices);
+        if (status != MQTT_OK) {
+            mqtt_log_error("Failed to initialize temperature context");
+            mqtt_client_lib_cleanup();
+            return 1;
+        }
     }
 
     /* Initialize metrics */
     mqtt_metrics_init(&metrics);
 
-    /* Open serial port */
-    status = mqtt_temp_open(&temp_ctx);
-    if (status != MQTT_OK) {
+    /* Open serial ports, ports failing now are retried every interval */
+    for (k = 0; k < n_ports; k++) {
+        if (mqtt_temp_open(&temp_ctx[k]) == MQTT_OK) {
+            opened++;
+        }
+    }
+    if (opened == 0) {
         mqtt_log_error("Failed to open serial port");
-        mqtt_temp_close(&temp_ctx);  /* Clean up any partially initialized state */
+        close_ports(temp_ctx, n_ports);  /* Clean up any partially initialized state */
         mqtt_client_lib_cleanup();
         return 1;
     }
@@ -217,7 +259,7 @@ static int daemon_loop(MqttConfig *config)
     status = mqtt_client_create(&client, config);
     if (status != MQTT_OK) {
         mqtt_log_error("Failed to create MQTT client");
-        mqtt_temp_close(&temp_ctx);
+        close_ports(temp_ctx, n_ports);
         mqtt_client_lib_cleanup();
         return 1;
     }
@@ -230,7 +272,7 @@ static int daemon_loop(MqttConfig *config)
     if (status != MQTT_OK) {
         mqtt_log_error("Failed to connect to MQTT broker");
         mqtt_client_destroy(&client);
-        mqtt_temp_close(&temp_ctx);
+        close_ports(temp_ctx, n_ports);
         mqtt_client_lib_cleanup();
         return 1;
     }
@@ -238,7 +280,25 @@ static int daemon_loop(MqttConfig *config)
     /* Publish initial online status */
     mqtt_publish_status(&client, "online");
 
-    mqtt_log_info("Daemon started, interval=%d s", config->interval);
+    mqtt_log_info("Daemon started, interval=%d s, %d port(s), %d device(s) per port",
+                  config->interval, n_ports, n_devices);
+
+    mqtt_sched_init(&sched, temp_ctx, n_ports, &client, &metrics);
+    clock_gettime(CLOCK_MONOTONIC, &last_diag);
+
+    /* This thread polls the ports from here on */
+    if (config->realtime.priority > 0) {
+        if (realtime_enter(&config->realtime, msg, sizeof(msg)) != 0) {
+            mqtt_log_error("Real-time mode failed: %s", msg);
+            mqtt_client_destroy(&client);
+            mqtt_sched_close(&sched);
+            close_ports(temp_ctx, n_ports);
+            mqtt_client_lib_cleanup();
+            return 1;
+        }
+        realtime_format(&config->realtime, msg, sizeof(msg));
+        mqtt_log_info("Real-time: polling thread SCHED_FIFO %s, memory locked", msg);
+    }
 
     /* Notify systemd we are ready */
 #ifdef USE_SYSTEMD
@@ -279,54 +339,45 @@ static int daemon_loop(MqttConfig *config)
             mqtt_publish_status(&client, "online");
         }
 
-        /* Read and publish temperatures */
-        status = mqtt_publish_temperatures(&temp_ctx, &client);
-        if (status != MQTT_OK) {
-            mqtt_metrics_read_failure(&metrics);
+        /* Read due devices of all ports and publish each result */
+        ok = mqtt_sched_run(&sched, SCHED_SLICE_MS, &running, &attempted);
+        if (attempted > 0 && ok == 0) {
             consecutive_errors++;
-            mqtt_metrics_set_consecutive_errors(&metrics, consecutive_errors);
-            mqtt_log_warning("Temperature read/publish failed (%d/%d)",
+            mqtt_log_warning("Temperature read/publish failed on all ports (%d/%d)",
                            consecutive_errors, max_consecutive_errors);
 
             if (consecutive_errors >= max_consecutive_errors) {
                 mqtt_log_error("Too many consecutive errors, exiting");
                 break;
             }
-
-            /* Try to reopen serial port on error */
-            mqtt_temp_close(&temp_ctx);
-            sleep(1);
-            if (mqtt_temp_open(&temp_ctx) != MQTT_OK) {
-                mqtt_log_error("Failed to reopen serial port");
-            }
-        } else {
-            mqtt_metrics_read_success(&metrics);
+        } else if (ok > 0) {
             consecutive_errors = 0;
-            mqtt_metrics_set_consecutive_errors(&metrics, 0);
         }
+        mqtt_metrics_set_consecutive_errors(&metrics, consecutive_errors);
+
+        unsigned long resync_frames = 0, resync_bytes = 0;
+        for (k = 0; k < n_ports; k++) {
+            resync_frames += temp_ctx[k].resync_frames;
+            resync_bytes += temp_ctx[k].resync_bytes;
+        }
+        mqtt_metrics_set_resync(&metrics, resync_frames, resync_bytes);
 
         /* Publish diagnostics every N intervals */
-        if (config->diagnostics_interval > 0) {
-            diag_counter++;
-            if (diag_counter >= config->diagnostics_interval) {
-                mqtt_publish_diagnostics(&client, &metrics);
-                diag_counter = 0;
-            }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (config->diagnostics_interval > 0 &&
+            now.tv_sec - last_diag.tv_sec >=
+            (time_t)config->diagnostics_interval * config->interval) {
+            mqtt_sched_report(&sched, &summary);
+            mqtt_metrics_set_sched(&metrics, summary.missed, summary.cycle_ms,
+                                   summary.load, summary.late_max_ms);
+            mqtt_publish_diagnostics(&client, &metrics);
+            last_diag = now;
         }
 
-        /* Notify systemd watchdog on each iteration */
+        /* Notify systemd watchdog on each slice */
 #ifdef USE_SYSTEMD
         sd_notify(0, "WATCHDOG=1");
 #endif
-
-        /* Sleep for interval, checking for shutdown every second */
-        for (int i = 0; i < config->interval && running; i++) {
-            ts.tv_sec = 1;
-            ts.tv_nsec = 0;
-            if (nanosleep(&ts, NULL) == -1 && errno == EINTR) {
-                break;  /* Interrupted by signal, check running flag */
-            }
-        }
     }
 
     /* Cleanup */
@@ -344,7 +395,8 @@ static int daemon_loop(MqttConfig *config)
     }
 
     mqtt_client_destroy(&client);
-    mqtt_temp_close(&temp_ctx);
+    mqtt_sched_close(&sched);
+    close_ports(temp_ctx, n_ports);
     mqtt_client_lib_cleanup();
 
     mqtt_log_info("Daemon stopped");
@@ -356,6 +408,7 @@ int main(int argc, char *argv[])
     MqttConfig config;
     MqttStatus status;
     int exit_code = 0;
+    char msg[256];
 
     /* Initialize configuration with defaults */
     mqtt_config_init(&config);
@@ -394,6 +447,15 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    timestamp_set_format(config.time_format);
+
+    /* Real-time mode: missing privileges are reported before anything starts */
+    if (config.realtime.priority > 0 &&
+        realtime_check(&config.realtime, msg, sizeof(msg)) != 0) {
+        fprintf(stderr, "Real-time mode not available: %s\n", msg);
+        return 1;
+    }
+
     /* Initialize logging */
     mqtt_log_init(config.daemon_mode, PROGRAM_NAME);
     mqtt_log_set_verbose(config.verbose);
@@ -1,6 +1,8 @@
 /*
  * MQTT daemon diagnostic metrics
  * V1.0/2026-01-29
+ * V1.1/2026-10-16 Resync counters
+ * V1.2/2026-10-16 Bus scheduler statistics
  */
 #include "mqtt_metrics.h"
 
@@ -16,6 +18,12 @@ void mqtt_metrics_init(MqttMetrics *metrics)
     metrics->read_failure = 0;
     metrics->mqtt_reconnect_count = 0;
     metrics->consecutive_errors = 0;
+    metrics->resync_frames = 0;
+    metrics->resync_bytes = 0;
+    metrics->sched_missed = 0;
+    metrics->sched_cycle_ms = 0.0;
+    metrics->sched_load = 0.0;
+    metrics->sched_late_max_ms = 0.0;
 }
 
 uint32_t mqtt_metrics_uptime(const MqttMetrics *metrics)
@@ -69,3 +77,27 @@ void mqtt_metrics_set_consecutive_errors(MqttMetrics *metrics, int count)
 
     metrics->consecutive_errors = count;
 }
+
+void mqtt_metrics_set_resync(MqttMetrics *metrics, unsigned long frames,
+                             unsigned long bytes)
+{
+    if (metrics == NULL) {
+        return;
+    }
+
+    metrics->resync_frames = frames;
+    metrics->resync_bytes = bytes;
+}
+
+void mqtt_metrics_set_sched(MqttMetrics *metrics, unsigned long missed,
+                            double cycle_ms, double load, double late_max_ms)
+{
+    if (metrics == NULL) {
+        return;
+    }
+
+    metrics->sched_missed += missed;
+    metrics->sched_cycle_ms = cycle_ms;
+    metrics->sched_load = load;
+    metrics->sched_late_max_ms = late_max_ms;
+}
@@ -1,6 +1,8 @@
 /*
  * MQTT daemon diagnostic metrics
  * V1.0/2026-01-29
+ * V1.1/2026-10-16 Resync counters
+ * V1.2/2026-10-16 Bus scheduler statistics
  */
 #ifndef MQTT_METRICS_H
 #define MQTT_METRICS_H
@@ -15,6 +17,12 @@ typedef struct {
     uint32_t read_failure;
     uint32_t mqtt_reconnect_count;
     int consecutive_errors;
+    unsigned long resync_frames;
+    unsigned long resync_bytes;
+    unsigned long sched_missed;     /* Missed read deadlines since start */
+    double sched_cycle_ms;          /* Bus cycle time, last report window */
+    double sched_load;              /* Bus utilization [%], last report window */
+    double sched_late_max_ms;       /* Longest read start delay, last report window */
 } MqttMetrics;
 
 /**
@@ -61,4 +69,26 @@ void mqtt_metrics_reconnect(MqttMetrics *metrics);
  */
 void mqtt_metrics_set_consecutive_errors(MqttMetrics *metrics, int count);
 
+/**
+ * Set resync counters (responses recovered from noise, bytes discarded)
+ *
+ * @param metrics Pointer to metrics structure
+ * @param frames Responses recovered
+ * @param bytes Noise bytes discarded
+ */
+void mqtt_metrics_set_resync(MqttMetrics *metrics, unsigned long frames,
+                             unsigned long bytes);
+
+/**
+ * Set bus scheduler statistics of the last report window
+ *
+ * @param metrics Pointer to metrics structure
+ * @param missed Deadlines missed in the window (added to the total)
+ * @param cycle_ms Longest time to read every device of a bus once
+ * @param load Highest bus utilization [%]
+ * @param late_max_ms Longest read start delay
+ */
+void mqtt_metrics_set_sched(MqttMetrics *metrics, unsigned long missed,
+                            double cycle_ms, double load, double late_max_ms);
+
 #endif /* MQTT_METRICS_H */
@@ -1,12 +1,28 @@
 /*
  * MQTT temperature publishing logic
  * V1.0/2026-01-29
+ * V1.1/2026-10-16 Modbus transactions through per-port ModbusCtx
+ * V1.2/2026-10-16 Temperature read request encoded once per port open
+ * V1.3/2026-10-16 Resync mode and its statistics
+ * V1.4/2026-10-16 Adaptive response timeout
+ * V1.5/2026-10-16 Several ports, reads driven by the poller
+ * V1.6/2026-10-16 Log baud rate applied by the driver
+ * V1.7/2026-10-16 Low-latency RS485 profile
+ * V1.8/2026-10-16 Baud rate detection (-b auto)
+ * V1.9/2026-10-16 Several devices per port, one read submitted at a time
+ * V1.10/2026-10-16 Corrections written with Write Multiple Registers
+ * V1.11/2026-10-16 Automatic report (push) mode
+ * V1.12/2026-10-16 Ports over RTU-over-TCP and Modbus TCP
+ * V1.13/2026-10-16 Binary sample timestamps, formatted when published
+ * V1.14/2026-10-16 Sample time of the last response byte, not of the publish
+ * V1.15/2026-10-16 -b auto probes the devices of the bus, not the -a address
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <libgen.h>
 
 #include "mqtt_publish.h"
 #include "mqtt_error.h"
@@ -14,17 +30,37 @@
 /* Include original r4dcb08 modules */
 #include "../serial.h"
 #include "../packet.h"
-#include "../monada.h"
+#include "../modbus_ctx.h"
+#include "../scan.h"
 #include "../typedef.h"
 #include "../now.h"
 #include "../median_filter.h"
 #include "../maf_filter.h"
 #include "../constants.h"
 #include "../define_error_resp.h"
-
-MqttStatus mqtt_temp_init(TempContext *ctx, const MqttConfig *config)
+#include "../autoreport.h"
+#include "../transport.h"
+
+/* First correction register (channel 1) */
+#define REG_CORRECTION 0x0008
+
+/* Local function prototypes */
+static void write_corrections(TempContext *ctx);
+static void init_modbus(TempContext *ctx, int baud);
+static MqttStatus open_network(TempContext *ctx, TransportType type);
+static MqttStatus publish_values(TempContext *ctx, MqttClient *client,
+                                 const Timestamp *sample, const uint8_t *p_data, int len);
+static MqttStatus publish_port(TempContext *ctx, MqttClient *client, const char *topic,
+                               const char *payload, int qos, int retain);
+
+MqttStatus mqtt_temp_init(TempContext *ctx, const MqttConfig *config,
+                          const char *port, int several,
+                          const MqttDevice devices[], int n_dev)
 {
-    if (ctx == NULL || config == NULL) {
+    char name[MQTT_MAX_PATH];
+
+    if (ctx == NULL || config == NULL || port == NULL ||
+        n_dev < 1 || n_dev > MQTT_MAX_DEVICES) {
         return MQTT_ERR_CONFIG_VALUE;
     }
 
@@ -32,6 +68,22 @@ MqttStatus mqtt_temp_init(TempContext *ctx, const MqttConfig *config)
     ctx->fd = -1;
     ctx->config = config;
     ctx->filter_initialized = 0;
+    strncpy(ctx->port, port, sizeof(ctx->port) - 1);
+
+    for (int i = 0; i < n_dev; i++) {
+        ctx->dev[i].address = devices[i].address;
+        ctx->dev[i].channels = devices[i].channels;
+        ctx->dev[i].period_ms = devices[i].period * 1000;
+        ctx->dev[i].read_status = ERROR_PACKET_TIMEOUT;
+    }
+    ctx->n_dev = n_dev;
+
+    /* /dev/ttyUSB0 -> ttyUSB0 */
+    if (several) {
+        strncpy(name, port, sizeof(name) - 1);
+        name[sizeof(name) - 1] = '\0';
+        strncpy(ctx->bus_name, basename(name), sizeof(ctx->bus_name) - 1);
+    }
 
     /* Initialize MAF filter if enabled */
     if (config->enable_maf_filter) {
@@ -49,7 +101,9 @@ MqttStatus mqtt_temp_init(TempContext *ctx, const MqttConfig *config)
 
 MqttStatus mqtt_temp_open(TempContext *ctx)
 {
-    int rc;
+    int rc, baud, wanted, saved = 0, tried = 0, i;
+    uint8_t adr = 0;
+    TransportType type;
 
     if (ctx == NULL || ctx->config == NULL) {
         return MQTT_ERR_SERIAL;
@@ -57,28 +111,82 @@ MqttStatus mqtt_temp_open(TempContext *ctx)
 
     /* Close if already open */
     if (ctx->fd >= 0) {
-        close(ctx->fd);
+        transport_close(ctx->fd);
         ctx->fd = -1;
     }
 
-    /* Open serial port */
-    ctx->fd = open_port(ctx->config->serial_port);
+    /* Open serial port or connect */
+    ctx->fd = transport_open(ctx->port);
     if (ctx->fd < 0) {
-        mqtt_log_error("Failed to open serial port: %s", ctx->config->serial_port);
+        mqtt_log_error("Failed to open serial port: %s", ctx->port);
         return MQTT_ERR_SERIAL;
     }
+    type = transport_fd_type(ctx->fd);
+
+    wanted = ctx->config->baudrate;
+    if (type != TRANSPORT_SERIAL) {
+        return open_network(ctx, type);
+    }
+    if (wanted == MQTT_BAUD_AUTO) {
+        /* Saved rate first, then the likely rates; one probe if still right.
+           The first device of the bus that answers sets the rate. */
+        wanted = 0;
+        for (i = 0; i < ctx->n_dev && wanted == 0; i++) {
+            adr = ctx->dev[i].address;
+            saved = scan_baud_load(ctx->port, adr);
+            wanted = scan_detect_baud(ctx->fd, adr, saved, &tried);
+        }
+        if (wanted == 0) {
+            mqtt_log_error("%s: no device answers at any baud rate (%d tried)",
+                           ctx->port, tried);
+            transport_close(ctx->fd);
+            ctx->fd = -1;
+            return MQTT_ERR_SERIAL;
+        }
+        if (wanted != saved) {
+            mqtt_log_info("%s: detected %d baud at address %d", ctx->port, wanted, adr);
+            scan_baud_store(ctx->port, adr, wanted);
+        }
+    }
 
     /* Configure serial port */
-    rc = set_port(ctx->fd, ctx->config->baudrate);
+    rc = set_port(ctx->fd, wanted);
     if (rc != SERIAL_SUCCESS) {
         mqtt_log_error("Failed to configure serial port: %d", rc);
-        close(ctx->fd);
+        transport_close(ctx->fd);
         ctx->fd = -1;
         return MQTT_ERR_SERIAL;
     }
+    /* Gap timing follows the rate the driver applied */
+    baud = serial_get_baud(ctx->fd, wanted);
+    if (baud != wanted) {
+        mqtt_log_warning("%s: %d baud requested, driver applied %d baud",
+                         ctx->port, wanted, baud);
+    }
+    init_modbus(ctx, baud);
+
+    if (ctx->config->low_latency) {
+        SerialTuning tuning;
+
+        serial_tune_low_latency(ctx->fd, ctx->port, &tuning);
+        modbus_ctx_set_host_latency(&ctx->modbus, serial_host_latency_us(&tuning));
+        mqtt_log_info("%s: low-latency profile: RS485 %s, low_latency %s, latency timer %s",
+                      ctx->port, serial_tune_text(tuning.rs485),
+                      serial_tune_text(tuning.low_latency),
+                      serial_tune_text(tuning.latency_timer));
+        if (tuning.latency_timer_old >= 0) {
+            mqtt_log_info("%s: latency timer %d ms -> %d ms", ctx->port,
+                          tuning.latency_timer_old, tuning.latency_timer_ms);
+        }
+    }
 
-    mqtt_log_info("Serial port opened: %s @ %d baud",
-                 ctx->config->serial_port, ctx->config->baudrate);
+    mqtt_log_info("Serial port opened: %s @ %d baud", ctx->port, baud);
+
+    write_corrections(ctx);
+
+    if (ctx->config->auto_report) {
+        mqtt_temp_auto_report(ctx, 1);
+    }
 
     return MQTT_OK;
 }
@@ -90,7 +198,7 @@ void mqtt_temp_close(TempContext *ctx)
     }
 
     if (ctx->fd >= 0) {
-        close(ctx->fd);
+        transport_close(ctx->fd);
         ctx->fd = -1;
     }
 
@@ -100,58 +208,208 @@ void mqtt_temp_close(TempContext *ctx)
     }
 }
 
+MqttStatus mqtt_temp_submit(TempContext *ctx, Poller *poller, int bus, int dev,
+                            PollerDone done, void *arg)
+{
+    if (ctx == NULL || poller == NULL || ctx->fd < 0 || dev < 0 || dev >= ctx->n_dev) {
+        return MQTT_ERR_SERIAL;
+    }
+
+    ctx->current = dev;
+    ctx->dev[dev].read_status = ERROR_PACKET_TIMEOUT;
+    ctx->resync_mark_bytes = ctx->modbus.bus->stats.resync_bytes;
+    ctx->resync_mark_frames = ctx->modbus.bus->stats.resync_frames;
+
+    /* Request encoded in mqtt_temp_open() */
+    if (poller_submit(poller, bus, &ctx->dev[dev].read_req, done, arg) != STATUS_OK) {
+        ctx->dev[dev].read_status = ERROR_SEND_PACKET;
+        return MQTT_ERR_MODBUS;
+    }
+
+    return MQTT_OK;
+}
+
+void mqtt_temp_finish(TempContext *ctx, AppStatus status)
+{
+    unsigned long resync_bytes, resync_frames;
+
+    ctx->dev[ctx->current].read_status = status;
+    if (ctx->modbus.bus == NULL) {
+        return;  /* Port never opened */
+    }
+
+    /* Noise skipped in front of the response (resync mode) */
+    resync_bytes = ctx->modbus.bus->stats.resync_bytes - ctx->resync_mark_bytes;
+    resync_frames = ctx->modbus.bus->stats.resync_frames - ctx->resync_mark_frames;
+    if (resync_bytes > 0) {
+        ctx->resync_bytes += resync_bytes;
+        ctx->resync_frames += resync_frames;
+        mqtt_log_debug("Resync: discarded %lu noise byte(s) on %s", resync_bytes, ctx->port);
+    }
+    ctx->resync_mark_bytes = ctx->modbus.bus->stats.resync_bytes;
+    ctx->resync_mark_frames = ctx->modbus.bus->stats.resync_frames;
+}
+
+MqttStatus mqtt_temp_auto_report(TempContext *ctx, int on)
+{
+    MqttStatus result = MQTT_OK;
+    AppStatus status;
+    int seconds;
+
+    if (ctx == NULL || ctx->fd < 0) {
+        return MQTT_ERR_SERIAL;
+    }
+
+    for (int i = 0; i < ctx->n_dev; i++) {
+        TempDevice *dev = &ctx->dev[i];
+
+        seconds = on ? dev->period_ms / 1000 : 0;
+        status = autoreport_set(&ctx->modbus, dev->address, seconds);
+        if (status != STATUS_OK) {
+            mqtt_log_warning("%s: setting automatic report of address %d failed: %s",
+                             ctx->port, dev->address, get_error_message(status));
+            result = MQTT_ERR_MODBUS;
+            continue;
+        }
+        if (on) {
+            mqtt_log_info("%s: address %d reports every %d s", ctx->port,
+                          dev->address, seconds);
+        } else {
+            mqtt_log_info("%s: address %d back in query mode", ctx->port, dev->address);
+        }
+    }
+
+    return result;
+}
+
 MqttStatus mqtt_publish_temperatures(TempContext *ctx, MqttClient *client)
 {
     PACKET pr;
-    PACKET *p_pr = &pr;
     uint8_t *p_data;
-    uint8_t input_data[DMAX];
-    int i, rc;
-    float T[MAX_CHANNELS];
-    float T_filtered[MAX_CHANNELS];
-    char sample_time[DBUF];
-    char sample_filtered[DBUF];
-    char payload[MQTT_MAX_PAYLOAD];
-    char topic[64];
-    MqttStatus status;
-    AppStatus app_status;
-    int n;
+    TempDevice *dev;
+    Timestamp sample_time;
 
-    if (ctx == NULL || client == NULL || ctx->fd < 0) {
+    if (ctx == NULL || client == NULL) {
         return MQTT_ERR_READ_TEMP;
     }
 
-    n = ctx->config->num_channels;
+    dev = &ctx->dev[ctx->current];
 
-    /* Prepare Modbus request */
-    /* Register address (2 byte) + Read count (2 byte) */
-    input_data[0] = 0x00;
-    input_data[1] = 0x00;
-    input_data[2] = 0x00;
-    input_data[3] = (uint8_t)n;
+    if (ctx->fd < 0 || dev->read_status != STATUS_OK ||
+        modbus_request_result(&ctx->modbus, &pr, &p_data) != STATUS_OK) {
+        mqtt_log_error("Modbus read failed on %s address %d: %d", ctx->port,
+                       dev->address, dev->read_status);
+        publish_port(ctx, client, "status", "error", ctx->config->qos, 1);
+        return MQTT_ERR_MODBUS;
+    }
 
-    /* Read temperatures via Modbus */
-    app_status = monada(ctx->fd, ctx->config->device_address, '\x03', 4,
-                       input_data, p_pr, 0, "read_temp", 0, &p_data);
+    /* Time of the last response byte, not of this publish */
+    modbus_request_time(&ctx->modbus, &sample_time);
 
-    if (app_status != STATUS_OK) {
-        mqtt_log_error("Modbus read failed: %d", app_status);
-        mqtt_publish_status(client, "error");
-        return MQTT_ERR_MODBUS;
+    return publish_values(ctx, client, &sample_time, p_data, pr.len);
+}
+
+MqttStatus mqtt_publish_report(TempContext *ctx, MqttClient *client, int dev,
+                               const PACKET *p, const Timestamp *sample)
+{
+    if (ctx == NULL || client == NULL || p == NULL || sample == NULL ||
+        dev < 0 || dev >= ctx->n_dev) {
+        return MQTT_ERR_READ_TEMP;
+    }
+
+    ctx->current = dev;
+    ctx->dev[dev].read_status = STATUS_OK;
+
+    return publish_values(ctx, client, sample, p->data, p->len);
+}
+
+MqttStatus mqtt_publish_status(MqttClient *client, const char *status)
+{
+    if (client == NULL || status == NULL) {
+        return MQTT_ERR_PUBLISH;
+    }
+
+    return mqtt_client_publish(client, "status", status,
+                              client->config->qos, 1);  /* Always retain status */
+}
+
+MqttStatus mqtt_publish_diagnostics(MqttClient *client, const MqttMetrics *metrics)
+{
+    char payload[384];
+
+    if (client == NULL || metrics == NULL) {
+        return MQTT_ERR_PUBLISH;
     }
 
-    /* Get timestamp */
-    char *t = now();
-    if (t != NULL) {
-        strncpy(sample_time, t, sizeof(sample_time) - 1);
-        sample_time[sizeof(sample_time) - 1] = '\0';
+    snprintf(payload, sizeof(payload),
+             "{\"uptime\":%u,"
+             "\"reads\":{\"total\":%u,\"success\":%u,\"failure\":%u},"
+             "\"mqtt_reconnects\":%u,"
+             "\"consecutive_errors\":%d,"
+             "\"resync\":{\"frames\":%lu,\"bytes\":%lu},"
+             "\"sched\":{\"missed\":%lu,\"cycle_ms\":%.1f,\"load\":%.1f,"
+             "\"late_max_ms\":%.1f}}",
+             mqtt_metrics_uptime(metrics),
+             metrics->read_total, metrics->read_success, metrics->read_failure,
+             metrics->mqtt_reconnect_count, metrics->consecutive_errors,
+             metrics->resync_frames, metrics->resync_bytes,
+             metrics->sched_missed, metrics->sched_cycle_ms, metrics->sched_load,
+             metrics->sched_late_max_ms);
+
+    /* Diagnostics without retain flag - current state only */
+    return mqtt_client_publish(client, "diagnostics", payload,
+                              client->config->qos, 0);
+}
+
+/*
+ * Publish to a topic of the current device: {prefix}[/{port}]/{address}/{topic}
+ */
+static MqttStatus publish_port(TempContext *ctx, MqttClient *client, const char *topic,
+                               const char *payload, int qos, int retain)
+{
+    char full_topic[MQTT_MAX_TOPIC + 192];
+    int address = ctx->dev[ctx->current].address;
+
+    if (ctx->bus_name[0] == '\0') {
+        snprintf(full_topic, sizeof(full_topic), "%s/%d/%s",
+                 ctx->config->topic_prefix, address, topic);
     } else {
-        strcpy(sample_time, "unknown");
+        snprintf(full_topic, sizeof(full_topic), "%s/%s/%d/%s",
+                 ctx->config->topic_prefix, ctx->bus_name, address, topic);
     }
 
+    return mqtt_client_publish_raw(client, full_topic, payload, qos, retain);
+}
+
+/*
+ * Filter and publish the temperature registers of the current device
+ */
+static MqttStatus publish_values(TempContext *ctx, MqttClient *client,
+                                 const Timestamp *sample, const uint8_t *p_data, int len)
+{
+    int i, rc;
+    float T[MAX_CHANNELS];
+    float T_filtered[MAX_CHANNELS];
+    Timestamp sample_time;
+    Timestamp sample_filtered;
+    char time_text[DBUF];
+    char payload[MQTT_MAX_PAYLOAD];
+    char topic[64];
+    MqttStatus status;
+    TempDevice *dev;
+    int n;
+
+    dev = &ctx->dev[ctx->current];
+    n = dev->channels;
+
+    sample_time = *sample;
+
     /* Parse temperature values */
     for (i = 0; i < n; i++) {
-        T[i] = (float)INT16(p_data[2*i+1], p_data[2*i]) / 10.0f;
+        T[i] = ERRRESP;
+        if (2*i+1 < len) {
+            T[i] = (float)INT16(p_data[2*i+1], p_data[2*i]) / 10.0f;
+        }
         /* Check for invalid readings */
         if (T[i] < MIN_TEMPERATURE || T[i] > MAX_TEMPERATURE) {
             T[i] = ERRRESP;
@@ -160,10 +418,9 @@ MqttStatus mqtt_publish_temperatures(TempContext *ctx, MqttClient *client)
 
     /* Apply median filter if enabled */
     if (ctx->config->enable_median_filter) {
-        rc = median_filter(sample_time, n, T, sample_filtered, T_filtered);
+        rc = median_filter(&sample_time, n, T, &sample_filtered, T_filtered);
         if (rc == MF_SUCCESS) {
-            strncpy(sample_time, sample_filtered, sizeof(sample_time) - 1);
-            sample_time[sizeof(sample_time) - 1] = '\0';
+            sample_time = sample_filtered;
             for (i = 0; i < n; i++) {
                 T[i] = T_filtered[i];
             }
@@ -174,10 +431,9 @@ MqttStatus mqtt_publish_temperatures(TempContext *ctx, MqttClient *client)
 
     /* Apply MAF filter if enabled */
     if (ctx->config->enable_maf_filter) {
-        rc = maf_filter(sample_time, n, T, sample_filtered, T_filtered);
+        rc = maf_filter(&sample_time, n, T, &sample_filtered, T_filtered);
         if (rc == MAF_SUCCESS) {
-            strncpy(sample_time, sample_filtered, sizeof(sample_time) - 1);
-            sample_time[sizeof(sample_time) - 1] = '\0';
+            sample_time = sample_filtered;
             for (i = 0; i < n; i++) {
                 T[i] = T_filtered[i];
             }
@@ -196,25 +452,26 @@ MqttStatus mqtt_publish_temperatures(TempContext *ctx, MqttClient *client)
             snprintf(payload, sizeof(payload), "NaN");
         }
 
-        status = mqtt_client_publish(client, topic, payload,
-                                    ctx->config->qos, ctx->config->retain);
+        status = publish_port(ctx, client, topic, payload,
+                              ctx->config->qos, ctx->config->retain);
         if (status != MQTT_OK) {
             mqtt_log_warning("Failed to publish ch%d", i + 1);
         }
     }
 
     /* Publish timestamp */
-    status = mqtt_client_publish(client, "timestamp", sample_time,
-                                ctx->config->qos, ctx->config->retain);
+    timestamp_format(&sample_time, time_text, sizeof(time_text));
+    status = publish_port(ctx, client, "timestamp", time_text,
+                          ctx->config->qos, ctx->config->retain);
     if (status != MQTT_OK) {
         mqtt_log_warning("Failed to publish timestamp");
     }
 
     /* Publish status */
-    mqtt_publish_status(client, "online");
+    publish_port(ctx, client, "status", "online", ctx->config->qos, 1);
 
     /* Log reading */
-    mqtt_log_debug("Published: %s", sample_time);
+    mqtt_log_debug("Published: %s address %d %s", ctx->port, dev->address, time_text);
     for (i = 0; i < n; i++) {
         if (T[i] != ERRRESP) {
             mqtt_log_debug("  ch%d: %.1f C", i + 1, T[i]);
@@ -226,34 +483,90 @@ MqttStatus mqtt_publish_temperatures(TempContext *ctx, MqttClient *client)
     return MQTT_OK;
 }
 
-MqttStatus mqtt_publish_status(MqttClient *client, const char *status)
+/*
+ * Write the configured corrections to devices that have not got them
+ */
+static void write_corrections(TempContext *ctx)
 {
-    if (client == NULL || status == NULL) {
-        return MQTT_ERR_PUBLISH;
+    int16_t corr[MQTT_MAX_CORRECTIONS];
+    uint16_t values[MQTT_MAX_CORRECTIONS];
+    int n, single;
+    AppStatus status;
+
+    n = mqtt_config_corrections(ctx->config, corr, MQTT_MAX_CORRECTIONS);
+    if (n <= 0) {
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        values[i] = (uint16_t)corr[i];
     }
 
-    return mqtt_client_publish(client, "status", status,
-                              client->config->qos, 1);  /* Always retain status */
+    for (int i = 0; i < ctx->n_dev; i++) {
+        TempDevice *dev = &ctx->dev[i];
+
+        if (dev->corrected) {
+            continue;
+        }
+
+        /* All channels at once, 0x06 per channel if the device rejects 0x10 */
+        status = modbus_write_registers(&ctx->modbus, dev->address, REG_CORRECTION,
+                                        (uint16_t)n, values, "write_corrections", &single);
+        if (status != STATUS_OK) {
+            mqtt_log_warning("%s: writing corrections to address %d failed: %s",
+                             ctx->port, dev->address, get_error_message(status));
+            continue;
+        }
+
+        dev->corrected = 1;
+        mqtt_log_info("%s: corrections of %d channel(s) written to address %d%s",
+                      ctx->port, n, dev->address,
+                      single ? " (one by one, 0x10 not supported)" : "");
+    }
 }
 
-MqttStatus mqtt_publish_diagnostics(MqttClient *client, const MqttMetrics *metrics)
+/*
+ * Set up the Modbus context and read requests of an open port
+ */
+static void init_modbus(TempContext *ctx, int baud)
 {
-    char payload[256];
+    modbus_ctx_init(&ctx->modbus, ctx->fd, baud);
+    modbus_ctx_set_resync(&ctx->modbus, ctx->config->resync);
+    modbus_ctx_set_adaptive_timeout(&ctx->modbus, ctx->config->timeout_min,
+                                    ctx->config->timeout_max);
+    for (int i = 0; i < ctx->n_dev; i++) {
+        packet_encode_read(&ctx->dev[i].read_req, ctx->dev[i].address, '\x03',
+                           0x0000, (uint16_t)ctx->dev[i].channels);
+    }
+}
 
-    if (client == NULL || metrics == NULL) {
-        return MQTT_ERR_PUBLISH;
+/*
+ * Finish opening a network port: no termios, no detection, no RS485 tuning
+ */
+static MqttStatus open_network(TempContext *ctx, TransportType type)
+{
+    int baud = ctx->config->baudrate;
+
+    /* Only the line behind an RTU converter sets the gaps */
+    if (baud == MQTT_BAUD_AUTO) {
+        baud = MQTT_DEFAULT_BAUDRATE;
+        if (type == TRANSPORT_RTU_TCP) {
+            mqtt_log_warning("%s: no baud rate detection through a converter, "
+                             "gaps of %d baud", ctx->port, baud);
+        }
     }
+    if (ctx->config->low_latency) {
+        mqtt_log_warning("%s: low-latency profile ignored on a network port", ctx->port);
+    }
+    init_modbus(ctx, transport_pace_baud(type, baud));
 
-    snprintf(payload, sizeof(payload),
-             "{\"uptime\":%u,"
-             "\"reads\":{\"total\":%u,\"success\":%u,\"failure\":%u},"
-             "\"mqtt_reconnects\":%u,"
-             "\"consecutive_errors\":%d}",
-             mqtt_metrics_uptime(metrics),
-             metrics->read_total, metrics->read_success, metrics->read_failure,
-             metrics->mqtt_reconnect_count, metrics->consecutive_errors);
+    mqtt_log_info("Port connected: %s (%s)", ctx->port,
+                  type == TRANSPORT_MODBUS_TCP ? "Modbus TCP" : "RTU over TCP");
 
-    /* Diagnostics without retain flag - current state only */
-    return mqtt_client_publish(client, "diagnostics", payload,
-                              client->config->qos, 0);
+    write_corrections(ctx);
+
+    if (ctx->config->auto_report) {
+        mqtt_temp_auto_report(ctx, 1);
+    }
+
+    return MQTT_OK;
 }
@@ -1,6 +1,12 @@
 /*
  * MQTT temperature publishing logic
  * V1.0/2026-01-29
+ * V1.1/2026-10-16 Modbus transactions through per-port ModbusCtx
+ * V1.2/2026-10-16 One context per port, reads driven by the poller
+ * V1.3/2026-10-16 Several devices per port
+ * V1.4/2026-10-16 Corrections written once per device
+ * V1.5/2026-10-16 Automatic report (push) mode
+ * V1.6/2026-10-16 Sample time of a pushed report from its receiver
  */
 #ifndef MQTT_PUBLISH_H
 #define MQTT_PUBLISH_H
@@ -9,13 +15,37 @@
 #include "mqtt_config.h"
 #include "mqtt_error.h"
 #include "mqtt_metrics.h"
+#include "../modbus_ctx.h"
+#include "../poller.h"
+#include "../typedef.h"
 
 /* Maximum payload size */
 #define MQTT_MAX_PAYLOAD 64
 
-/* Temperature reading context */
+/* One device on a port */
+typedef struct {
+    uint8_t address;            /* Modbus address */
+    int channels;               /* Channels to read */
+    int period_ms;              /* Read period */
+    WireFrame read_req;         /* Temperature read request, encoded once */
+    AppStatus read_status;      /* Result of the last read */
+    int corrected;              /* Corrections from the config written */
+} TempDevice;
+
+/* Temperature reading context, one per serial port */
 typedef struct {
     int fd;                     /* Serial port file descriptor */
+    char port[MQTT_MAX_PATH];   /* Serial port device */
+    char bus_name[64];          /* Topic level of the port, empty with one port */
+    ModbusCtx modbus;           /* Modbus transaction context of the port */
+    TempDevice dev[MQTT_MAX_DEVICES]; /* Devices on the port */
+    int n_dev;                  /* Number of devices */
+    int current;                /* Device of the last submitted read */
+    unsigned long resync_mark_frames; /* Bus resync counters at request start */
+    unsigned long resync_mark_bytes;
+    unsigned long resync_frames; /* Responses recovered from noise, all opens */
+    unsigned long resync_bytes;  /* Noise bytes discarded, all opens */
+    int consecutive_errors;     /* Failed reads in a row */
     const MqttConfig *config;   /* Configuration */
     int filter_initialized;     /* Filter state flag */
 } TempContext;
@@ -23,15 +53,27 @@ typedef struct {
 /**
  * Initialize temperature reading context
  *
+ * With several ports, topics of the port get an extra level with the
+ * device name: {prefix}/{port}/{address}/...
+ *
  * @param ctx Pointer to context structure
  * @param config Pointer to configuration
+ * @param port Serial port device
+ * @param several 1 if more than one port is configured
+ * @param devices Devices on the port
+ * @param n_dev Number of devices (1..MQTT_MAX_DEVICES)
  * @return MQTT_OK on success, error code on failure
  */
-MqttStatus mqtt_temp_init(TempContext *ctx, const MqttConfig *config);
+MqttStatus mqtt_temp_init(TempContext *ctx, const MqttConfig *config,
+                          const char *port, int several,
+                          const MqttDevice devices[], int n_dev);
 
 /**
  * Open serial port for temperature reading
  *
+ * Writes the configured corrections to every device that has not got
+ * them yet, all channels of a device in one transaction.
+ *
  * @param ctx Pointer to context structure
  * @return MQTT_OK on success, error code on failure
  */
@@ -45,20 +87,74 @@ MqttStatus mqtt_temp_open(TempContext *ctx);
 void mqtt_temp_close(TempContext *ctx);
 
 /**
- * Read temperatures from device and publish to MQTT
+ * Switch the automatic report of every device on the port
+ *
+ * On: register 0x00FD of each device gets its period in seconds, the
+ * device then pushes its temperatures without read requests.
+ * Off: 0, the device answers read requests again.
+ *
+ * @param ctx Pointer to context structure (port open)
+ * @param on 1 to push every period, 0 for query mode
+ * @return MQTT_OK if every device took it, error code on failure
+ */
+MqttStatus mqtt_temp_auto_report(TempContext *ctx, int on);
+
+/**
+ * Queue a temperature read of one device on the poller
+ *
+ * The callback gets the result; it hands it to mqtt_temp_finish() and
+ * then mqtt_publish_temperatures().
+ *
+ * @param ctx Pointer to temperature context (port open)
+ * @param poller Poller
+ * @param bus Bus index of the port in the poller
+ * @param dev Device index
+ * @param done Completion callback
+ * @param arg Callback argument
+ * @return MQTT_OK on success, error code on failure
+ */
+MqttStatus mqtt_temp_submit(TempContext *ctx, Poller *poller, int bus, int dev,
+                            PollerDone done, void *arg);
+
+/**
+ * Store the result of the submitted read and account for skipped noise
  *
- * Reads all configured channels, applies filters if enabled,
- * and publishes to MQTT topics:
+ * @param ctx Pointer to temperature context
+ * @param status Result from the poller
+ */
+void mqtt_temp_finish(TempContext *ctx, AppStatus status);
+
+/**
+ * Publish the temperatures of the last finished read
+ *
+ * The device is the one of the last mqtt_temp_submit(). Applies filters
+ * if enabled and publishes to MQTT topics:
  *   {prefix}/{address}/temperature/ch1 ... chN
  *   {prefix}/{address}/timestamp
  *   {prefix}/{address}/status
+ * The timestamp is when the last byte of the response was read.
  *
  * @param ctx Pointer to temperature context
  * @param client Pointer to MQTT client
- * @return MQTT_OK on success, error code on failure
+ * @return MQTT_OK on success, error code on failure (read failed)
  */
 MqttStatus mqtt_publish_temperatures(TempContext *ctx, MqttClient *client);
 
+/**
+ * Publish the temperatures of a pushed report
+ *
+ * Same topics and filters as mqtt_publish_temperatures().
+ *
+ * @param ctx Pointer to temperature context
+ * @param client Pointer to MQTT client
+ * @param dev Device index of the report's address
+ * @param p Report frame from the passive receiver
+ * @param sample Time the report was read (autoreport_time())
+ * @return MQTT_OK on success, error code on failure
+ */
+MqttStatus mqtt_publish_report(TempContext *ctx, MqttClient *client, int dev,
+                               const PACKET *p, const Timestamp *sample);
+
 /**
  * Publish device status
  *
@@ -72,7 +168,9 @@ MqttStatus mqtt_publish_status(MqttClient *client, const char *status);
  * Publish diagnostic metrics
  *
  * Publishes JSON payload to {prefix}/{address}/diagnostics:
- * {"uptime":N,"reads":{"total":N,"success":N,"failure":N},"mqtt_reconnects":N,"consecutive_errors":N}
+ * {"uptime":N,"reads":{"total":N,"success":N,"failure":N},"mqtt_reconnects":N,"consecutive_errors":N,
+ *  "resync":{"frames":N,"bytes":N},
+ *  "sched":{"missed":N,"cycle_ms":X,"load":X,"late_max_ms":X}}
  *
  * @param client Pointer to MQTT client
  * @param metrics Pointer to metrics structure
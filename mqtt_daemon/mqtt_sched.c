@@ -0,0 +1,658 @@
+/*
+ * MQTT daemon bus scheduler
+ * V1.0/2026-10-16
+ * V1.1/2026-10-16 Push mode: devices report on their own (register 0x00FD)
+ * V1.2/2026-10-16 Broker: requests of local clients between the reads
+ * V1.3/2026-10-16 io_uring backend of the poller
+ * V1.4/2026-10-16 Pushed reports timed by the read that completed them
+ * V1.5/2026-10-16 One poller for the scheduler's lifetime
+ */
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+
+#include "mqtt_sched.h"
+#include "mqtt_error.h"
+
+/* Push mode: periods a device may stay silent before a report counts as missed */
+#define SCHED_PUSH_GRACE 2
+
+/* Local function prototypes */
+static int run_push(MqttSched *s, int slice_ms, volatile sig_atomic_t *running);
+static int slice_end(MqttSched *s, int *attempted);
+static void reopen_port(SchedBus *b);
+static void push_report(uint8_t addr, const PACKET *p, void *arg);
+static void push_missed(SchedBus *b, const struct timespec *now);
+static void push_receiver(SchedBus *b);
+static void read_done(Poller *poller, int bus, AppStatus status, void *arg);
+static void client_event(Poller *poller, int fd, void *arg);
+static void client_done(Poller *poller, int bus, AppStatus status, void *arg);
+static int start_client(SchedBus *b, const struct timespec *now);
+static void start_next(SchedBus *b, const struct timespec *now);
+static int next_due(const SchedBus *b, const struct timespec *now);
+static void read_failed(SchedBus *b, AppStatus status);
+static void timespec_add_ms(struct timespec *t, long ms);
+static long long timespec_diff_us(const struct timespec *a, const struct timespec *b);
+
+void mqtt_sched_init(MqttSched *s, TempContext ports[], int n_ports,
+                     MqttClient *client, MqttMetrics *metrics)
+{
+    struct timespec now;
+    int k, i, j, rank, same;
+
+    memset(s, 0, sizeof(MqttSched));
+    s->client = client;
+    s->metrics = metrics;
+    s->n_bus = n_ports;
+    s->push = n_ports > 0 && ports[0].config->auto_report;
+    s->broker = n_ports > 0 && ports[0].config->broker;
+    if (n_ports > 0 && ports[0].config->io_uring) {
+        poller_set_backend(POLLER_URING);
+    }
+
+    /* Push mode waits with poll(), polling keeps one poller for all slices */
+    if (!s->push) {
+        s->poller_ok = poller_init(&s->poller) == STATUS_OK;
+        if (!s->poller_ok) {
+            mqtt_log_error("No poller, devices cannot be read");
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    for (k = 0; k < n_ports; k++) {
+        SchedBus *b = &s->bus[k];
+        TempContext *t = &ports[k];
+
+        b->sched = s;
+        b->temp = t;
+        b->bus = -1;
+        b->stats.since = now;
+        b->ar.fd = -1;
+        b->client = -1;
+
+        /* Socket is bound to the port name: it survives reopening the port */
+        if (s->broker) {
+            if (broker_open(&b->broker, t->config->broker_dir, t->port) == STATUS_OK) {
+                mqtt_log_info("Broker for %s listening on %s", t->port, b->broker.path);
+            } else {
+                mqtt_log_warning("No broker for %s", t->port);
+            }
+        }
+
+        /* First reports are due one period after the devices were set up */
+        if (s->push) {
+            for (i = 0; i < t->n_dev; i++) {
+                b->due[i] = now;
+                timespec_add_ms(&b->due[i], (long)t->dev[i].period_ms * SCHED_PUSH_GRACE);
+            }
+            continue;
+        }
+
+        /* Bus index k: a port that failed to open is attached when reopened */
+        if (s->poller_ok) {
+            b->bus = poller_add(&s->poller, &t->modbus);
+            if (s->broker && broker_fd(&b->broker) >= 0) {
+                poller_watch(&s->poller, broker_fd(&b->broker), client_event, b);
+            }
+        }
+
+        /* Devices with the same period start evenly spread over it */
+        for (i = 0; i < t->n_dev; i++) {
+            rank = 0;
+            same = 0;
+            for (j = 0; j < t->n_dev; j++) {
+                if (t->dev[j].period_ms == t->dev[i].period_ms) {
+                    if (j < i) {
+                        rank++;
+                    }
+                    same++;
+                }
+            }
+            b->due[i] = now;
+            timespec_add_ms(&b->due[i], (long)t->dev[i].period_ms * rank / same);
+        }
+    }
+}
+
+void mqtt_sched_close(MqttSched *s)
+{
+    if (s->poller_ok) {
+        poller_close(&s->poller);
+        s->poller_ok = 0;
+    }
+    for (int k = 0; s->broker && k < s->n_bus; k++) {
+        broker_close(&s->bus[k].broker);
+    }
+}
+
+int mqtt_sched_run(MqttSched *s, int slice_ms, volatile sig_atomic_t *running,
+                   int *attempted)
+{
+    struct timespec now, end;
+    long long wait_us, us;
+    int k, i;
+
+    *attempted = 0;
+    if (s->push) {
+        run_push(s, slice_ms, running);
+        return slice_end(s, attempted);
+    }
+
+    if (!s->poller_ok) {
+        return 0;
+    }
+
+    for (k = 0; k < s->n_bus; k++) {
+        SchedBus *b = &s->bus[k];
+
+        b->attempts = 0;
+        b->successes = 0;
+        b->busy = 0;
+    }
+    s->closing = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    end = now;
+    timespec_add_ms(&end, slice_ms);
+
+    while (*running && timespec_diff_us(&end, &now) > 0) {
+        /* Idle buses start their most urgent due read */
+        for (k = 0; k < s->n_bus; k++) {
+            if (!s->bus[k].busy) {
+                start_next(&s->bus[k], &now);
+            }
+        }
+
+        /* Sleep until the next deadline of an idle bus or the end of the slice */
+        wait_us = timespec_diff_us(&end, &now);
+        for (k = 0; k < s->n_bus; k++) {
+            SchedBus *b = &s->bus[k];
+
+            if (b->busy) {
+                continue;
+            }
+            for (i = 0; i < b->temp->n_dev; i++) {
+                us = timespec_diff_us(&b->due[i], &now);
+                if (us < wait_us) {
+                    wait_us = us;
+                }
+            }
+        }
+        if (wait_us < 0) {
+            wait_us = 0;
+        }
+
+        if (poller_run(&s->poller, (int)((wait_us + 999) / 1000)) < 0) {
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    }
+
+    /* Complete outstanding reads, start no new ones: idle buses can be reopened */
+    s->closing = 1;
+    poller_drain(&s->poller);
+
+    return slice_end(s, attempted);
+}
+
+void mqtt_sched_report(MqttSched *s, SchedSummary *sum)
+{
+    struct timespec now;
+    double window_us, mean_us, cycle_ms, load, late_avg_ms, late_max_ms;
+
+    memset(sum, 0, sizeof(SchedSummary));
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    for (int k = 0; k < s->n_bus; k++) {
+        SchedBus *b = &s->bus[k];
+        SchedStats *st = &b->stats;
+
+        window_us = (double)timespec_diff_us(&now, &st->since);
+        mean_us = st->reads > 0 ? (double)st->busy_us / st->reads : 0.0;
+        cycle_ms = mean_us * b->temp->n_dev / 1000.0;
+        load = window_us > 0 ? 100.0 * (st->busy_us + st->client_us) / window_us : 0.0;
+        late_avg_ms = st->reads > 0 ? st->late_us / 1000.0 / st->reads : 0.0;
+        late_max_ms = st->late_max_us / 1000.0;
+
+        mqtt_log_info("Bus %s: %d device(s), %lu reads, cycle %.1f ms, load %.0f %%, "
+                      "late avg %.1f ms max %.1f ms, %lu missed deadline(s)",
+                      b->temp->port, b->temp->n_dev, st->reads, cycle_ms, load,
+                      late_avg_ms, late_max_ms, st->missed);
+        if (s->broker) {
+            BrokerStats *bs = &b->broker.stats;
+
+            mqtt_log_info("Broker %s: %lu client(s), %lu request(s), %lu answered, "
+                          "%lu without response, %lu dropped, bus %.1f ms",
+                          b->temp->port, bs->clients, bs->requests, bs->replies,
+                          bs->no_reply, bs->dropped, st->client_us / 1000.0);
+            memset(bs, 0, sizeof(BrokerStats));
+        }
+
+        sum->missed += st->missed;
+        if (cycle_ms > sum->cycle_ms) {
+            sum->cycle_ms = cycle_ms;
+        }
+        if (load > sum->load) {
+            sum->load = load;
+        }
+        if (late_max_ms > sum->late_max_ms) {
+            sum->late_max_ms = late_max_ms;
+        }
+
+        memset(st, 0, sizeof(SchedStats));
+        st->since = now;
+    }
+}
+
+/*
+ * Count the reads of a slice, reopen ports where none succeeded
+ */
+static int slice_end(MqttSched *s, int *attempted)
+{
+    int k, ok = 0, tried = 0;
+
+    for (k = 0; k < s->n_bus; k++) {
+        SchedBus *b = &s->bus[k];
+        TempContext *t = b->temp;
+
+        tried += b->attempts;
+        ok += b->successes;
+
+        if (b->successes > 0) {
+            t->consecutive_errors = 0;
+            continue;
+        }
+        if (b->attempts == 0) {
+            continue;
+        }
+
+        t->consecutive_errors++;
+        mqtt_log_warning("Temperature read/publish failed on %s (%d)",
+                         t->port, t->consecutive_errors);
+
+        /* Try to reopen serial port when no device answered */
+        reopen_port(b);
+    }
+
+    *attempted = tried;
+    return ok;
+}
+
+/*
+ * Reopen the port of a bus, the poller watches the new fd
+ */
+static void reopen_port(SchedBus *b)
+{
+    MqttSched *s = b->sched;
+    TempContext *t = b->temp;
+
+    if (s->poller_ok) {
+        poller_detach(&s->poller, b->bus);  /* Before the fd is closed */
+    }
+    mqtt_temp_close(t);
+    b->ar.fd = -1;
+
+    if (mqtt_temp_open(t) != MQTT_OK) {
+        mqtt_log_error("Failed to reopen serial port %s", t->port);
+        return;
+    }
+    if (s->poller_ok && poller_attach(&s->poller, b->bus, &t->modbus) < 0) {
+        mqtt_log_error("Reopened port %s cannot be polled", t->port);
+    }
+}
+
+/*
+ * Push mode: receive reports until the end of the slice
+ */
+static int run_push(MqttSched *s, int slice_ms, volatile sig_atomic_t *running)
+{
+    struct pollfd pfd[MQTT_MAX_PORTS];
+    struct timespec now, end;
+    long long wait_us, us;
+    int k, i, rc, ms, got, frames = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    end = now;
+    timespec_add_ms(&end, slice_ms);
+
+    for (k = 0; k < s->n_bus; k++) {
+        SchedBus *b = &s->bus[k];
+
+        b->attempts = 0;
+        b->successes = 0;
+        if (b->ar.fd != b->temp->fd) {
+            push_receiver(b);  /* Port (re)opened */
+        }
+    }
+
+    while (*running && timespec_diff_us(&end, &now) > 0) {
+        /* Sleep until a report is overdue, a partial frame times out or the slice ends */
+        wait_us = timespec_diff_us(&end, &now);
+        for (k = 0; k < s->n_bus; k++) {
+            SchedBus *b = &s->bus[k];
+
+            push_missed(b, &now);
+            for (i = 0; i < b->temp->n_dev; i++) {
+                us = timespec_diff_us(&b->due[i], &now);
+                if (us < wait_us) {
+                    wait_us = us;
+                }
+            }
+
+            pfd[k].fd = b->temp->fd;  /* Negative fd: ignored by poll() */
+            pfd[k].events = POLLIN;
+            pfd[k].revents = 0;
+            ms = b->temp->fd >= 0 ? autoreport_wait_ms(&b->ar) : -1;
+            if (ms >= 0 && ms * 1000LL < wait_us) {
+                wait_us = ms * 1000LL;
+            }
+        }
+        if (wait_us < 0) {
+            wait_us = 0;
+        }
+
+        rc = poll(pfd, (nfds_t)s->n_bus, (int)((wait_us + 999) / 1000));
+        if (rc < 0 && errno != EINTR) {
+            mqtt_log_error("poll: %s", strerror(errno));
+            break;
+        }
+
+        for (k = 0; k < s->n_bus; k++) {
+            SchedBus *b = &s->bus[k];
+
+            if (b->temp->fd < 0) {
+                continue;
+            }
+            if (rc > 0 && (pfd[k].revents & (POLLERR | POLLHUP | POLLNVAL))) {
+                b->attempts++;  /* Port gone: reopened at the end of the slice */
+                mqtt_temp_close(b->temp);
+                continue;
+            }
+            got = autoreport_advance(&b->ar, rc > 0 && (pfd[k].revents & POLLIN));
+            if (got < 0) {
+                b->attempts++;
+                mqtt_temp_close(b->temp);
+                continue;
+            }
+            frames += got;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    }
+
+    return frames;
+}
+
+/*
+ * Push mode: publish a report routed to its device (receiver callback)
+ */
+static void push_report(uint8_t addr, const PACKET *p, void *arg)
+{
+    SchedBus *b = arg;
+    MqttSched *s = b->sched;
+    TempContext *t = b->temp;
+    struct timespec now;
+    Timestamp sample_time;
+    int i;
+
+    for (i = 0; i < t->n_dev && t->dev[i].address != addr; i++) {
+    }
+    if (i == t->n_dev) {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    b->due[i] = now;
+    timespec_add_ms(&b->due[i], (long)t->dev[i].period_ms * SCHED_PUSH_GRACE);
+
+    /* Bus time of the report frame and the gap behind it */
+    b->stats.reads++;
+    b->stats.busy_us += (unsigned long long)((p->len + 5) * b->ar.bus->char_time_us +
+                                             b->ar.bus->frame_gap_us);
+    b->attempts++;
+
+    autoreport_time(&b->ar, &sample_time);
+    if (mqtt_publish_report(t, s->client, i, p, &sample_time) == MQTT_OK) {
+        mqtt_metrics_read_success(s->metrics);
+        b->successes++;
+    } else {
+        mqtt_metrics_read_failure(s->metrics);
+    }
+}
+
+/*
+ * Push mode: count and publish devices whose report is overdue
+ */
+static void push_missed(SchedBus *b, const struct timespec *now)
+{
+    TempContext *t = b->temp;
+
+    for (int i = 0; i < t->n_dev; i++) {
+        if (timespec_diff_us(now, &b->due[i]) < 0) {
+            continue;
+        }
+        timespec_add_ms(&b->due[i], t->dev[i].period_ms);
+
+        b->stats.missed++;
+        b->attempts++;
+        t->current = i;
+        read_failed(b, t->fd >= 0 ? ERROR_PACKET_TIMEOUT : ERROR_PORT_INIT);
+    }
+}
+
+/*
+ * Push mode: set up the receiver of a bus and route its device addresses
+ */
+static void push_receiver(SchedBus *b)
+{
+    TempContext *t = b->temp;
+
+    autoreport_init(&b->ar, t->fd, t->modbus.bus);
+    for (int i = 0; i < t->n_dev; i++) {
+        autoreport_route(&b->ar, t->dev[i].address, push_report, b);
+    }
+}
+
+/*
+ * Publish a finished read and start the next due one at once (poller callback)
+ */
+static void read_done(Poller *poller, int bus, AppStatus status, void *arg)
+{
+    SchedBus *b = arg;
+    MqttSched *s = b->sched;
+    struct timespec now;
+
+    (void)poller;
+    (void)bus;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    b->busy = 0;
+    b->stats.busy_us += (unsigned long long)timespec_diff_us(&now, &b->started);
+
+    mqtt_temp_finish(b->temp, status);
+    if (mqtt_publish_temperatures(b->temp, s->client) == MQTT_OK) {
+        mqtt_metrics_read_success(s->metrics);
+        b->successes++;
+    } else {
+        mqtt_metrics_read_failure(s->metrics);
+    }
+
+    /* Back to back: the poller sends it as soon as the t3.5 gap is over */
+    if (!s->closing) {
+        start_next(b, &now);
+    }
+}
+
+/*
+ * Take in client requests, an idle bus starts one at once (poller callback)
+ */
+static void client_event(Poller *poller, int fd, void *arg)
+{
+    SchedBus *b = arg;
+    struct timespec now;
+
+    (void)poller;
+    (void)fd;
+
+    if (broker_advance(&b->broker) > 0 && !b->busy && !b->sched->closing) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        start_next(b, &now);
+    }
+}
+
+/*
+ * Send the response to its client and go on with the bus (poller callback)
+ */
+static void client_done(Poller *poller, int bus, AppStatus status, void *arg)
+{
+    SchedBus *b = arg;
+    struct timespec now;
+
+    (void)poller;
+    (void)bus;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    b->busy = 0;
+    b->stats.client_us += (unsigned long long)timespec_diff_us(&now, &b->started);
+
+    broker_reply(&b->broker, b->client, &b->temp->modbus, status);
+    b->client = -1;
+
+    if (!b->sched->closing) {
+        start_next(b, &now);
+    }
+}
+
+/*
+ * Start the oldest queued client request, 0 if there is none
+ */
+static int start_client(SchedBus *b, const struct timespec *now)
+{
+    const WireFrame *req;
+    int c;
+
+    while ((c = broker_next(&b->broker, &req)) >= 0) {
+        b->client_turn = 0;
+
+        /* Port closed: the client gets a gateway exception at once */
+        if (b->bus < 0 || b->temp->fd < 0 ||
+            poller_submit(&b->sched->poller, b->bus, req, client_done, b) != STATUS_OK) {
+            broker_reply(&b->broker, c, &b->temp->modbus, ERROR_PORT_INIT);
+            continue;
+        }
+
+        b->client = c;
+        b->started = *now;
+        b->busy = 1;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Start the due read with the earliest deadline, client requests take turns with reads
+ */
+static void start_next(SchedBus *b, const struct timespec *now)
+{
+    TempContext *t = b->temp;
+    long long late_us, period_us;
+    long skipped;
+    int i;
+
+    if (b->client_turn && start_client(b, now)) {
+        return;
+    }
+    b->client_turn = b->sched->broker;
+
+    while ((i = next_due(b, now)) >= 0) {
+        period_us = (long long)t->dev[i].period_ms * 1000;
+        late_us = timespec_diff_us(now, &b->due[i]);
+
+        /* A whole period late: that deadline is lost, keep the phase */
+        if (late_us >= period_us) {
+            skipped = (long)(late_us / period_us);
+            b->stats.missed += (unsigned long)skipped;
+            timespec_add_ms(&b->due[i], skipped * (long)t->dev[i].period_ms);
+        }
+        timespec_add_ms(&b->due[i], t->dev[i].period_ms);
+
+        b->attempts++;
+        b->stats.reads++;
+        b->stats.late_us += (unsigned long long)late_us;
+        if (late_us > b->stats.late_max_us) {
+            b->stats.late_max_us = (long)late_us;
+        }
+
+        t->current = i;
+        if (b->bus < 0 || t->fd < 0) {
+            read_failed(b, ERROR_PORT_INIT);
+            continue;
+        }
+
+        b->started = *now;
+        if (mqtt_temp_submit(t, &b->sched->poller, b->bus, i, read_done, b) != MQTT_OK) {
+            read_failed(b, ERROR_SEND_PACKET);
+            continue;
+        }
+        b->busy = 1;
+        return;
+    }
+
+    /* Nothing due: the bus is free for clients */
+    if (b->sched->broker) {
+        start_client(b, now);
+    }
+}
+
+/*
+ * Device with the earliest deadline that has passed, -1 if none
+ */
+static int next_due(const SchedBus *b, const struct timespec *now)
+{
+    int best = -1;
+
+    for (int i = 0; i < b->temp->n_dev; i++) {
+        if (timespec_diff_us(now, &b->due[i]) < 0) {
+            continue;
+        }
+        if (best < 0 || timespec_diff_us(&b->due[best], &b->due[i]) > 0) {
+            best = i;
+        }
+    }
+
+    return best;
+}
+
+/*
+ * Count and publish a read that could not be started
+ */
+static void read_failed(SchedBus *b, AppStatus status)
+{
+    mqtt_temp_finish(b->temp, status);
+    mqtt_publish_temperatures(b->temp, b->sched->client);
+    mqtt_metrics_read_failure(b->sched->metrics);
+}
+
+/*
+ * Add milliseconds to a timespec
+ */
+static void timespec_add_ms(struct timespec *t, long ms)
+{
+    t->tv_sec += ms / 1000;
+    t->tv_nsec += (ms % 1000) * 1000000L;
+    if (t->tv_nsec >= 1000000000L) {
+        t->tv_sec++;
+        t->tv_nsec -= 1000000000L;
+    }
+}
+
+/*
+ * Difference a - b in microseconds
+ */
+static long long timespec_diff_us(const struct timespec *a, const struct timespec *b)
+{
+    return (long long)(a->tv_sec - b->tv_sec) * 1000000LL +
+           (a->tv_nsec - b->tv_nsec) / 1000;
+}
@@ -0,0 +1,135 @@
+/*
+ * MQTT daemon bus scheduler
+ * V1.0/2026-10-16
+ * V1.1/2026-10-16 Push mode: devices report on their own (register 0x00FD)
+ * V1.2/2026-10-16 Broker: requests of local clients between the reads
+ *
+ * Polls many devices on each serial port: every device has its own
+ * channel count and period, the device whose deadline is earliest goes
+ * next, and a bus never waits longer than the t3.5 gap between reads.
+ * All ports run in parallel through one poller.
+ *
+ * In push mode no requests are sent: a passive receiver per bus routes
+ * the reports by address, and a device silent for two periods counts as
+ * a missed deadline.
+ *
+ * With the broker enabled every port listens on a Unix socket; requests
+ * of clients (r4dcb08 CLI) and due reads take turns on the bus, so a
+ * client waits for one read at most and polling goes on.
+ */
+#ifndef MQTT_SCHED_H
+#define MQTT_SCHED_H
+
+#include <signal.h>
+#include <time.h>
+
+#include "mqtt_client.h"
+#include "mqtt_config.h"
+#include "mqtt_metrics.h"
+#include "mqtt_publish.h"
+#include "../poller.h"
+#include "../autoreport.h"
+#include "../broker.h"
+
+typedef struct MqttSched MqttSched;
+
+/* Scheduler statistics of one bus (since the last report) */
+typedef struct {
+    unsigned long reads;            /* Reads started */
+    unsigned long missed;           /* Deadlines passed by a whole period before the read */
+    unsigned long long busy_us;     /* Time with a read outstanding */
+    unsigned long long client_us;   /* Time with a client request outstanding */
+    unsigned long long late_us;     /* Sum of start delays after the deadline */
+    long late_max_us;               /* Longest start delay */
+    struct timespec since;          /* Start of the statistics window */
+} SchedStats;
+
+/* Scheduler state of one bus */
+typedef struct {
+    MqttSched *sched;                       /* Owning scheduler */
+    TempContext *temp;                      /* Port and its devices */
+    struct timespec due[MQTT_MAX_DEVICES];  /* Next deadline of each device (push mode:
+                                               latest time for its next report) */
+    struct timespec started;                /* Start of the outstanding read */
+    int bus;                                /* Poller bus index, -1 = not in poller */
+    int busy;                               /* Read outstanding */
+    int attempts;                           /* Reads in the current slice */
+    int successes;                          /* Successful reads in the current slice */
+    SchedStats stats;                       /* Statistics */
+    AutoReport ar;                          /* Push mode: receiver, fd -1 = set up again */
+    Broker broker;                          /* Broker: socket of the port */
+    int client;                             /* Broker client on the bus, -1 = none */
+    int client_turn;                        /* A queued client request goes next */
+} SchedBus;
+
+/* Bus scheduler */
+struct MqttSched {
+    SchedBus bus[MQTT_MAX_PORTS];   /* Buses */
+    int n_bus;                      /* Number of buses */
+    Poller poller;                  /* Poller of all slices, ports swapped on reopen */
+    int poller_ok;                  /* Poller created */
+    int closing;                    /* Slice over: finish reads, start no new ones */
+    int push;                       /* Devices push reports, nothing is polled */
+    int broker;                     /* Ports serve local clients */
+    MqttClient *client;             /* Client to publish results */
+    MqttMetrics *metrics;           /* Read counters */
+};
+
+/* Scheduler summary over all buses for diagnostics */
+typedef struct {
+    unsigned long missed;           /* Missed deadlines */
+    double cycle_ms;                /* Longest time to read every device of a bus once */
+    double load;                    /* Highest bus utilization [%] */
+    double late_max_ms;             /* Longest start delay */
+} SchedSummary;
+
+/**
+ * Initialize scheduler
+ *
+ * Deadlines of devices with the same period are spread evenly over the
+ * period, so their reads do not pile up in one burst. The poller is
+ * created once, with every port as a bus. With the broker enabled the
+ * socket of every port is opened.
+ *
+ * @param s Scheduler
+ * @param ports Temperature contexts of the ports (initialized)
+ * @param n_ports Number of ports
+ * @param client MQTT client
+ * @param metrics Read counters
+ */
+void mqtt_sched_init(MqttSched *s, TempContext ports[], int n_ports,
+                     MqttClient *client, MqttMetrics *metrics);
+
+/**
+ * Close the poller and the broker sockets (before the ports are closed)
+ *
+ * @param s Scheduler
+ */
+void mqtt_sched_close(MqttSched *s);
+
+/**
+ * Run reads and publish results for one time slice
+ *
+ * Reads outstanding at the end of the slice are completed before it
+ * returns. Ports whose reads all failed in the slice are reopened.
+ * In push mode every report and every missed report counts as a read.
+ * Client requests are not counted.
+ *
+ * @param s Scheduler
+ * @param slice_ms Length of the slice
+ * @param running Cleared by the signal handler to stop early
+ * @param attempted Pointer to store the number of reads in the slice
+ * @return Number of successful reads in the slice
+ */
+int mqtt_sched_run(MqttSched *s, int slice_ms, volatile sig_atomic_t *running,
+                   int *attempted);
+
+/**
+ * Log per-bus statistics, summarize them and start a new window
+ *
+ * @param s Scheduler
+ * @param sum Pointer to store the summary over all buses
+ */
+void mqtt_sched_report(MqttSched *s, SchedSummary *sum);
+
+#endif /* MQTT_SCHED_H */
@@ -1,15 +1,78 @@
 /*
  *  Current date and time in ISO 8601 format
+ *  V1.1/2026-10-16 Binary sample timestamps, formatted only for output
+ *  V1.2/2026-10-16 Cached local time, only the changed digits rewritten
+ *  V1.3/2026-10-16 Sample time taken by the transport (request write, last byte)
  */
 #include <stdlib.h>   /* Standard lib */
 #include <stdio.h>    /* Standard input/output definitions */
 #include <time.h>     /* Time function */
-#include <sys/time.h> /* Time function */
 #include <string.h>   /* String functions */
 #include <errno.h>    /* Error numbers and messages */
+#include <inttypes.h> /* PRId64 */
+#include <pthread.h>  /* pthread_mutex */
+#include <sys/stat.h> /* stat */
 
 #include "now.h" /* DBUF definition */
 
+/* Length of "YYYY-MM-DD HH:MM:SS" */
+#define ISO_SECONDS_LEN 19
+
+/* Zone file used when TZ is not set */
+#define ZONE_FILE "/etc/localtime"
+
+/* Format of timestamp_format(), set once at startup */
+static TimestampFormat ts_format = TS_ISO;
+
+/*
+ * Local time of the minute last formatted by this thread. Within a minute
+ * the UTC offset cannot change (zone transitions fall on whole minutes),
+ * so only the seconds digits are rewritten. Per thread, so bus workers
+ * and the logger format without a lock.
+ */
+typedef struct {
+    time_t base;                      /* Second the text was made for */
+    int base_sec;                     /* Its seconds field */
+    unsigned gen;                     /* Zone generation it was made with */
+    char text[ISO_SECONDS_LEN + 1];   /* YYYY-MM-DD HH:MM:SS */
+} LocalCache;
+
+static _Thread_local LocalCache cache;
+
+/* Zone seen by the last check: TZ and the zone file; gen counts changes */
+static pthread_mutex_t zone_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned zone_gen = 0;
+static char zone_tz[128];
+static struct timespec zone_mtime;
+static ino_t zone_ino;
+
+/*
+ *  Local function prototypes
+ */
+static int format_iso(int64_t real_ns, int centis, char *buffer, size_t buffer_len);
+static unsigned zone_check(void);
+
+/**********************************************************************/
+
+/**
+ * Thread-safe version that writes to a caller-provided buffer
+ *
+ * @param buffer     Output buffer for timestamp
+ * @param buffer_len Size of the output buffer
+ * @return           0 on success, -1 on error
+ */
+int now_r(char *buffer, size_t buffer_len)
+{
+    struct timespec t;
+
+    if (buffer == NULL || buffer_len < 6) {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &t);
+    return format_iso((int64_t)t.tv_sec * 1000000000 + t.tv_nsec, 1, buffer, buffer_len);
+}
+
 /**
  * Returns current date and time in ISO 8601 format.
  * Not thread-safe due to static buffer usage.
@@ -18,43 +81,188 @@
  */
 char *now(void)
 {
-    struct tm ts_buf;        /* Time structure */
-    struct tm *ts = &ts_buf; /* Pointer to time structure */
     static char buf[DBUF];   /* Text variable for timestamp */
-    struct timeval now_val;  /* Argument for gettimeofday */
-    size_t len;              /* Length of formatted string */
 
-    /* Clear buffer to ensure null termination */
-    memset(buf, 0, sizeof(buf));
+    return now_r(buf, sizeof(buf)) == 0 ? buf : NULL;
+}
+
+/*
+ *  Take the time of a sample
+ */
+void timestamp_now(Timestamp *ts)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    ts->mono_ns = (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+    clock_gettime(CLOCK_REALTIME, &t);
+    ts->real_ns = (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+    ts->sent_ns = 0;
+}
+
+/*
+ *  Take the time of a sample measured earlier
+ */
+void timestamp_at(Timestamp *ts, int64_t mono_ns, int64_t sent_ns)
+{
+    Timestamp now;
+
+    timestamp_now(&now);
+    ts->mono_ns = mono_ns;
+    ts->real_ns = now.real_ns - (now.mono_ns - mono_ns);
+    ts->sent_ns = sent_ns;
+}
+
+/*
+ *  Select the format of timestamp_format()
+ */
+void timestamp_set_format(TimestampFormat fmt)
+{
+    ts_format = fmt;
+}
+
+/*
+ *  Get the format for a name
+ */
+int timestamp_parse_format(const char *name, TimestampFormat *fmt)
+{
+    if (strcmp(name, "iso") == 0) {
+        *fmt = TS_ISO;
+    } else if (strcmp(name, "ms") == 0) {
+        *fmt = TS_EPOCH_MS;
+    } else if (strcmp(name, "ns") == 0) {
+        *fmt = TS_EPOCH_NS;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ *  Format the wall clock time of a sample in the selected format
+ */
+int timestamp_format(const Timestamp *ts, char *buffer, size_t buffer_len)
+{
+    int n;
 
-    /* Get current time with error handling */
-    if (gettimeofday(&now_val, NULL) == -1) {
-        fprintf(stderr, "now: Error calling gettimeofday: %s\n", strerror(errno));
-        return NULL;
+    if (buffer == NULL || buffer_len < 8) {
+        return -1;
+    }
+    if (ts == NULL || ts->real_ns == 0) {
+        strcpy(buffer, "unknown");
+        return 0;
     }
 
-    /* Convert seconds to time structure with thread-safe function */
-    ts = localtime_r(&now_val.tv_sec, &ts_buf);
-    if (ts == NULL) {
-        fprintf(stderr, "now: Error in localtime_r: %s\n", strerror(errno));
-        return NULL;
+    switch (ts_format) {
+        case TS_EPOCH_MS:
+            n = snprintf(buffer, buffer_len, "%" PRId64, ts->real_ns / 1000000);
+            break;
+        case TS_EPOCH_NS:
+            n = snprintf(buffer, buffer_len, "%" PRId64, ts->real_ns);
+            break;
+        default:
+            return format_iso(ts->real_ns, 1, buffer, buffer_len);
     }
 
-    /* Format time with error checking */
-    len = strftime(buf, sizeof(buf) - 5, "%Y-%m-%d %H:%M:%S", ts);
-    if (len == 0 || len >= sizeof(buf) - 5) {
-        fprintf(stderr, "now: Error formatting time, buffer too small or format error\n");
-        return NULL;
+    return n > 0 && (size_t)n < buffer_len ? 0 : -1;
+}
+
+/*
+ *  Format a wall clock time as local time
+ */
+int timestamp_local(int64_t real_ns, int centis, char *buffer, size_t buffer_len)
+{
+    if (buffer == NULL) {
+        return -1;
     }
+    return format_iso(real_ns, centis, buffer, buffer_len);
+}
 
-    /* Add centiseconds with boundary checking */
-    unsigned int centisec = (unsigned int)(now_val.tv_usec / 10000);
-    int result = snprintf(buf + len, sizeof(buf) - len, ".%02u", centisec);
-    
-    if (result < 0 || result >= (int)(sizeof(buf) - len)) {
-        fprintf(stderr, "now: Error adding centiseconds, buffer too small\n");
-        return NULL;
+/* Local functions */
+
+/*
+ *  Local time YYYY-MM-DD HH:MM:SS[.CC]
+ */
+static int format_iso(int64_t real_ns, int centis, char *buffer, size_t buffer_len)
+{
+    LocalCache *c = &cache;
+    time_t sec = (time_t)(real_ns / 1000000000);
+    struct tm ts_buf;        /* Time structure */
+    unsigned gen;
+    long s;
+
+    if (buffer_len < (size_t)ISO_SECONDS_LEN + (centis ? 4 : 1)) {
+        fprintf(stderr, "now: Error formatting time, buffer too small\n");
+        return -1;
+    }
+
+    /* Same minute as the cached text: just the seconds digits */
+    s = c->base_sec + (long)(sec - c->base);
+    gen = __atomic_load_n(&zone_gen, __ATOMIC_ACQUIRE);
+    if (c->text[0] != '\0' && sec >= c->base && s < 60 && c->gen == gen) {
+        c->text[17] = (char)('0' + s / 10);
+        c->text[18] = (char)('0' + s % 10);
+    } else {
+        /* New minute: the zone may have changed since the last one */
+        gen = zone_check();
+        if (localtime_r(&sec, &ts_buf) == NULL) {
+            fprintf(stderr, "now: Error in localtime_r: %s\n", strerror(errno));
+            return -1;
+        }
+        if (strftime(c->text, sizeof(c->text), "%Y-%m-%d %H:%M:%S", &ts_buf) != ISO_SECONDS_LEN) {
+            c->text[0] = '\0';
+            fprintf(stderr, "now: Error formatting time, year out of range\n");
+            return -1;
+        }
+        c->base = sec;
+        c->base_sec = ts_buf.tm_sec;
+        c->gen = gen;
+    }
+
+    memcpy(buffer, c->text, ISO_SECONDS_LEN);
+    if (centis) {
+        unsigned int centisec = (unsigned int)(real_ns % 1000000000 / 10000000);
+        buffer[ISO_SECONDS_LEN] = '.';
+        buffer[ISO_SECONDS_LEN + 1] = (char)('0' + centisec / 10);
+        buffer[ISO_SECONDS_LEN + 2] = (char)('0' + centisec % 10);
+        buffer[ISO_SECONDS_LEN + 3] = '\0';
+    } else {
+        buffer[ISO_SECONDS_LEN] = '\0';
+    }
+
+    return 0;
+}
+
+/*
+ *  Reload the zone (tzset) if TZ or the zone file changed, return its generation
+ */
+static unsigned zone_check(void)
+{
+    const char *tz;
+    struct stat st;
+    int changed = 0;
+    unsigned gen;
+
+    pthread_mutex_lock(&zone_lock);
+
+    tz = getenv("TZ");
+    if (strncmp(zone_tz, tz != NULL ? tz : "", sizeof(zone_tz)) != 0) {
+        snprintf(zone_tz, sizeof(zone_tz), "%s", tz != NULL ? tz : "");
+        changed = 1;
+    }
+    if (stat(ZONE_FILE, &st) == 0 &&
+        (st.st_ino != zone_ino || st.st_mtim.tv_sec != zone_mtime.tv_sec ||
+         st.st_mtim.tv_nsec != zone_mtime.tv_nsec)) {
+        zone_ino = st.st_ino;
+        zone_mtime = st.st_mtim;
+        changed = 1;
+    }
+    if (changed || zone_gen == 0) {
+        tzset();
+        __atomic_store_n(&zone_gen, zone_gen + 1, __ATOMIC_RELEASE);
     }
+    gen = zone_gen;
 
-    return buf;
+    pthread_mutex_unlock(&zone_lock);
+    return gen;
 }
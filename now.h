@@ -1,18 +1,56 @@
 /*
  *  Date and time in ISO 8601 format
+ *  V1.1/2026-10-16 Binary sample timestamps, formatted only for output
+ *  V1.2/2026-10-16 Cached local time, only the changed digits rewritten
+ *  V1.3/2026-10-16 Sample time taken by the transport (request write, last byte)
+ *
+ *  A sample carries a Timestamp: CLOCK_MONOTONIC for arithmetic (periods,
+ *  latencies, never steps) and CLOCK_REALTIME for the wall clock, both in
+ *  64-bit nanoseconds. Text is made only where it is printed or published,
+ *  in the format chosen with timestamp_set_format().
+ *
+ *  A polled sample is timed by the transport, not by its reader: mono_ns
+ *  is when the last response byte was read and sent_ns when the request
+ *  was written, so neither includes the host's processing afterwards.
+ *
+ *  Local time is made with localtime_r()/strftime() once a minute per
+ *  thread; the seconds and centiseconds digits are written straight into
+ *  the cached text. The zone (TZ, /etc/localtime) is checked at those
+ *  minute boundaries and reloaded with tzset() only when it changed.
  */
 #ifndef NOW_H
 #define NOW_H
 
+#include <stddef.h> /* For size_t */
+#include <stdint.h> /* For int64_t */
+
 /**
  * Maximum length of timestamp buffer
  * Must accommodate "YYYY-MM-DD HH:MM:SS.CC" plus null terminator
  */
 #define DBUF 64
 
+/**
+ * Time of a sample
+ */
+typedef struct {
+    int64_t mono_ns;         /* CLOCK_MONOTONIC [ns], last response byte if polled */
+    int64_t real_ns;         /* CLOCK_REALTIME [ns since the epoch] */
+    int64_t sent_ns;         /* CLOCK_MONOTONIC [ns] the request was written, 0 = none */
+} Timestamp;
+
+/**
+ * Text format of timestamps
+ */
+typedef enum {
+    TS_ISO = 0,              /* Local time YYYY-MM-DD HH:MM:SS.CC */
+    TS_EPOCH_MS = 1,         /* Milliseconds since the epoch */
+    TS_EPOCH_NS = 2          /* Nanoseconds since the epoch */
+} TimestampFormat;
+
 /**
  * Returns current date and time in ISO 8601 format (YYYY-MM-DD HH:MM:SS.CC)
- * 
+ *
  * WARNING: This function is not thread-safe as it returns a pointer
  * to a static buffer. Copy the result if needed for later use.
  *
@@ -30,4 +68,61 @@ extern char *now(void);
  */
 extern int now_r(char *buffer, size_t buffer_len);
 
+/**
+ * Take the time of a sample
+ *
+ * @param ts Pointer to store both clocks
+ */
+extern void timestamp_now(Timestamp *ts);
+
+/**
+ * Take the time of a sample measured earlier
+ *
+ * The wall clock is set back by the CLOCK_MONOTONIC time passed since.
+ *
+ * @param ts      Pointer to store both clocks
+ * @param mono_ns CLOCK_MONOTONIC time of the sample [ns]
+ * @param sent_ns CLOCK_MONOTONIC time its request was written [ns], 0 = none
+ */
+extern void timestamp_at(Timestamp *ts, int64_t mono_ns, int64_t sent_ns);
+
+/**
+ * Select the format of timestamp_format() (default TS_ISO)
+ *
+ * @param fmt Format
+ */
+extern void timestamp_set_format(TimestampFormat fmt);
+
+/**
+ * Get the format for a name
+ *
+ * @param name "iso", "ms" or "ns"
+ * @param fmt  Pointer to store the format
+ * @return     0 on success, -1 for an unknown name
+ */
+extern int timestamp_parse_format(const char *name, TimestampFormat *fmt);
+
+/**
+ * Format the wall clock time of a sample in the selected format
+ *
+ * @param ts         Timestamp (NULL or real_ns 0 gives "unknown")
+ * @param buffer     Output buffer, DBUF bytes are always enough
+ * @param buffer_len Size of the output buffer
+ * @return           0 on success, -1 on error
+ */
+extern int timestamp_format(const Timestamp *ts, char *buffer, size_t buffer_len);
+
+/**
+ * Format a wall clock time as local time YYYY-MM-DD HH:MM:SS[.CC]
+ *
+ * Thread-safe, each thread keeps its own cache.
+ *
+ * @param real_ns    CLOCK_REALTIME [ns since the epoch]
+ * @param centis     Non-zero to append centiseconds
+ * @param buffer     Output buffer (20 bytes, 23 with centiseconds)
+ * @param buffer_len Size of the output buffer
+ * @return           0 on success, -1 on error
+ */
+extern int timestamp_local(int64_t real_ns, int centis, char *buffer, size_t buffer_len);
+
 #endif /* NOW_H */
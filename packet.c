@@ -3,6 +3,24 @@
  *  V1.0/2025-01-30
  *  V1.1/2025-03-28 Adaptation for R4DCB08 device
  *  V1.2/2025-04-16 Code improvements and robustness enhancements
+ *  V1.3/2026-10-16 CRC moved to table-driven crc16 module
+ *  V1.4/2026-10-16 Single-pass frame assembler with t3.5 silence detection
+ *  V1.5/2026-10-16 Baud-aware inter-frame gap instead of fixed 8 ms delay
+ *  V1.6/2026-10-16 Bus timing in BusTiming, reentrant packet_send/packet_receive
+ *  V1.7/2026-10-16 Requests encoded straight into a wire buffer
+ *  V1.8/2026-10-16 Non-blocking receive state machine (PacketReceiver)
+ *  V1.9/2026-10-16 Resync mode matching the outstanding request
+ *  V1.10/2026-10-16 Adaptive per-device response timeouts
+ *  V1.11/2026-10-16 packet_bus_idle_us() for event loops
+ *  V1.12/2026-10-16 Host latency per bus instead of fixed 16 ms
+ *  V1.13/2026-10-16 Write Multiple Registers (0x10) request encoder
+ *  V1.14/2026-10-16 Response timeout of the fd-based API settable (broker link)
+ *  V1.15/2026-10-16 Frames sent and received through the transport layer
+ *  V1.16/2026-10-16 Send and receive halves for I/O done by the caller (io_uring)
+ *  V1.17/2026-10-16 Time of the request write and of the last response byte kept
+ *  V1.18/2026-10-16 Input flushed in front of every request
+ *  V1.19/2026-10-16 Raw frame of a finished receiver
+ *  V1.20/2026-10-16 Modbus TCP transaction released when the receiver finishes
  */
 #include <stdio.h>   /* Standard input/output definitions */
 #include <stdlib.h>  /* Standard library */
@@ -10,14 +28,18 @@
 #include <stdint.h>  /* Specific width integer types */
 #include <string.h>  /* String functions */
 #include <errno.h>   /* Error numbers */
+#include <sys/select.h> /* select() */
+#include <time.h>    /* clock_gettime, nanosleep */
 
 #include "typedef.h" /* Data type definitions */
 #include "packet.h"  /* Global function declarations */
+#include "crc16.h"   /* CRC engine */
+#include "frame.h"   /* Frame assembler */
+#include "serial.h"  /* Frame gap timing */
+#include "transport.h" /* Serial, RTU over TCP, Modbus TCP */
 
 /* Configuration constants */
-#define READ_TIMEOUT_MS    500   /* Timeout for reading operations in milliseconds */
-#define MIN_PACKET_SIZE    4     /* Minimum valid packet size: ADDR + FUNC + CRC(2) */
-#define MAX_PACKET_SIZE    (DMAX + 4) /* Maximum valid packet size */
+#define DEFAULT_BAUDRATE   9600  /* Baud rate until a bus timing is initialized */
 
 /* Error messages */
 #define ERR_INVALID_LENGTH "Invalid data length"
@@ -26,128 +48,434 @@
 #define ERR_DATA_OVERFLOW  "Data length exceeds maximum"
 #define ERR_WRITE_FAILED   "Failed to write packet to port"
 
+/* Bus timing for the fd-based API, one per thread */
+static _Thread_local BusTiming default_bus;
+static _Thread_local int default_bus_ready;
+static _Thread_local RttTable default_rtt;
+static _Thread_local int default_timeout_ms = PACKET_READ_TIMEOUT_MS;
+
 /*
  *  Local function prototypes
  */
-static uint16_t CRC16_2(const uint8_t *buf, int len);
-static int read_with_timeout(int fd, uint8_t *buffer, int size, int timeout_ms);
+static int wait_readable(int fd, long timeout_us);
+static void timespec_add_us(struct timespec *t, long us);
+static long timespec_diff_us(const struct timespec *a, const struct timespec *b);
+static void bus_mark_activity(BusTiming *bus, long extra_us);
+static void bus_wait_idle(BusTiming *bus);
+static AppStatus check_wire(const BusTiming *bus, const WireFrame *wf, const char *msg);
+static void bus_mark_sent(BusTiming *bus, const WireFrame *wf, long delay_us);
+static PacketRxState rx_finish(PacketReceiver *rx, FrameState fstate, AppStatus status);
+static void rx_report_error(const PacketReceiver *rx, const char *msg);
+static AppStatus parse_frame(const FrameAssembler *fa, PACKET *p_RP);
 static AppStatus received_packet_internal(int fd, PACKET *p_RP, int mode,
                                           int timeout_ms, int quiet);
 
 /**********************************************************************/
 
 /*
- *  Receive a packet from the device (internal implementation)
+ *  Initialize bus timing for the given baud rate
  */
-static AppStatus received_packet_internal(int fd, PACKET *p_RP, int mode,
-                                          int timeout_ms, int quiet)
+void bus_timing_init(BusTiming *bus, int baud)
 {
-    const char *msg = "received_packet";
-    uint8_t buf[MAX_PACKET_SIZE];
-    int bytes_read = 0;
-    int total_length = 0;
-    uint16_t crc_calculated;
-    int i;
+    memset(bus, 0, sizeof(BusTiming));
+    bus->frame_gap_us = serial_frame_gap_us(baud);
+    bus->char_time_us = serial_char_time_us(baud);
+    bus->host_latency_us = PACKET_HOST_LATENCY_US;
+}
 
-    /* Validate input parameters */
-    if (p_RP == NULL) {
-        if (!quiet) fprintf(stderr, "%s: NULL packet pointer\n", msg);
-        return ERROR_PACKET_NULL;
+/*
+ *  Get bus timing used by the fd-based API in this thread
+ */
+BusTiming *packet_default_bus(void)
+{
+    if (!default_bus_ready) {  /* Modbus TCP sets a gap of 0 */
+        bus_timing_init(&default_bus, DEFAULT_BAUDRATE);
+        default_bus_ready = 1;
     }
+    return &default_bus;
+}
 
-    if (mode < 0 || mode >= RECEIVE_MODE_MAX) {
-        if (!quiet) fprintf(stderr, "%s: %s (%d)\n", msg, ERR_INVALID_MODE, mode);
-        return ERROR_PACKET_MODE;
+/*
+ *  Set baud rate used for inter-frame silence detection
+ */
+void packet_set_baudrate(int baud)
+{
+    BusTiming *bus = packet_default_bus();
+
+    bus->frame_gap_us = serial_frame_gap_us(baud);
+    bus->char_time_us = serial_char_time_us(baud);
+}
+
+/*
+ *  Set response timeout of the fd-based API
+ */
+void packet_set_timeout(int timeout_ms)
+{
+    default_timeout_ms = timeout_ms > 0 ? timeout_ms : PACKET_READ_TIMEOUT_MS;
+}
+
+/*
+ *  Get response timeout of the fd-based API
+ */
+int packet_default_timeout_ms(void)
+{
+    return default_timeout_ms;
+}
+
+/*
+ *  Enable or disable resync mode
+ */
+void packet_set_resync(int enable)
+{
+    packet_default_bus()->resync = enable;
+}
+
+/*
+ *  Set the gap the host may add inside a received frame
+ */
+void packet_set_host_latency(long us)
+{
+    packet_default_bus()->host_latency_us = us > 0 ? us : PACKET_HOST_LATENCY_US;
+}
+
+/*
+ *  Enable adaptive per-device response timeouts
+ */
+void packet_set_adaptive_timeout(int floor_ms, int ceiling_ms)
+{
+    BusTiming *bus = packet_default_bus();
+
+    if (floor_ms <= 0) {
+        bus->rtt = NULL;
+        return;
     }
 
-    /* Read first byte (address) */
-    bytes_read = read_with_timeout(fd, buf, 1, timeout_ms);
-    if (bytes_read != 1) {
-        if (!quiet) fprintf(stderr, "%s: Timeout waiting for address byte\n", msg);
-        return ERROR_PACKET_TIMEOUT;
+    rtt_init(&default_rtt, floor_ms, ceiling_ms);
+    bus->rtt = &default_rtt;
+}
+
+/*
+ *  Get bus timing statistics
+ */
+void packet_get_bus_stats(PacketBusStats *stats)
+{
+    if (stats != NULL) {
+        *stats = default_bus.stats;
     }
+}
 
-    /* Determine expected packet length based on mode */
-    if (mode == RECEIVE_MODE_TEMPERATURE) {
-        /* Read function code + length */
-        bytes_read = read_with_timeout(fd, buf + 1, 2, timeout_ms);
-        if (bytes_read != 2) {
-            if (!quiet) fprintf(stderr, "%s: Timeout waiting for function and length bytes\n", msg);
-            return ERROR_PACKET_TIMEOUT;
-        }
+/*
+ *  Reset bus timing statistics
+ */
+void packet_reset_bus_stats(void)
+{
+    memset(&default_bus.stats, 0, sizeof(default_bus.stats));
+}
 
-        /* Calculate total expected length */
-        total_length = buf[2] + 5; /* ADDR + FUNC + LEN + DATA + CRC(2) */
+/*
+ *  Start receiving one frame
+ */
+void packet_rx_start(PacketReceiver *rx, int fd, BusTiming *bus, int timeout_ms)
+{
+    /* Adaptive timeout once the device has answered */
+    if (bus->rtt != NULL && bus->req_func != 0) {
+        timeout_ms = rtt_timeout_ms(bus->rtt, bus->req_addr, timeout_ms);
+    }
 
-        /* Validate expected length */
-        if (total_length < MIN_PACKET_SIZE || total_length > MAX_PACKET_SIZE) {
-            if (!quiet) fprintf(stderr, "%s: %s, invalid total length: %d\n",
-                    msg, ERR_INVALID_LENGTH, total_length);
-            return ERROR_PACKET_OVERFLOW;
-        }
+    rx->fd = fd;
+    rx->tid = bus->req_tid;
+    rx->bus = bus;
+    rx->timeout_us = timeout_ms * 1000L;
+    rx->state = PACKET_RX_NEED_MORE;
+    rx->fstate = FRAME_NEED_MORE;
+    rx->status = STATUS_OK;
+    rx->sys_errno = 0;
+    rx->latency_us = -1;
+    rx->sent = bus->req_sent;
+    rx->last_byte.tv_sec = 0;
+    rx->last_byte.tv_nsec = 0;
+    frame_reset(&rx->fa);
+
+    /* Resync: only the answer to the outstanding request may start a frame */
+    if (bus->resync && bus->req_func != 0) {
+        frame_expect(&rx->fa, bus->req_addr, bus->req_func, bus->req_resp_len);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &rx->started);
+    rx->deadline = rx->started;
+    timespec_add_us(&rx->deadline, rx->timeout_us);
+}
+
+/*
+ *  Move a receiver whose request goes out later
+ */
+void packet_rx_delay(PacketReceiver *rx, long us)
+{
+    timespec_add_us(&rx->started, us);
+    timespec_add_us(&rx->deadline, us);
+}
+
+/*
+ *  Advance the receiver
+ *
+ *  Reads whatever is available straight into the assembler. The frame is
+ *  complete when the length derived from the function code is reached;
+ *  for function codes of unknown shape the frame ends at t3.5 silence.
+ */
+PacketRxState packet_rx_advance(PacketReceiver *rx, int readable)
+{
+    FrameAssembler *fa = &rx->fa;
+    struct timespec now;
+    uint8_t *tail;
+    int room;
+    int result;
+    FrameState fstate;
+
+    if (rx->state != PACKET_RX_NEED_MORE) {
+        return rx->state;
+    }
 
-        /* Read remaining data and CRC */
-        bytes_read = read_with_timeout(fd, buf + 3, total_length - 3, timeout_ms);
-        if (bytes_read != total_length - 3) {
-            if (!quiet) fprintf(stderr, "%s: %s, expected %d bytes, got %d\n",
-                    msg, ERR_INVALID_LENGTH, total_length - 3, bytes_read);
-            return ERROR_PACKET_TIMEOUT;
+    /* Response already taken off a shared connection by another reader */
+    if (!readable && transport_pending(rx->fd, rx->tid)) {
+        readable = 1;
+    }
+
+    if (!readable) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (timespec_diff_us(&rx->deadline, &now) > 0) {
+            return PACKET_RX_NEED_MORE;  /* Deadline not reached yet */
+        }
+        if (fa->expected == 0 && fa->len >= 2) {
+            fstate = frame_finish(fa);
+            return rx_finish(rx, fstate, STATUS_OK);
         }
+        return rx_finish(rx, FRAME_NEED_MORE, ERROR_PACKET_TIMEOUT);
     }
-    else if (mode == RECEIVE_MODE_ACKNOWLEDGE) {
-        /* Read remaining 7 bytes for acknowledge packet */
-        bytes_read = read_with_timeout(fd, buf + 1, 7, timeout_ms);
-        if (bytes_read != 7) {
-            if (!quiet) fprintf(stderr, "%s: %s, expected 7 bytes, got %d\n",
-                    msg, ERR_INVALID_LENGTH, bytes_read);
-            return ERROR_PACKET_TIMEOUT;
+
+    /* Data available, read all of it */
+    tail = frame_tail(fa, &room);
+    if (room == 0) {
+        return rx_finish(rx, FRAME_ERR_OVERFLOW, STATUS_OK);
+    }
+
+    result = transport_read(rx->fd, rx->tid, tail, room);
+
+    return packet_rx_commit(rx, result < 0 ? -errno : result);
+}
+
+/*
+ *  Get the buffer the next bytes of the frame go to
+ */
+uint8_t *packet_rx_buffer(PacketReceiver *rx, int *room)
+{
+    return frame_tail(&rx->fa, room);
+}
+
+/*
+ *  Advance the receiver with bytes the caller read into packet_rx_buffer()
+ */
+PacketRxState packet_rx_commit(PacketReceiver *rx, int result)
+{
+    FrameAssembler *fa = &rx->fa;
+    struct timespec now;
+    long silence_us;
+    FrameState fstate;
+
+    if (rx->state != PACKET_RX_NEED_MORE) {
+        return rx->state;
+    }
+
+    if (result < 0) {
+        if (result == -EAGAIN || result == -EWOULDBLOCK || result == -EINTR) {
+            return PACKET_RX_NEED_MORE;
         }
-        total_length = 8;  /* Fixed length for acknowledge packet */
+        rx->sys_errno = -result;
+        return rx_finish(rx, FRAME_NEED_MORE, ERROR_RECEIVE_PACKET);
+    }
+    if (result == 0) {
+        return rx_finish(rx, FRAME_NEED_MORE, ERROR_PACKET_TIMEOUT);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    rx->last_byte = now;
+    if (rx->latency_us < 0) {
+        rx->latency_us = timespec_diff_us(&now, &rx->started);
+    }
+
+    fstate = frame_commit(fa, result);
+    if (fstate != FRAME_NEED_MORE) {
+        return rx_finish(rx, fstate, STATUS_OK);
+    }
+
+    /* Unknown frame shape: the end of frame is t3.5 silence */
+    silence_us = rx->bus->frame_gap_us + rx->bus->host_latency_us;
+    rx->deadline = now;
+    if (fa->len >= 2 && fa->expected == 0) {
+        timespec_add_us(&rx->deadline, silence_us);
+    } else {
+        /* A short adaptive timeout must not split a frame in USB bursts */
+        timespec_add_us(&rx->deadline, rx->timeout_us > silence_us ?
+                                       rx->timeout_us : silence_us);
+    }
+
+    return PACKET_RX_NEED_MORE;
+}
+
+/*
+ *  Get file descriptor the receiver waits on
+ */
+int packet_rx_fd(const PacketReceiver *rx)
+{
+    return rx->fd;
+}
+
+/*
+ *  Get CLOCK_MONOTONIC time of the next receiver deadline
+ */
+const struct timespec *packet_rx_deadline(const PacketReceiver *rx)
+{
+    return &rx->deadline;
+}
+
+/*
+ *  Get milliseconds until the next deadline (for poll()/epoll_wait())
+ */
+int packet_rx_wait_ms(const PacketReceiver *rx)
+{
+    struct timespec now;
+    long us;
+
+    if (transport_pending(rx->fd, rx->tid)) {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    us = timespec_diff_us(&rx->deadline, &now);
+
+    return us > 0 ? (int)((us + 999) / 1000) : 0;
+}
+
+/*
+ *  Decode the frame of a finished receiver
+ */
+AppStatus packet_rx_packet(const PacketReceiver *rx, PACKET *p_RP)
+{
+    if (rx->state == PACKET_RX_NEED_MORE) {
+        return ERROR_PACKET_TIMEOUT;
+    }
+    if (rx->state == PACKET_RX_ERROR) {
+        return rx->status;
     }
 
-    /* Extract packet fields */
+    return parse_frame(&rx->fa, p_RP);
+}
+
+/*
+ *  Raw frame of a finished receiver
+ */
+const uint8_t *packet_rx_frame(const PacketReceiver *rx, int *len)
+{
+    *len = rx->state == PACKET_RX_COMPLETE ? rx->fa.expected : 0;
+    return rx->fa.buf;
+}
+
+/*
+ *  Extract packet fields from a complete frame
+ *
+ *  The layout follows the function code: register data for reads,
+ *  register value/count for write echoes, exception code for exceptions.
+ */
+static AppStatus parse_frame(const FrameAssembler *fa, PACKET *p_RP)
+{
+    const uint8_t *buf = fa->buf;
+    int total = fa->expected;
+    int offset;
+    int i;
+
     p_RP->addr = buf[0];
     p_RP->inst = buf[1];
+    p_RP->CRC = UINT16(buf[total - 2], buf[total - 1]);
+
+    if (p_RP->inst & 0x80) {
+        p_RP->len = 1;         /* Exception code */
+        offset = 2;
+    } else if (p_RP->inst == 0x03 || p_RP->inst == 0x04) {
+        p_RP->len = buf[2];    /* Byte count */
+        offset = 3;
+    } else if (p_RP->inst == 0x06 || p_RP->inst == 0x10) {
+        p_RP->len = 2;         /* Register value / count */
+        offset = 4;
+    } else {
+        p_RP->len = (uint8_t)(total - 4);
+        offset = 2;
+    }
 
-    if (mode == RECEIVE_MODE_TEMPERATURE) {
-        p_RP->len = buf[2];
-        /* Copy data bytes */
-        for (i = 0; i < p_RP->len && i < DMAX; i++) {
-            p_RP->data[i] = buf[i + 3];
-        }
-        /* Extract CRC */
-        p_RP->CRC = UINT16(buf[total_length - 2], buf[total_length - 1]);
+    for (i = 0; i < p_RP->len && i < DMAX; i++) {
+        p_RP->data[i] = buf[i + offset];
+    }
+
+    return (p_RP->inst & 0x80) ? ERROR_PACKET_EXCEPTION : STATUS_OK;
+}
+
+/*
+ *  Receive and decode one frame, blocking until done
+ */
+AppStatus packet_receive(int fd, BusTiming *bus, PacketReceiver *rx,
+                         PACKET *p_RP, int timeout_ms, int quiet)
+{
+    const char *msg = "received_packet";
+    PacketRxState state;
+    AppStatus status;
+    int result;
 
-        /* Verify CRC */
-        crc_calculated = CRC16_2(buf, p_RP->len + 3);
+    /* Validate input parameters */
+    if (p_RP == NULL || bus == NULL || rx == NULL) {
+        if (!quiet) fprintf(stderr, "%s: NULL packet pointer\n", msg);
+        return ERROR_PACKET_NULL;
     }
-    else { /* RECEIVE_MODE_ACKNOWLEDGE */
-        p_RP->len = 2;  /* Fixed data length for acknowledge */
-        /* Copy data bytes - position is different for acknowledge packets */
-        for (i = 0; i < p_RP->len && i < DMAX; i++) {
-            p_RP->data[i] = buf[i + 4];
+
+    packet_rx_start(rx, fd, bus, timeout_ms);
+
+    do {
+        result = wait_readable(fd, packet_rx_wait_ms(rx) * 1000L);
+        if (result < 0) {
+            if (!quiet) fprintf(stderr, "%s: select error: %s\n", msg, strerror(errno));
+            bus_mark_activity(bus, 0);
+            return ERROR_RECEIVE_PACKET;
         }
-        /* Extract CRC */
-        p_RP->CRC = UINT16(buf[total_length - 2], buf[total_length - 1]);
+        state = packet_rx_advance(rx, result > 0);
+    } while (state == PACKET_RX_NEED_MORE);
 
-        /* Verify CRC */
-        crc_calculated = CRC16_2(buf, p_RP->len + 4);
+    if (state == PACKET_RX_ERROR) {
+        if (!quiet) rx_report_error(rx, msg);
+        return rx->status;
     }
 
-    /* Check if calculated CRC matches received CRC */
-    if (crc_calculated != p_RP->CRC) {
-        if (!quiet) {
-            fprintf(stderr, "%s: %s, calculated: 0x%04X, received: 0x%04X\n",
-                    msg, ERR_CRC_MISMATCH, crc_calculated, p_RP->CRC);
-            print_packet(p_RP);
-        }
-        return ERROR_PACKET_CRC;
+    status = packet_rx_packet(rx, p_RP);
+    if (status == ERROR_PACKET_EXCEPTION && !quiet) {
+        fprintf(stderr, "%s: Device exception 0x%02X (function 0x%02X)\n",
+                msg, p_RP->data[0], p_RP->inst & 0x7F);
     }
 
-    /* Small delay to ensure stable operation */
-    usleep((useconds_t)(8000));
+    return status;
+}
 
-    return STATUS_OK;
+/*
+ *  Receive a packet from the device (internal implementation)
+ */
+static AppStatus received_packet_internal(int fd, PACKET *p_RP, int mode,
+                                          int timeout_ms, int quiet)
+{
+    const char *msg = "received_packet";
+    PacketReceiver rx;
+
+    /* Mode is only validated; frame shape follows the function code */
+    if (mode < 0 || mode >= RECEIVE_MODE_MAX) {
+        if (!quiet) fprintf(stderr, "%s: %s (%d)\n", msg, ERR_INVALID_MODE, mode);
+        return ERROR_PACKET_MODE;
+    }
+
+    return packet_receive(fd, packet_default_bus(), &rx, p_RP, timeout_ms, quiet);
 }
 
 /*
@@ -155,7 +483,7 @@ static AppStatus received_packet_internal(int fd, PACKET *p_RP, int mode,
  */
 AppStatus received_packet(int fd, PACKET *p_RP, int mode)
 {
-    return received_packet_internal(fd, p_RP, mode, READ_TIMEOUT_MS, 0);
+    return received_packet_internal(fd, p_RP, mode, default_timeout_ms, 0);
 }
 
 /*
@@ -168,51 +496,218 @@ AppStatus received_packet_timeout(int fd, PACKET *p_RP, int mode,
 }
 
 /*
- *  Send a packet to the device
+ *  Start encoding a request in a wire buffer
  */
-AppStatus send_packet(int fd, PACKET *p_SP, int *bytes_sent)
+uint8_t *packet_encode_begin(WireFrame *wf, uint8_t addr, uint8_t inst)
 {
-    const char *msg = "send_packet";
-    uint8_t buf[MAX_PACKET_SIZE];
-    int i;
+    wf->buf[0] = addr;
+    wf->buf[1] = inst;
+    wf->len = 0;
+    return wf->buf + 2;
+}
 
-    /* Validate input parameters */
-    if (p_SP == NULL) {
-        fprintf(stderr, "%s: NULL packet pointer\n", msg);
-        return ERROR_PACKET_NULL;
+/*
+ *  Finish a request by appending CRC
+ */
+AppStatus packet_encode_end(WireFrame *wf, int len)
+{
+    uint16_t crc;
+
+    if (len < 0 || len > DMAX) {
+        fprintf(stderr, "packet_encode: %s (%d > %d)\n", ERR_DATA_OVERFLOW, len, DMAX);
+        wf->len = 0;
+        return ERROR_PACKET_OVERFLOW;
     }
 
-    if (p_SP->len > DMAX) {
-        fprintf(stderr, "%s: %s (%u > %d)\n", msg, ERR_DATA_OVERFLOW, p_SP->len, DMAX);
+    crc = crc16_modbus(wf->buf, (size_t)len + 2);
+    wf->buf[len + 2] = (crc & 0xFF);         /* CRC_lo */
+    wf->buf[len + 3] = ((crc >> 8) & 0xFF);  /* CRC_hi */
+    wf->len = len + 4;
+
+    return STATUS_OK;
+}
+
+/*
+ *  Encode a request from a payload buffer
+ */
+AppStatus packet_encode(WireFrame *wf, uint8_t addr, uint8_t inst,
+                        const uint8_t *p_data, int len)
+{
+    uint8_t *payload = packet_encode_begin(wf, addr, inst);
+
+    if (len > 0 && len <= DMAX && p_data != NULL) {
+        memcpy(payload, p_data, (size_t)len);
+    }
+
+    return packet_encode_end(wf, len);
+}
+
+/*
+ *  Encode a register read request
+ */
+void packet_encode_read(WireFrame *wf, uint8_t addr, uint8_t inst,
+                        uint16_t reg, uint16_t count)
+{
+    uint8_t *payload = packet_encode_begin(wf, addr, inst);
+
+    /* Register address (2 byte) + Read number (2 byte), big endian */
+    payload[0] = (uint8_t)(reg >> 8);
+    payload[1] = (uint8_t)(reg & 0xFF);
+    payload[2] = (uint8_t)(count >> 8);
+    payload[3] = (uint8_t)(count & 0xFF);
+
+    packet_encode_end(wf, 4);
+}
+
+/*
+ *  Encode a Write Multiple Registers request (function 0x10)
+ */
+AppStatus packet_encode_write_multiple(WireFrame *wf, uint8_t addr, uint16_t reg,
+                                       uint16_t count, const uint16_t *values)
+{
+    uint8_t *payload = packet_encode_begin(wf, addr, 0x10);
+    int i;
+
+    if (count < 1 || count > PACKET_WRITE_MAX || values == NULL) {
+        fprintf(stderr, "packet_encode_write_multiple: %s (%d registers)\n",
+                ERR_DATA_OVERFLOW, count);
+        wf->len = 0;
         return ERROR_PACKET_OVERFLOW;
     }
 
-    /* Assemble packet */
-    buf[0] = p_SP->addr;  /* Address */
-    buf[1] = p_SP->inst;  /* Instruction */
-    
-    /* Copy data */
-    for (i = 0; i < p_SP->len && i < DMAX; i++) {
-        buf[i + 2] = p_SP->data[i];
+    /* Register address (2 byte) + Count (2 byte) + Byte count + Values, big endian */
+    payload[0] = (uint8_t)(reg >> 8);
+    payload[1] = (uint8_t)(reg & 0xFF);
+    payload[2] = (uint8_t)(count >> 8);
+    payload[3] = (uint8_t)(count & 0xFF);
+    payload[4] = (uint8_t)(2 * count);
+    for (i = 0; i < count; i++) {
+        payload[5 + 2 * i] = (uint8_t)(values[i] >> 8);
+        payload[6 + 2 * i] = (uint8_t)(values[i] & 0xFF);
     }
-    
-    /* Add CRC */
-    buf[p_SP->len + 2] = (p_SP->CRC & 0xFF);     /* CRC_lo */
-    buf[p_SP->len + 3] = ((p_SP->CRC >> 8) & 0xFF); /* CRC_hi */
+
+    return packet_encode_end(wf, 5 + 2 * count);
+}
+
+/*
+ *  Send an encoded request, keeping t3.5 silence after the previous frame
+ */
+AppStatus packet_send_wire(int fd, BusTiming *bus, const WireFrame *wf)
+{
+    const char *msg = "send_packet";
+    AppStatus status = check_wire(bus, wf, msg);
+
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    /* Stale bytes would be taken for the start of the response */
+    packet_flush_input(fd, bus);
+
+    /* Keep t3.5 silence after the previous frame */
+    bus_wait_idle(bus);
 
     /* Write packet to device */
-    if (write(fd, buf, p_SP->len + 4) < 0) {
+    if (transport_write(fd, wf->buf, wf->len, &bus->req_tid) < 0) {
         fprintf(stderr, "%s: %s (errno: %d, %s)\n", 
                 msg, ERR_WRITE_FAILED, errno, strerror(errno));
         return ERROR_PACKET_WRITE;
     }
-    
+
+    bus_mark_sent(bus, wf, 0);
+
+    return STATUS_OK;
+}
+
+/*
+ *  Discard input of a bus with no request out
+ */
+int packet_flush_input(int fd, BusTiming *bus)
+{
+    int n = transport_flush(fd);
+
+    if (n > 0) {
+        bus->stats.stray_bytes += (unsigned long)n;
+        bus_mark_activity(bus, 0);
+    }
+
+    return n;
+}
+
+/*
+ *  Account for a request the caller writes itself
+ */
+AppStatus packet_send_queued(BusTiming *bus, const WireFrame *wf, long delay_us)
+{
+    AppStatus status = check_wire(bus, wf, "send_packet");
+
+    if (status == STATUS_OK) {
+        bus->req_tid = 0;
+        bus_mark_sent(bus, wf, delay_us);
+    }
+
+    return status;
+}
+
+/*
+ *  Get time until the bus has been silent for t3.5
+ */
+long packet_bus_idle_us(const BusTiming *bus)
+{
+    struct timespec now;
+    long remaining_us;
+
+    if (bus->last_activity.tv_sec == 0 && bus->last_activity.tv_nsec == 0) {
+        return 0;  /* Nothing sent or received yet */
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    remaining_us = bus->frame_gap_us - timespec_diff_us(&now, &bus->last_activity);
+
+    return remaining_us > 0 ? remaining_us : 0;
+}
+
+/*
+ *  Send a packet, keeping t3.5 silence after the previous frame
+ */
+AppStatus packet_send(int fd, BusTiming *bus, const PACKET *p_SP)
+{
+    const char *msg = "send_packet";
+    WireFrame wf;
+
+    /* Validate input parameters */
+    if (p_SP == NULL || bus == NULL) {
+        fprintf(stderr, "%s: NULL packet pointer\n", msg);
+        return ERROR_PACKET_NULL;
+    }
+
+    if (p_SP->len > DMAX) {
+        fprintf(stderr, "%s: %s (%u > %d)\n", msg, ERR_DATA_OVERFLOW, p_SP->len, DMAX);
+        return ERROR_PACKET_OVERFLOW;
+    }
+
+    /* Assemble packet, CRC as formed by form_packet() */
+    memcpy(packet_encode_begin(&wf, p_SP->addr, p_SP->inst), p_SP->data, p_SP->len);
+    wf.buf[p_SP->len + 2] = (p_SP->CRC & 0xFF);         /* CRC_lo */
+    wf.buf[p_SP->len + 3] = ((p_SP->CRC >> 8) & 0xFF);  /* CRC_hi */
+    wf.len = p_SP->len + 4;
+
+    return packet_send_wire(fd, bus, &wf);
+}
+
+/*
+ *  Send a packet to the device
+ */
+AppStatus send_packet(int fd, PACKET *p_SP, int *bytes_sent)
+{
+    AppStatus status = packet_send(fd, packet_default_bus(), p_SP);
+
     /* Store bytes sent if requested */
-    if (bytes_sent != NULL) {
+    if (status == STATUS_OK && bytes_sent != NULL) {
         *bytes_sent = p_SP->len;
     }
-    
-    return STATUS_OK;
+
+    return status;
 }
 
 /*
@@ -221,9 +716,8 @@ AppStatus send_packet(int fd, PACKET *p_SP, int *bytes_sent)
 void form_packet(uint8_t addr, uint8_t inst, uint8_t *p_data,
                  int len, PACKET *p_Packet)
 {
-    uint8_t buf[MAX_PACKET_SIZE];
+    const uint8_t header[2] = { addr, inst };
     uint16_t crc_calculated;
-    int i;
     
     /* Validate input parameters */
     if (p_Packet == NULL || p_data == NULL || len < 0 || len > DMAX) {
@@ -236,18 +730,12 @@ void form_packet(uint8_t addr, uint8_t inst, uint8_t *p_data,
     p_Packet->inst = inst;
     p_Packet->len = len;
     
-    /* Assemble buffer for CRC calculation */
-    buf[0] = addr;
-    buf[1] = inst;
-    
     /* Copy data */
-    for (i = 0; i < len; i++) {
-        p_Packet->data[i] = p_data[i];
-        buf[i + 2] = p_data[i];
-    }
+    memcpy(p_Packet->data, p_data, (size_t)len);
     
-    /* Calculate and set CRC */
-    crc_calculated = CRC16_2(buf, len + 2);
+    /* Calculate and set CRC, no scratch copy of the frame */
+    crc_calculated = crc16_update(CRC16_INIT, header, 2);
+    crc_calculated = crc16_update(crc_calculated, p_data, (size_t)len);
     p_Packet->CRC = crc_calculated;
 }
 
@@ -277,86 +765,204 @@ void print_packet(PACKET *p_P)
 /* Local functions */
 
 /*
- *  Calculate Modbus CRC16
+ *  Remember when the bus was last busy
  */
-static uint16_t CRC16_2(const uint8_t *buf, int len)
-{ 
-    uint16_t crc = 0xFFFF;
-    
-    /* Validate input parameters */
-    if (buf == NULL || len <= 0) {
-        return 0;
+static void bus_mark_activity(BusTiming *bus, long extra_us)
+{
+    clock_gettime(CLOCK_MONOTONIC, &bus->last_activity);
+    timespec_add_us(&bus->last_activity, extra_us);
+}
+
+/*
+ *  Add microseconds to a time
+ */
+static void timespec_add_us(struct timespec *t, long us)
+{
+    t->tv_nsec += (us % 1000000L) * 1000L;
+    t->tv_sec += us / 1000000L + t->tv_nsec / 1000000000L;
+    t->tv_nsec %= 1000000000L;
+}
+
+/*
+ *  Difference a - b in microseconds
+ */
+static long timespec_diff_us(const struct timespec *a, const struct timespec *b)
+{
+    return (a->tv_sec - b->tv_sec) * 1000000L + (a->tv_nsec - b->tv_nsec) / 1000L;
+}
+
+/*
+ *  Close the receiver with the final frame state or error
+ */
+static PacketRxState rx_finish(PacketReceiver *rx, FrameState fstate, AppStatus status)
+{
+    rx->fstate = fstate;
+
+    if (status == STATUS_OK) {
+        switch (fstate) {
+            case FRAME_COMPLETE:
+                break;
+            case FRAME_ERR_CRC:
+                status = ERROR_PACKET_CRC;
+                break;
+            case FRAME_ERR_OVERFLOW:
+                status = ERROR_PACKET_OVERFLOW;
+                break;
+            default:
+                status = ERROR_PACKET_TIMEOUT;
+                break;
+        }
     }
-    
-    for (int pos = 0; pos < len; pos++) {
-        crc ^= (uint16_t)buf[pos];    /* XOR byte into least sig. byte of crc */
 
-        for (int i = 8; i != 0; i--) {    /* Loop over each bit */
-            if ((crc & 0x0001) != 0) {    /* If the LSB is set */
-                crc >>= 1;                /* Shift right and XOR 0xA001 */
-                crc ^= 0xA001;
-            }
-            else {                        /* Else LSB is not set */
-                crc >>= 1;                /* Just shift right */
-            }
+    rx->status = status;
+    rx->state = (status == STATUS_OK) ? PACKET_RX_COMPLETE : PACKET_RX_ERROR;
+
+    /* A timed out or broken response must not hold its Modbus TCP slot */
+    if (rx->state == PACKET_RX_ERROR) {
+        transport_release(rx->fd, rx->tid);
+    }
+
+    /* Round-trip statistics of the device (adaptive timeouts) */
+    if (rx->bus->rtt != NULL && rx->bus->req_func != 0) {
+        if (rx->latency_us >= 0) {
+            rtt_sample(rx->bus->rtt, rx->bus->req_addr, rx->latency_us);
+        } else if (status == ERROR_PACKET_TIMEOUT) {
+            rtt_timeout(rx->bus->rtt, rx->bus->req_addr);
         }
     }
-    
-    return crc;
+
+    if (rx->fa.discarded > 0) {
+        rx->bus->stats.resync_bytes += (unsigned long)rx->fa.discarded;
+        if (status == STATUS_OK) {
+            rx->bus->stats.resync_frames++;
+        }
+    }
+
+    /* The line is busy until the last byte, t3.5 counts from here */
+    bus_mark_activity(rx->bus, 0);
+
+    return rx->state;
 }
 
 /*
- *  Read data with timeout
+ *  Print why the receiver failed
  */
-static int read_with_timeout(int fd, uint8_t *buffer, int size, int timeout_ms)
+static void rx_report_error(const PacketReceiver *rx, const char *msg)
+{
+    const FrameAssembler *fa = &rx->fa;
+    int total = fa->expected;
+
+    switch (rx->status) {
+        case ERROR_RECEIVE_PACKET:
+            fprintf(stderr, "%s: read error: %s\n", msg, strerror(rx->sys_errno));
+            break;
+        case ERROR_PACKET_CRC:
+            fprintf(stderr, "%s: %s, calculated: 0x%04X, received: 0x%04X\n",
+                    msg, ERR_CRC_MISMATCH, crc16_modbus(fa->buf, total - 2),
+                    UINT16(fa->buf[total - 2], fa->buf[total - 1]));
+            break;
+        case ERROR_PACKET_OVERFLOW:
+            fprintf(stderr, "%s: %s, invalid total length: %d\n",
+                    msg, ERR_INVALID_LENGTH, fa->expected ? fa->expected : fa->len);
+            break;
+        default:
+            if (fa->len == 0) {
+                fprintf(stderr, "%s: Timeout waiting for address byte\n", msg);
+            } else if (rx->fstate == FRAME_ERR_SHORT) {
+                fprintf(stderr, "%s: %s, frame too short (%d bytes)\n",
+                        msg, ERR_INVALID_LENGTH, fa->len);
+            } else {
+                fprintf(stderr, "%s: %s, expected %d bytes, got %d\n",
+                        msg, ERR_INVALID_LENGTH, fa->expected, fa->len);
+            }
+            break;
+    }
+}
+
+/*
+ *  Sleep until t3.5 has passed since the last bus activity
+ */
+static void bus_wait_idle(BusTiming *bus)
+{
+    struct timespec ts;
+    long remaining_us;
+
+    remaining_us = packet_bus_idle_us(bus);
+    if (remaining_us <= 0) {
+        return;
+    }
+
+    ts.tv_sec = remaining_us / 1000000L;
+    ts.tv_nsec = (remaining_us % 1000000L) * 1000L;
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {
+        /* Restart with remaining time */
+    }
+
+    bus->stats.gap_waits++;
+    bus->stats.gap_wait_us += (unsigned long long)remaining_us;
+}
+
+/*
+ *  Validate a request frame before it is sent
+ */
+static AppStatus check_wire(const BusTiming *bus, const WireFrame *wf, const char *msg)
+{
+    if (wf == NULL || bus == NULL) {
+        fprintf(stderr, "%s: NULL packet pointer\n", msg);
+        return ERROR_PACKET_NULL;
+    }
+
+    if (wf->len < FRAME_MIN_SIZE || wf->len > PACKET_WIRE_SIZE) {
+        fprintf(stderr, "%s: %s (%d)\n", msg, ERR_INVALID_LENGTH, wf->len);
+        return ERROR_PACKET_OVERFLOW;
+    }
+
+    return STATUS_OK;
+}
+
+/*
+ *  Book a request as sent (delay_us from now)
+ */
+static void bus_mark_sent(BusTiming *bus, const WireFrame *wf, long delay_us)
+{
+    /* A queued request is written delay_us from now */
+    clock_gettime(CLOCK_MONOTONIC, &bus->req_sent);
+    timespec_add_us(&bus->req_sent, delay_us);
+
+    /* write() returns before the last byte is on the wire */
+    bus->last_activity = bus->req_sent;
+    timespec_add_us(&bus->last_activity, wf->len * bus->char_time_us);
+    bus->stats.frames_sent++;
+
+    /* Remember what the next response must look like (resync mode) */
+    bus->req_addr = wf->buf[0];
+    bus->req_func = wf->buf[1];
+    bus->req_resp_len = frame_response_length(wf->buf, wf->len - 2);
+}
+
+/*
+ *  Wait until the port is readable
+ *  Returns 1 if readable, 0 on timeout, -1 on error
+ */
+static int wait_readable(int fd, long timeout_us)
 {
     fd_set readfds;
     struct timeval tv;
-    int bytes_read = 0;
     int result;
-    
-    /* Validate input parameters */
-    if (buffer == NULL || size <= 0) {
-        return 0;
-    }
-    
-    while (bytes_read < size) {
-        /* Set up for select */
-        FD_ZERO(&readfds);
-        FD_SET(fd, &readfds);
-        
-        /* Set timeout */
-        tv.tv_sec = timeout_ms / 1000;
-        tv.tv_usec = (timeout_ms % 1000) * 1000;
-        
-        /* Wait for data or timeout */
+
+    FD_ZERO(&readfds);
+    FD_SET(fd, &readfds);
+
+    tv.tv_sec = timeout_us / 1000000L;
+    tv.tv_usec = timeout_us % 1000000L;
+
+    do {
         result = select(fd + 1, &readfds, NULL, NULL, &tv);
-        
-        if (result < 0) {
-            /* Error in select */
-            fprintf(stderr, "read_with_timeout: select error: %s\n", strerror(errno));
-            return bytes_read;
-        } 
-        else if (result == 0) {
-            /* Timeout */
-            return bytes_read;
-        }
-        
-        /* Data available, read it */
-        result = read(fd, buffer + bytes_read, size - bytes_read);
-        
-        if (result < 0) {
-            /* Read error */
-            fprintf(stderr, "read_with_timeout: read error: %s\n", strerror(errno));
-            return bytes_read;
-        } 
-        else if (result == 0) {
-            /* End of file */
-            return bytes_read;
-        }
-        
-        bytes_read += result;
+    } while (result < 0 && errno == EINTR && tv.tv_sec + tv.tv_usec > 0);
+
+    if (result < 0 && errno == EINTR) {
+        return 0;
     }
-    
-    return bytes_read;
+
+    return result > 0 ? 1 : result;
 }
@@ -1,16 +1,61 @@
 /*
  *  Functions for packet handling in Modbus RTU protocol
  *  V1.2/2025-04-16
+ *  V1.3/2026-10-16 Single-pass frame assembler
+ *  V1.4/2026-10-16 Baud-aware inter-frame gap and bus statistics
+ *  V1.5/2026-10-16 Reentrant packet_send/packet_receive with caller-owned state
+ *  V1.6/2026-10-16 Requests encoded straight into a wire buffer
+ *  V1.7/2026-10-16 Non-blocking receive state machine
+ *  V1.8/2026-10-16 Resync mode for noisy buses
+ *  V1.9/2026-10-16 Adaptive per-device response timeouts
+ *  V1.10/2026-10-16 Remaining inter-frame gap for event loops
+ *  V1.11/2026-10-16 Per-bus host latency
+ *  V1.12/2026-10-16 Write Multiple Registers (0x10) encoder
+ *  V1.13/2026-10-16 Settable response timeout (fd-based API)
+ *  V1.14/2026-10-16 Frames sent and received through the transport layer
+ *  V1.15/2026-10-16 Send and receive halves for I/O done by the caller (io_uring)
+ *  V1.16/2026-10-16 Receiver records when the request went out and the last byte came in
+ *  V1.17/2026-10-16 Input of an idle bus flushed, never read as a response
+ *  V1.18/2026-10-16 Raw frame of a finished receiver
  */
 #ifndef PACKET_H
 #define PACKET_H
 
 #include <stdint.h>  /* For uint8_t, uint16_t */
+#include <time.h>    /* For struct timespec */
 #include "typedef.h" /* For PACKET definition */
 #include "error.h"   /* For AppStatus */
+#include "frame.h"   /* For FrameAssembler */
+#include "rtt.h"     /* For RttTable */
+
+/* Default response timeout in milliseconds */
+#define PACKET_READ_TIMEOUT_MS 500
+
+/* Most registers in one Write Multiple Registers request (Modbus limit) */
+#define PACKET_WRITE_MAX 123
+
+/* Default gap the host may add inside a frame (FTDI latency timer, 16 ms) */
+#define PACKET_HOST_LATENCY_US 16000
+
+/* Largest request on the wire: ADDR + FUNC + DATA(DMAX) + CRC(2) */
+#define PACKET_WIRE_SIZE (DMAX + 4)
+
+/**
+ * Request encoded as it goes on the wire, CRC included
+ *
+ * Fixed requests (e.g. periodic temperature reads) can be encoded once
+ * and sent any number of times.
+ */
+typedef struct {
+    uint8_t buf[PACKET_WIRE_SIZE]; /* ADDR, FUNC, DATA..., CRC_lo, CRC_hi */
+    int len;                       /* Total length, 0 = not encoded */
+} WireFrame;
 
 /**
  * Receive mode definitions
+ *
+ * Kept for API compatibility: the frame shape is derived from the
+ * function code of the response, so one receive path handles all modes.
  */
 typedef enum {
     RECEIVE_MODE_TEMPERATURE = 0,  /* Packet from temperature read */
@@ -18,13 +63,401 @@ typedef enum {
     RECEIVE_MODE_MAX
 } ReceiveMode;
 
+/**
+ * Bus timing statistics
+ */
+typedef struct {
+    unsigned long frames_sent;      /* Frames written to the bus */
+    unsigned long gap_waits;        /* Sends delayed to keep t3.5 silence */
+    unsigned long long gap_wait_us; /* Total time spent in those delays */
+    unsigned long resync_frames;    /* Responses found behind noise (resync mode) */
+    unsigned long resync_bytes;     /* Noise bytes discarded (resync mode) */
+    unsigned long stray_bytes;      /* Bytes flushed while no request was out */
+} PacketBusStats;
+
+/**
+ * Timing state of one bus (one serial port)
+ */
+typedef struct {
+    long frame_gap_us;              /* t3.5 silence at the bus baud rate */
+    long char_time_us;              /* Time of one character on the wire */
+    long host_latency_us;           /* Gap the host adds inside a frame (USB bursts) */
+    struct timespec last_activity;  /* CLOCK_MONOTONIC time the bus was last busy */
+    struct timespec req_sent;       /* CLOCK_MONOTONIC time the last request was written */
+    int resync;                     /* Scan for the expected response in noise */
+    uint8_t req_addr;               /* Address of the outstanding request */
+    uint8_t req_func;               /* Function code of the outstanding request */
+    int req_resp_len;               /* Expected response length, 0 = unknown */
+    uint16_t req_tid;               /* Transaction ID of the outstanding request (Modbus TCP) */
+    RttTable *rtt;                  /* Adaptive timeouts, NULL = fixed */
+    PacketBusStats stats;           /* Gap and resync statistics */
+} BusTiming;
+
+/**
+ * Receiver state returned by packet_rx_advance()
+ */
+typedef enum {
+    PACKET_RX_NEED_MORE = 0,  /* Frame not complete, keep waiting */
+    PACKET_RX_COMPLETE = 1,   /* Frame complete with valid CRC */
+    PACKET_RX_ERROR = -1      /* Timeout, CRC or read error, see status */
+} PacketRxState;
+
+/**
+ * Non-blocking receiver of one response frame
+ *
+ * Lets a poll/epoll loop drive many transactions at once: wait for
+ * packet_rx_fd() to become readable or for packet_rx_deadline(), then
+ * call packet_rx_advance().
+ */
+typedef struct {
+    int fd;                    /* File descriptor of the serial port */
+    uint16_t tid;              /* Transaction ID of the request (Modbus TCP) */
+    BusTiming *bus;            /* Bus timing of the port */
+    FrameAssembler fa;         /* Frame being received */
+    long timeout_us;           /* Response and inter-byte timeout */
+    struct timespec started;   /* CLOCK_MONOTONIC time the receiver started */
+    struct timespec sent;      /* CLOCK_MONOTONIC time the request was written */
+    struct timespec last_byte; /* CLOCK_MONOTONIC time the last byte was read, 0 = none */
+    long latency_us;           /* Time to first response byte, -1 = none yet */
+    struct timespec deadline;  /* CLOCK_MONOTONIC time of next timeout */
+    PacketRxState state;       /* Current state */
+    FrameState fstate;         /* Final assembler state */
+    AppStatus status;          /* Result once state is not NEED_MORE */
+    int sys_errno;             /* errno of a failed read() */
+} PacketReceiver;
+
+/**
+ * Initialize bus timing for the given baud rate
+ *
+ * @param bus   Pointer to bus timing
+ * @param baud  Baud rate of the serial port
+ */
+extern void bus_timing_init(BusTiming *bus, int baud);
+
+/**
+ * Get bus timing used by the fd-based API (one instance per thread)
+ *
+ * @return Pointer to thread's default bus timing
+ */
+extern BusTiming *packet_default_bus(void);
+
+/**
+ * Send a packet, keeping t3.5 silence after the previous frame
+ *
+ * Reentrant: all state is in the caller-owned bus timing.
+ *
+ * @param fd    File descriptor of the serial port
+ * @param bus   Bus timing of the port
+ * @param p_SP  Packet to send
+ * @return      STATUS_OK on success, AppStatus error code on failure
+ */
+extern AppStatus packet_send(int fd, BusTiming *bus, const PACKET *p_SP);
+
+/**
+ * Start encoding a request in a wire buffer
+ *
+ * Writes address and function code and returns where the payload goes,
+ * so the caller can build it in place and finish with packet_encode_end().
+ *
+ * @param wf    Wire buffer
+ * @param addr  Device address
+ * @param inst  Function code
+ * @return      Pointer to the payload area (room for DMAX bytes)
+ */
+extern uint8_t *packet_encode_begin(WireFrame *wf, uint8_t addr, uint8_t inst);
+
+/**
+ * Finish a request started with packet_encode_begin() by appending CRC
+ *
+ * @param wf    Wire buffer
+ * @param len   Payload length
+ * @return      STATUS_OK on success, ERROR_PACKET_OVERFLOW if len is invalid
+ */
+extern AppStatus packet_encode_end(WireFrame *wf, int len);
+
+/**
+ * Encode a request from a payload buffer
+ *
+ * @param wf     Wire buffer
+ * @param addr   Device address
+ * @param inst   Function code
+ * @param p_data Payload (can be NULL for zero length)
+ * @param len    Payload length
+ * @return       STATUS_OK on success, ERROR_PACKET_OVERFLOW if len is invalid
+ */
+extern AppStatus packet_encode(WireFrame *wf, uint8_t addr, uint8_t inst,
+                               const uint8_t *p_data, int len);
+
+/**
+ * Encode a register read request (function 0x03/0x04)
+ *
+ * @param wf     Wire buffer
+ * @param addr   Device address
+ * @param inst   Function code
+ * @param reg    First register
+ * @param count  Number of registers
+ */
+extern void packet_encode_read(WireFrame *wf, uint8_t addr, uint8_t inst,
+                               uint16_t reg, uint16_t count);
+
+/**
+ * Encode a Write Multiple Registers request (function 0x10)
+ *
+ * The device acknowledges with an 8-byte echo of register and count.
+ *
+ * @param wf     Wire buffer
+ * @param addr   Device address
+ * @param reg    First register
+ * @param count  Number of registers (1..PACKET_WRITE_MAX)
+ * @param values Register values
+ * @return       STATUS_OK on success, ERROR_PACKET_OVERFLOW if count is invalid
+ */
+extern AppStatus packet_encode_write_multiple(WireFrame *wf, uint8_t addr, uint16_t reg,
+                                              uint16_t count, const uint16_t *values);
+
+/**
+ * Get time until the bus has been silent for t3.5
+ *
+ * Lets an event loop wait for the gap itself instead of having
+ * packet_send_wire() sleep for it.
+ *
+ * @param bus   Bus timing of the port
+ * @return      Remaining microseconds, 0 if a request can be sent now
+ */
+extern long packet_bus_idle_us(const BusTiming *bus);
+
+/**
+ * Discard input of a bus with no request out
+ *
+ * Bytes found (late or stray answers, noise) count as bus activity, so
+ * the next request still keeps t3.5 silence after them.
+ *
+ * @param fd  File descriptor of the port
+ * @param bus Bus timing of the port
+ * @return    Bytes discarded, -1 on error
+ */
+extern int packet_flush_input(int fd, BusTiming *bus);
+
+/**
+ * Send an encoded request, keeping t3.5 silence after the previous frame
+ *
+ * Input left over from earlier traffic is flushed first.
+ *
+ * @param fd    File descriptor of the serial port
+ * @param bus   Bus timing of the port
+ * @param wf    Encoded request
+ * @return      STATUS_OK on success, AppStatus error code on failure
+ */
+extern AppStatus packet_send_wire(int fd, BusTiming *bus, const WireFrame *wf);
+
+/**
+ * Account for a request the caller writes itself (io_uring)
+ *
+ * Validates the frame and books it as sent, like packet_send_wire() does
+ * after its write(). The caller keeps the gap: its write goes out
+ * delay_us from now, at the end of packet_bus_idle_us(). The caller also
+ * flushes the input first (packet_flush_input()).
+ *
+ * @param bus      Bus timing of the port
+ * @param wf       Encoded request
+ * @param delay_us Time until the write, 0 = now
+ * @return         STATUS_OK on success, AppStatus error code for an invalid frame
+ */
+extern AppStatus packet_send_queued(BusTiming *bus, const WireFrame *wf, long delay_us);
+
+/**
+ * Start receiving one frame (call right after the request is sent)
+ *
+ * With adaptive timeouts on the bus, timeout_ms only applies to a device
+ * that has not answered yet; otherwise the timeout comes from its
+ * round-trip statistics.
+ *
+ * @param rx         Receiver
+ * @param fd         File descriptor of the serial port
+ * @param bus        Bus timing of the port
+ * @param timeout_ms Response timeout in milliseconds
+ */
+extern void packet_rx_start(PacketReceiver *rx, int fd, BusTiming *bus, int timeout_ms);
+
+/**
+ * Move the start and deadline of a receiver whose request goes out later
+ *
+ * @param rx Receiver started with packet_rx_start()
+ * @param us Delay of the request
+ */
+extern void packet_rx_delay(PacketReceiver *rx, long us);
+
+/**
+ * Advance the receiver
+ *
+ * Call with readable != 0 when the fd is readable: reads the available
+ * bytes without blocking. Call with readable == 0 when the deadline has
+ * passed: closes the frame on t3.5 silence or fails with a timeout.
+ *
+ * @param rx       Receiver
+ * @param readable Non-zero if the fd was reported readable
+ * @return         PACKET_RX_NEED_MORE, PACKET_RX_COMPLETE or PACKET_RX_ERROR
+ */
+extern PacketRxState packet_rx_advance(PacketReceiver *rx, int readable);
+
+/**
+ * Get the buffer the next bytes of the frame go to (for reads by the caller)
+ *
+ * @param rx   Receiver
+ * @param room Pointer to store the free space, 0 = frame too long
+ * @return     Pointer into the frame assembler
+ */
+extern uint8_t *packet_rx_buffer(PacketReceiver *rx, int *room);
+
+/**
+ * Advance the receiver with a read the caller did into packet_rx_buffer()
+ *
+ * @param rx     Receiver
+ * @param result Bytes read, negative errno on failure, 0 = end of file
+ * @return       PACKET_RX_NEED_MORE, PACKET_RX_COMPLETE or PACKET_RX_ERROR
+ */
+extern PacketRxState packet_rx_commit(PacketReceiver *rx, int result);
+
+/**
+ * Get file descriptor the receiver waits on
+ *
+ * @param rx Receiver
+ * @return   File descriptor
+ */
+extern int packet_rx_fd(const PacketReceiver *rx);
+
+/**
+ * Get CLOCK_MONOTONIC time of the next receiver deadline
+ *
+ * @param rx Receiver
+ * @return   Pointer to deadline
+ */
+extern const struct timespec *packet_rx_deadline(const PacketReceiver *rx);
+
+/**
+ * Get milliseconds until the next deadline, rounded up
+ *
+ * @param rx Receiver
+ * @return   Timeout for poll()/epoll_wait(), 0 if already passed
+ */
+extern int packet_rx_wait_ms(const PacketReceiver *rx);
+
+/**
+ * Decode the frame of a finished receiver
+ *
+ * @param rx   Receiver in PACKET_RX_COMPLETE or PACKET_RX_ERROR state
+ * @param p_RP Pointer to PACKET structure to store received data
+ * @return     STATUS_OK, ERROR_PACKET_EXCEPTION for Modbus exception,
+ *             receiver error otherwise
+ */
+extern AppStatus packet_rx_packet(const PacketReceiver *rx, PACKET *p_RP);
+
+/**
+ * Raw frame of a finished receiver
+ *
+ * For fields the PACKET decoding drops, e.g. the register address a
+ * 0x06/0x10 response echoes.
+ *
+ * @param rx  Receiver
+ * @param len Pointer to store the frame length with CRC, 0 if no frame is complete
+ * @return    Frame bytes
+ */
+extern const uint8_t *packet_rx_frame(const PacketReceiver *rx, int *len);
+
+/**
+ * Receive and decode one frame, blocking until done
+ *
+ * Reentrant: all state is in the caller-owned bus timing and receiver.
+ *
+ * @param fd         File descriptor of the serial port
+ * @param bus        Bus timing of the port
+ * @param rx         Receiver used as receive buffer
+ * @param p_RP       Pointer to PACKET structure to store received data
+ * @param timeout_ms Timeout in milliseconds
+ * @param quiet      If non-zero, suppress error messages
+ * @return           STATUS_OK on success, ERROR_PACKET_EXCEPTION for Modbus
+ *                   exception, other AppStatus error code on failure
+ */
+extern AppStatus packet_receive(int fd, BusTiming *bus, PacketReceiver *rx,
+                                PACKET *p_RP, int timeout_ms, int quiet);
+
+/**
+ * Set serial baud rate used for t3.5 inter-frame silence (fd-based API)
+ *
+ * The silence is used both to detect the end of a received frame and
+ * as the minimum gap kept before the next request goes out.
+ *
+ * @param baud  Baud rate of the serial port
+ */
+extern void packet_set_baudrate(int baud);
+
+/**
+ * Set response timeout (fd-based API)
+ *
+ * A link that queues requests in front of the bus (broker socket) needs
+ * longer than a device on the wire.
+ *
+ * @param timeout_ms Timeout in milliseconds (<= 0 = PACKET_READ_TIMEOUT_MS)
+ */
+extern void packet_set_timeout(int timeout_ms);
+
+/**
+ * Get response timeout (fd-based API)
+ *
+ * @return Timeout in milliseconds
+ */
+extern int packet_default_timeout_ms(void);
+
+/**
+ * Enable or disable resync mode (fd-based API)
+ *
+ * In resync mode the receiver skips bytes in front of the response that
+ * cannot start the answer to the outstanding request, instead of taking
+ * a stray noise byte for the address and losing the whole poll.
+ *
+ * @param enable Non-zero to enable
+ */
+extern void packet_set_resync(int enable);
+
+/**
+ * Set the gap the host may add inside a received frame (fd-based API)
+ *
+ * USB-serial adapters hand over bytes in bursts, one per latency timer
+ * period, so silence shorter than this does not end a frame.
+ *
+ * @param us Host latency in microseconds (<= 0 = PACKET_HOST_LATENCY_US)
+ */
+extern void packet_set_host_latency(long us);
+
+/**
+ * Enable adaptive per-device response timeouts (fd-based API)
+ *
+ * @param floor_ms   Lowest timeout in milliseconds (0 disables)
+ * @param ceiling_ms Highest timeout in milliseconds
+ */
+extern void packet_set_adaptive_timeout(int floor_ms, int ceiling_ms);
+
+/**
+ * Get bus timing statistics (fd-based API)
+ *
+ * @param stats Pointer to structure to fill
+ */
+extern void packet_get_bus_stats(PacketBusStats *stats);
+
+/**
+ * Reset bus timing statistics
+ */
+extern void packet_reset_bus_stats(void);
+
 /**
  * Receive a packet from the device
  *
  * @param fd    File descriptor of the serial port
  * @param p_RP  Pointer to PACKET structure to store received data
  * @param mode  Receiving mode (RECEIVE_MODE_TEMPERATURE or RECEIVE_MODE_ACKNOWLEDGE)
- * @return      STATUS_OK on success, AppStatus error code on failure
+ * @return      STATUS_OK on success, ERROR_PACKET_EXCEPTION if the device
+ *              answered with a Modbus exception (code in p_RP->data[0]),
+ *              other AppStatus error code on failure
  */
 extern AppStatus received_packet(int fd, PACKET *p_RP, int mode);
 
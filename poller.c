@@ -0,0 +1,610 @@
+/*
+ *  Multi-port Modbus poller
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Timeout caps the wait also with reads outstanding
+ *  V1.2/2026-10-16 Extra file descriptors watched in the same wait
+ *  V1.3/2026-10-16 io_uring backend
+ *  V1.4/2026-10-16 Input of idle buses flushed
+ *  V1.5/2026-10-16 Port of a bus replaced when it is reopened
+ *  V1.6/2026-10-16 Ring requests queued only as a whole chain
+ */
+#include <stdio.h>      /* Standard input/output definitions */
+#include <string.h>     /* memset */
+#include <unistd.h>     /* close */
+#include <errno.h>      /* Error numbers */
+#include <sys/epoll.h>  /* epoll */
+
+#include "poller.h"
+#include "packet.h"
+#include "transport.h"
+
+/* Tag of a ring entry: bus index and operation */
+#define RING_TAG(bus, op)  (((uint64_t)(bus) << 8) | (op))
+#define RING_BUS(tag)      ((int)((tag) >> 8))
+#define RING_OP(tag)       ((int)((tag) & 0xFF))
+
+/* Operations in the ring */
+#define RING_WRITE   1
+#define RING_READ    2
+#define RING_TIMEOUT 3
+#define RING_EPOLL   4
+#define RING_GAP     5
+
+/* Backend of pollers created from now on */
+static PollerBackend default_backend = POLLER_EPOLL;
+
+/*
+ *  Local function prototypes
+ */
+static int watch_bus(Poller *p, int bus);
+static int run_epoll(Poller *p, int timeout_ms);
+static int run_uring(Poller *p, int timeout_ms);
+static int wait_time(Poller *p, int wait_ms, int timeout_ms);
+static int advance(Poller *p, const int *readable);
+static int start_due(Poller *p);
+static AppStatus start_ring(Poller *p, int bus, long gap_us);
+static int arm_read(Poller *p, int bus);
+static int ring_complete(Poller *p, int bus, int op, int res);
+static void finish(Poller *p, int bus, AppStatus status);
+
+/**********************************************************************/
+
+/*
+ *  Select the backend of pollers created from now on
+ */
+void poller_set_backend(PollerBackend backend)
+{
+    default_backend = backend;
+}
+
+/*
+ *  Create poller
+ */
+AppStatus poller_init(Poller *p)
+{
+    int rc;
+
+    memset(p, 0, sizeof(Poller));
+    p->ring.fd = -1;
+
+    p->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (p->epfd < 0) {
+        fprintf(stderr, "poller: epoll_create1: %s\n", strerror(errno));
+        return ERROR_PORT_INIT;
+    }
+
+    if (default_backend == POLLER_URING) {
+        rc = uring_init(&p->ring, POLLER_URING_ENTRIES);
+        if (rc < 0) {
+            fprintf(stderr, "poller: io_uring not available (%s), using epoll\n",
+                    strerror(-rc));
+            default_backend = POLLER_EPOLL;  /* Pollers set up later do not try again */
+        } else {
+            p->backend = POLLER_URING;
+        }
+    }
+
+    return STATUS_OK;
+}
+
+/*
+ *  Add a bus
+ */
+int poller_add(Poller *p, ModbusCtx *ctx)
+{
+    int bus = p->count;
+
+    if (bus >= POLLER_MAX_BUSES || ctx == NULL) {
+        return -1;
+    }
+
+    memset(&p->bus[bus], 0, sizeof(PollerBus));
+    p->bus[bus].ctx = ctx;
+    if (modbus_ctx_fd(ctx) >= 0 && watch_bus(p, bus) < 0) {
+        return -1;
+    }
+    p->count++;
+
+    return bus;
+}
+
+/*
+ *  Stop watching the port of an idle bus
+ */
+void poller_detach(Poller *p, int bus)
+{
+    PollerBus *b;
+
+    if (bus < 0 || bus >= p->count) {
+        return;
+    }
+
+    b = &p->bus[bus];
+    if (b->in_epoll) {
+        epoll_ctl(p->epfd, EPOLL_CTL_DEL, modbus_ctx_fd(b->ctx), NULL);
+        b->in_epoll = 0;
+        p->n_epoll--;
+    }
+    b->ring = 0;
+}
+
+/*
+ *  Watch the port of a bus again, after it was reopened
+ */
+int poller_attach(Poller *p, int bus, ModbusCtx *ctx)
+{
+    if (bus < 0 || bus >= p->count || ctx == NULL) {
+        return -1;
+    }
+
+    poller_detach(p, bus);
+    p->bus[bus].ctx = ctx;
+
+    return watch_bus(p, bus);
+}
+
+/*
+ *  Watch an extra file descriptor in the same wait as the buses
+ */
+int poller_watch(Poller *p, int fd, PollerEvent event, void *arg)
+{
+    struct epoll_event ev;
+    int w = p->n_watch;
+
+    if (w >= POLLER_MAX_WATCH || fd < 0 || event == NULL) {
+        return -1;
+    }
+
+    /* Event data above the bus indexes */
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)(POLLER_MAX_BUSES + w);
+    if (epoll_ctl(p->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        fprintf(stderr, "poller: epoll_ctl: %s\n", strerror(errno));
+        return -1;
+    }
+
+    p->watch[w].fd = fd;
+    p->watch[w].event = event;
+    p->watch[w].arg = arg;
+    p->n_watch++;
+    p->n_epoll++;
+
+    return 0;
+}
+
+/*
+ *  Queue a request on an idle bus
+ */
+AppStatus poller_submit(Poller *p, int bus, const WireFrame *req,
+                        PollerDone done, void *arg)
+{
+    PollerBus *b;
+
+    if (bus < 0 || bus >= p->count || req == NULL) {
+        return ERROR_SEND_PACKET;
+    }
+
+    b = &p->bus[bus];
+    if (b->req != NULL || b->active) {
+        return ERROR_SEND_PACKET;  /* One outstanding transaction per bus */
+    }
+
+    b->req = req;
+    b->done = done;
+    b->arg = arg;
+    p->outstanding++;
+
+    return STATUS_OK;
+}
+
+/*
+ *  Send due requests, wait for the ports once and advance receivers
+ */
+int poller_run(Poller *p, int timeout_ms)
+{
+    if (p->backend == POLLER_URING) {
+        return run_uring(p, timeout_ms);
+    }
+    return run_epoll(p, timeout_ms);
+}
+
+/*
+ *  Run until no bus has a request queued or pending
+ */
+AppStatus poller_drain(Poller *p)
+{
+    while (p->outstanding > 0) {
+        if (poller_run(p, -1) < 0) {
+            return ERROR_RECEIVE_PACKET;
+        }
+    }
+
+    return STATUS_OK;
+}
+
+/*
+ *  Close the epoll instance
+ */
+void poller_close(Poller *p)
+{
+    if (p->epfd >= 0) {
+        close(p->epfd);
+        p->epfd = -1;
+    }
+    if (p->backend == POLLER_URING) {
+        uring_close(&p->ring);  /* Cancels reads still in the ring */
+        p->backend = POLLER_EPOLL;
+    }
+    p->count = 0;
+    p->outstanding = 0;
+    p->n_watch = 0;
+}
+
+/* Local functions */
+
+/*
+ *  Watch the port of a bus: serial ports of the io_uring backend in the
+ *  ring, all others in the epoll set
+ */
+static int watch_bus(Poller *p, int bus)
+{
+    PollerBus *b = &p->bus[bus];
+    int fd = modbus_ctx_fd(b->ctx);
+    struct epoll_event ev;
+
+    /* Modbus TCP responses are matched by transport_read(), not the ring */
+    b->ring = p->backend == POLLER_URING && transport_fd_type(fd) == TRANSPORT_SERIAL;
+    if (b->ring) {
+        return 0;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)bus;
+    if (epoll_ctl(p->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        fprintf(stderr, "poller: epoll_ctl: %s\n", strerror(errno));
+        return -1;
+    }
+    b->in_epoll = 1;
+    p->n_epoll++;
+
+    return 0;
+}
+
+/*
+ *  One round with epoll: wait for readable ports, then read them
+ */
+static int run_epoll(Poller *p, int timeout_ms)
+{
+    struct epoll_event events[POLLER_MAX_BUSES + POLLER_MAX_WATCH];
+    int readable[POLLER_MAX_BUSES + POLLER_MAX_WATCH];
+    int wait_ms, n, i;
+
+    wait_ms = wait_time(p, start_due(p), timeout_ms);
+
+    n = epoll_wait(p->epfd, events, POLLER_MAX_BUSES + POLLER_MAX_WATCH, wait_ms);
+    if (n < 0) {
+        if (errno == EINTR) {
+            return 0;  /* Caller checks its running flag */
+        }
+        fprintf(stderr, "poller: epoll_wait: %s\n", strerror(errno));
+        return -1;
+    }
+
+    memset(readable, 0, sizeof(readable));
+    for (i = 0; i < n; i++) {
+        readable[events[i].data.u32] = 1;
+    }
+
+    return advance(p, readable);
+}
+
+/*
+ *  One round with io_uring: submit the entries of all due buses and wait
+ *  in one system call, then take the completions of all ports
+ */
+static int run_uring(Poller *p, int timeout_ms)
+{
+    struct epoll_event events[POLLER_MAX_BUSES + POLLER_MAX_WATCH];
+    int readable[POLLER_MAX_BUSES + POLLER_MAX_WATCH];
+    int wait_ms, n, i, rc, res, finished = 0, epoll_ready = 0;
+    uint64_t tag;
+
+    wait_ms = wait_time(p, start_due(p), timeout_ms);
+
+    /* Network ports and watched fds: the epoll set is one more ring entry */
+    if (p->n_epoll > 0 && !p->epoll_polled) {
+        if (uring_poll(&p->ring, p->epfd, RING_TAG(0, RING_EPOLL)) == 0) {
+            p->epoll_polled = 1;
+        }
+    }
+
+    rc = uring_submit_wait(&p->ring, 1, wait_ms);
+    if (rc < 0 && rc != -ETIME && rc != -EINTR) {
+        fprintf(stderr, "poller: io_uring_enter: %s\n", strerror(-rc));
+        return -1;
+    }
+
+    while (uring_next(&p->ring, &tag, &res)) {
+        if (RING_OP(tag) == RING_EPOLL) {
+            p->epoll_polled = 0;
+            epoll_ready = 1;
+        } else {
+            finished += ring_complete(p, RING_BUS(tag), RING_OP(tag), res);
+        }
+    }
+
+    memset(readable, 0, sizeof(readable));
+    if (epoll_ready) {
+        n = epoll_wait(p->epfd, events, POLLER_MAX_BUSES + POLLER_MAX_WATCH, 0);
+        for (i = 0; i < n; i++) {
+            readable[events[i].data.u32] = 1;
+        }
+    }
+
+    return finished + advance(p, readable);
+}
+
+/*
+ *  Work out how long to wait: gap ends, receive deadlines, caller limit
+ */
+static int wait_time(Poller *p, int wait_ms, int timeout_ms)
+{
+    int ms;
+
+    /* Wake up for the nearest receive deadline, ring reads have their own */
+    for (int i = 0; i < p->count; i++) {
+        if (p->bus[i].active && !p->bus[i].ring) {
+            ms = modbus_ctx_wait_ms(p->bus[i].ctx);
+            if (wait_ms < 0 || ms < wait_ms) {
+                wait_ms = ms;
+            }
+        }
+    }
+    if (wait_ms < 0 || (timeout_ms >= 0 && (p->outstanding == 0 || timeout_ms < wait_ms))) {
+        wait_ms = timeout_ms;
+    }
+
+    return wait_ms;
+}
+
+/*
+ *  Advance the receivers of epoll buses and serve watched fds
+ */
+static int advance(Poller *p, const int *readable)
+{
+    int i, finished = 0;
+
+    /*
+     * Bytes on an idle bus would keep its fd readable (the wait spins) and
+     * be taken for the next response. First, so responses a shared Modbus
+     * TCP connection hands to other buses are seen by them in this round.
+     */
+    for (i = 0; i < p->count; i++) {
+        PollerBus *b = &p->bus[i];
+
+        if (!readable[i] || b->active || !b->in_epoll ||
+            packet_flush_input(modbus_ctx_fd(b->ctx), b->ctx->bus) >= 0) {
+            continue;
+        }
+
+        /* Closed or failed port stays readable: requests run into their deadline */
+        fprintf(stderr, "poller: bus %d: %s, no longer watched\n", i, strerror(errno));
+        epoll_ctl(p->epfd, EPOLL_CTL_DEL, modbus_ctx_fd(b->ctx), NULL);
+        b->in_epoll = 0;
+        p->n_epoll--;
+    }
+
+    for (i = 0; i < p->count; i++) {
+        PollerBus *b = &p->bus[i];
+
+        if (!b->active || b->ring) {
+            continue;
+        }
+        if (modbus_request_advance(b->ctx, readable[i]) != PACKET_RX_NEED_MORE) {
+            finish(p, i, modbus_request_result(b->ctx, NULL, NULL));
+            finished++;
+        }
+    }
+
+    /* Watched fds last, so their requests find the buses just finished idle */
+    for (i = 0; i < p->n_watch; i++) {
+        if (readable[POLLER_MAX_BUSES + i]) {
+            p->watch[i].event(p, p->watch[i].fd, p->watch[i].arg);
+        }
+    }
+
+    return finished;
+}
+
+/*
+ *  Send queued requests whose bus has been silent for t3.5
+ *  Returns milliseconds until the next gap ends, -1 if none is waiting
+ */
+static int start_due(Poller *p)
+{
+    int wait_ms = -1;
+    long idle_us;
+    AppStatus status;
+
+    for (int i = 0; i < p->count; i++) {
+        PollerBus *b = &p->bus[i];
+
+        /* A ring bus also waits for the write and read of its last request */
+        if (b->req == NULL || b->ring_ops > 0) {
+            continue;
+        }
+
+        /* Flushed before the gap is taken: stray bytes restart it here, not in a sleep */
+        packet_flush_input(modbus_ctx_fd(b->ctx), b->ctx->bus);
+
+        /* The ring keeps the gap itself, in front of the write */
+        idle_us = packet_bus_idle_us(b->ctx->bus);
+        if (idle_us > 0 && !b->ring) {
+            int ms = (int)((idle_us + 999) / 1000);
+            if (wait_ms < 0 || ms < wait_ms) {
+                wait_ms = ms;
+            }
+            continue;
+        }
+
+        status = b->ring ? start_ring(p, i, idle_us) : modbus_request_start(b->ctx, b->req);
+        b->req = NULL;
+        if (status != STATUS_OK) {
+            finish(p, i, status);
+            continue;
+        }
+        b->active = 1;
+    }
+
+    return wait_ms;
+}
+
+/*
+ *  Queue the write of a request linked to the read of its response,
+ *  behind a wait for the rest of the t3.5 gap
+ */
+static AppStatus start_ring(Poller *p, int bus, long gap_us)
+{
+    PollerBus *b = &p->bus[bus];
+    struct timespec t;
+    AppStatus status;
+
+    status = modbus_request_queue(b->ctx, b->req, gap_us);
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    /*
+     * Gap, write, read and its timeout go in together or not at all: a
+     * linked write without its read would chain onto the next bus and
+     * never post a completion
+     */
+    if (uring_sq_space(&p->ring) < (gap_us > 0 ? 4u : 3u)) {
+        modbus_request_commit(b->ctx, -EBUSY);
+        return ERROR_PACKET_WRITE;
+    }
+
+    if (gap_us > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        t.tv_nsec += gap_us * 1000L;
+        t.tv_sec += t.tv_nsec / 1000000000L;
+        t.tv_nsec %= 1000000000L;
+        uring_time(&t, &b->gap_end);
+        if (uring_delay(&p->ring, &b->gap_end, RING_TAG(bus, RING_GAP)) < 0) {
+            modbus_request_commit(b->ctx, -EBUSY);
+            return ERROR_PACKET_WRITE;
+        }
+    }
+
+    /*
+     * A tty write run from the timer completion sees the task's signal
+     * notification and fails with EINTR, so behind a gap it goes to a worker
+     */
+    b->write_res = 0;
+    if (uring_write(&p->ring, modbus_ctx_fd(b->ctx), b->req->buf, (unsigned)b->req->len,
+                    RING_TAG(bus, RING_WRITE),
+                    URING_LINK | URING_QUIET | (gap_us > 0 ? URING_ASYNC : 0)) < 0) {
+        modbus_request_commit(b->ctx, -EBUSY);
+        return ERROR_PACKET_WRITE;
+    }
+
+    /* Room checked above, the read behind the write always goes in */
+    arm_read(p, bus);
+
+    return STATUS_OK;
+}
+
+/*
+ *  Queue a read into the receiver, cancelled at the receive deadline
+ *  Returns -1 if the receiver is full or the ring has no room for both entries
+ */
+static int arm_read(Poller *p, int bus)
+{
+    PollerBus *b = &p->bus[bus];
+    uint8_t *tail;
+    int room;
+
+    tail = packet_rx_buffer(&b->ctx->rx, &room);
+    if (room == 0 || uring_sq_space(&p->ring) < 2) {
+        return -1;
+    }
+
+    uring_time(packet_rx_deadline(&b->ctx->rx), &b->deadline);
+    if (uring_read(&p->ring, modbus_ctx_fd(b->ctx), tail, (unsigned)room,
+                   RING_TAG(bus, RING_READ), URING_LINK) < 0) {
+        return -1;
+    }
+    uring_link_timeout(&p->ring, &b->deadline, RING_TAG(bus, RING_TIMEOUT));
+    b->ring_ops++;
+
+    return 0;
+}
+
+/*
+ *  Handle one completion of a bus, returns 1 if its transaction finished
+ */
+static int ring_complete(Poller *p, int bus, int op, int res)
+{
+    PollerBus *b = &p->bus[bus];
+    PacketRxState state;
+    int room;
+
+    /* A write completes only when it failed or was short */
+    if (op == RING_WRITE) {
+        b->write_res = res < 0 ? res : -EIO;  /* The linked read is cancelled */
+        return 0;
+    }
+    if (op == RING_READ) {
+        b->ring_ops--;
+    }
+    if (op != RING_READ || !b->active) {
+        return 0;  /* Gap wait, or read timeout fired (-ETIME) or cancelled */
+    }
+
+    if (b->write_res < 0) {
+        fprintf(stderr, "poller: write: %s\n", strerror(-b->write_res));
+        modbus_request_commit(b->ctx, b->write_res);
+        finish(p, bus, ERROR_PACKET_WRITE);
+        return 1;
+    }
+
+    if (res > 0 || (res < 0 && res != -ECANCELED && res != -EAGAIN && res != -EINTR)) {
+        state = modbus_request_commit(b->ctx, res);
+    } else {
+        /* Cancelled at the deadline (or VTIME ran out): timeout or t3.5 silence */
+        state = modbus_request_advance(b->ctx, 0);
+    }
+
+    if (state == PACKET_RX_NEED_MORE) {
+        if (arm_read(p, bus) == 0) {
+            return 0;
+        }
+        packet_rx_buffer(&b->ctx->rx, &room);
+        if (room == 0) {
+            modbus_request_advance(b->ctx, 1);  /* Frame too long, ends as overflow */
+        } else {
+            modbus_request_commit(b->ctx, -EBUSY);  /* No room in the ring for the read */
+        }
+    }
+
+    finish(p, bus, modbus_request_result(b->ctx, NULL, NULL));
+    return 1;
+}
+
+/*
+ *  Mark bus idle and report the result
+ */
+static void finish(Poller *p, int bus, AppStatus status)
+{
+    PollerBus *b = &p->bus[bus];
+
+    b->active = 0;
+    b->req = NULL;
+    p->outstanding--;
+
+    if (b->done != NULL) {
+        b->done(p, bus, status, b->arg);
+    }
+}
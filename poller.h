@@ -0,0 +1,222 @@
+/*
+ *  Multi-port Modbus poller
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Timeout caps the wait also with reads outstanding
+ *  V1.2/2026-10-16 Extra file descriptors watched in the same wait
+ *  V1.3/2026-10-16 io_uring backend
+ *  V1.4/2026-10-16 Input of idle buses flushed
+ *  V1.5/2026-10-16 Port of a bus replaced when it is reopened
+ *
+ *  Drives several serial buses from one thread: every bus has its own
+ *  ModbusCtx and at most one outstanding transaction, the ports are
+ *  waited on together with epoll, so transactions on different buses
+ *  overlap in time.
+ *
+ *  With the io_uring backend a request on a serial port is a wait for
+ *  the t3.5 gap, the write and a read with a timeout at the receive
+ *  deadline, linked in one chain. The chains of all due buses go to the
+ *  kernel in one io_uring_enter(), which also waits, and the completions
+ *  of all ports are taken in one pass. Network ports and watched fds stay
+ *  in the epoll set, polled through the ring.
+ */
+#ifndef POLLER_H
+#define POLLER_H
+
+#include "error.h"      /* For AppStatus */
+#include "constants.h"  /* For MAX_PORTS */
+#include "modbus_ctx.h" /* For ModbusCtx, WireFrame */
+#include "uring.h"      /* For Uring */
+
+/* Most buses in one poller */
+#define POLLER_MAX_BUSES MAX_PORTS
+
+/* Most extra file descriptors watched besides the buses */
+#define POLLER_MAX_WATCH MAX_PORTS
+
+/* Ring size: gap, write, read and timeout of every bus, plus the epoll poll */
+#define POLLER_URING_ENTRIES (4 * POLLER_MAX_BUSES + 1)
+
+/**
+ * I/O backend of a poller
+ */
+typedef enum {
+    POLLER_EPOLL = 0,        /* epoll_wait(), then write()/read() per port */
+    POLLER_URING = 1         /* io_uring: linked write, read and timeout */
+} PollerBackend;
+
+typedef struct Poller Poller;
+
+/**
+ * Completion callback of a transaction
+ *
+ * Called from poller_run() with the result of the transaction; the
+ * response is in ctx->rx_packet (modbus_request_result()). The callback
+ * may submit the next request on the same bus.
+ *
+ * @param poller Poller
+ * @param bus    Bus index from poller_add()
+ * @param status Result of the transaction
+ * @param arg    Argument given to poller_submit()
+ */
+typedef void (*PollerDone)(Poller *poller, int bus, AppStatus status, void *arg);
+
+/**
+ * Callback of a watched file descriptor
+ *
+ * Called from poller_run() when fd is readable. The callback may submit
+ * requests on idle buses.
+ *
+ * @param poller Poller
+ * @param fd     Watched file descriptor
+ * @param arg    Argument given to poller_watch()
+ */
+typedef void (*PollerEvent)(Poller *poller, int fd, void *arg);
+
+/**
+ * One watched file descriptor
+ */
+typedef struct {
+    int fd;                  /* File descriptor */
+    PollerEvent event;       /* Readable callback */
+    void *arg;               /* Callback argument */
+} PollerWatch;
+
+/**
+ * One bus of the poller
+ */
+typedef struct {
+    ModbusCtx *ctx;          /* Transaction context (owned by caller) */
+    const WireFrame *req;    /* Request waiting for the t3.5 gap, NULL = none */
+    PollerDone done;         /* Completion callback */
+    void *arg;               /* Callback argument */
+    int active;              /* Request sent, response pending */
+    int ring;                /* Served through the ring (io_uring backend) */
+    int in_epoll;            /* Port in the epoll set (dropped when it fails) */
+    int ring_ops;            /* Reads of the bus in the ring */
+    int write_res;           /* Error of the ring write, 0 = none */
+    UringTime gap_end;       /* End of the t3.5 gap in front of the write */
+    UringTime deadline;      /* Timeout of the read in the ring */
+} PollerBus;
+
+/**
+ * Poller state
+ */
+struct Poller {
+    int epfd;                          /* epoll instance */
+    int count;                         /* Number of buses */
+    int outstanding;                   /* Buses with a queued or active request */
+    PollerBus bus[POLLER_MAX_BUSES];   /* Buses */
+    PollerWatch watch[POLLER_MAX_WATCH]; /* Extra file descriptors */
+    int n_watch;                       /* Number of watched file descriptors */
+    int n_epoll;                       /* File descriptors in the epoll set */
+    PollerBackend backend;             /* Backend in use */
+    Uring ring;                        /* io_uring instance (POLLER_URING) */
+    int epoll_polled;                  /* Poll of epfd queued in the ring */
+};
+
+/**
+ * Select the backend of pollers created from now on
+ *
+ * @param backend POLLER_EPOLL (default) or POLLER_URING
+ */
+extern void poller_set_backend(PollerBackend backend);
+
+/**
+ * Create poller
+ *
+ * With POLLER_URING selected and io_uring not usable, the poller falls
+ * back to epoll (p->backend tells which one is in use).
+ *
+ * @param p Poller
+ * @return  STATUS_OK, ERROR_PORT_INIT if epoll is not available
+ */
+extern AppStatus poller_init(Poller *p);
+
+/**
+ * Add a bus
+ *
+ * A context whose port is not open (fd -1) gets its bus index; the port
+ * is watched once poller_attach() is called for it.
+ *
+ * @param p   Poller
+ * @param ctx Context of the port, must outlive the poller
+ * @return    Bus index, -1 if full or the port cannot be watched
+ */
+extern int poller_add(Poller *p, ModbusCtx *ctx);
+
+/**
+ * Stop watching the port of an idle bus
+ *
+ * Call before the port is closed: a closed duplicate of a shared
+ * connection would stay in the epoll set.
+ *
+ * @param p   Poller
+ * @param bus Bus index
+ */
+extern void poller_detach(Poller *p, int bus);
+
+/**
+ * Watch the port of a bus again, after it was reopened
+ *
+ * @param p   Poller
+ * @param bus Bus index
+ * @param ctx Context of the reopened port
+ * @return    0 on success, -1 if the port cannot be watched
+ */
+extern int poller_attach(Poller *p, int bus, ModbusCtx *ctx);
+
+/**
+ * Watch an extra file descriptor in the same wait as the buses
+ *
+ * Lets requests from other sources (e.g. socket clients) be taken in
+ * while transactions are outstanding.
+ *
+ * @param p     Poller
+ * @param fd    File descriptor (socket, epoll instance, pipe, ...)
+ * @param event Readable callback
+ * @param arg   Callback argument
+ * @return      0 on success, -1 if full or fd cannot be watched
+ */
+extern int poller_watch(Poller *p, int fd, PollerEvent event, void *arg);
+
+/**
+ * Queue a request on an idle bus
+ *
+ * The request is sent from poller_run() as soon as the bus has been
+ * silent for t3.5; req must stay valid until the callback.
+ *
+ * @param p    Poller
+ * @param bus  Bus index
+ * @param req  Encoded request
+ * @param done Completion callback
+ * @param arg  Callback argument
+ * @return     STATUS_OK, ERROR_SEND_PACKET if the bus is busy
+ */
+extern AppStatus poller_submit(Poller *p, int bus, const WireFrame *req,
+                               PollerDone done, void *arg);
+
+/**
+ * Send due requests, wait for the ports once and advance receivers
+ *
+ * @param p          Poller
+ * @param timeout_ms Longest wait (-1 = until an event or receive deadline)
+ * @return           Number of finished transactions, -1 on epoll error
+ */
+extern int poller_run(Poller *p, int timeout_ms);
+
+/**
+ * Run until no bus has a request queued or pending
+ *
+ * @param p Poller
+ * @return  STATUS_OK, ERROR_RECEIVE_PACKET on epoll error
+ */
+extern AppStatus poller_drain(Poller *p);
+
+/**
+ * Close the epoll instance and the ring (ports stay open)
+ *
+ * @param p Poller
+ */
+extern void poller_close(Poller *p);
+
+#endif /* POLLER_H */
@@ -1,6 +1,19 @@
 /*
  * Temperature reading functions
  * V1.0/2025-04-17
+ * V1.1/2026-10-16 Periodic read request encoded once
+ * V1.2/2026-10-16 Report resync statistics
+ * V1.3/2026-10-16 Report adaptive timeout
+ * V1.4/2026-10-16 Several ports polled at once through the poller
+ * V1.5/2026-10-16 Benchmark reports the applied baud rate
+ * V1.6/2026-10-16 Round trip before/after the low-latency profile
+ * V1.7/2026-10-16 Corrections and temperatures in one planned read
+ * V1.8/2026-10-16 Temperatures pushed by the automatic report mode
+ * V1.9/2026-10-16 Benchmark over network transports, Modbus TCP window
+ * V1.10/2026-10-16 Benchmark reports the poller backend (epoll, io_uring)
+ * V1.11/2026-10-16 Samples on absolute deadlines (ticker), overruns reported
+ * V1.12/2026-10-16 Binary sample timestamps, formatted at the output
+ * V1.13/2026-10-16 Sample time of the last response byte, not of the print
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,6 +21,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <time.h>
+#include <poll.h>
 
 #include "read_functions.h"
 #include "error.h"
@@ -19,67 +33,135 @@
 #include "define_error_resp.h"
 #include "signal_handler.h"
 #include "constants.h"
+#include "packet.h"
+#include "serial.h"
+#include "modbus_ctx.h"
+#include "poller.h"
+#include "regplan.h"
+#include "autoreport.h"
+#include "transport.h"
+
+/* Post-receive delay of versions before V1.14, for throughput comparison */
+#define LEGACY_DELAY_US 8000
+
+/* First temperature and correction registers */
+#define REG_TEMPERATURE 0x0000
+#define REG_CORRECTION  0x0008
+
+/* Round-trip statistics of one latency_benchmark() pass */
+typedef struct {
+    int count;                 /* Transactions measured */
+    double mean_ms;            /* Mean round trip [ms] */
+    double min_ms;             /* Shortest round trip [ms] */
+    double max_ms;             /* Longest round trip [ms] */
+} RttSummary;
+
+/* State of one port in read_temp_ports() and poll_benchmark_ports() */
+typedef struct {
+    ModbusCtx *ctx;            /* Context of the port */
+    WireFrame request;         /* Temperature read request */
+    AppStatus status;          /* Result of the last read */
+    Timestamp sample_time;     /* Time of the last response */
+    int remaining;             /* Benchmark: transactions still to run */
+    int done;                  /* Benchmark: transactions finished */
+    struct timespec t_end;     /* Benchmark: last transaction finished */
+} PortRead;
+
+/* Output state of read_temp_auto() */
+typedef struct {
+    int n;                     /* Number of channels to print */
+    int one_shot;              /* Print without timestamp */
+    int samples;               /* Reports printed */
+    const AutoReport *ar;      /* Receiver, for the time of a report */
+    struct timespec last;      /* Time of the last report */
+} AutoPrint;
+
+/*
+ *  Local function prototypes
+ */
+static void read_done(Poller *poller, int bus, AppStatus status, void *arg);
+static void bench_done(Poller *poller, int bus, AppStatus status, void *arg);
+static void auto_print(uint8_t addr, const PACKET *p, void *arg);
+static AppStatus measure_rtt(ModbusCtx *ctx, const WireFrame *request, int count,
+                             RttSummary *sum);
+static AppStatus start_poller(Poller *poller, ModbusCtx ctx[], PortRead port[],
+                              int n_ports, uint8_t adr, int n);
+static void next_sample(Ticker *tick, const char *func);
+static void print_ticker(const Ticker *tick);
+
+/**********************************************************************/
 
 
 /**
- * Read and print correction temperature for all channels
+ * Read and print temperature and correction for all channels
  */
 AppStatus read_correction(int fd, uint8_t adr)
 {
-    int verb = 0;
-    PACKET pr;
-    PACKET *p_pr = &pr;
-    uint8_t *p_data;
-    uint8_t input_data[DMAX];
-    int i;
-    float T;
-    AppStatus status;
+    RegPlan plan;
+    uint16_t temp[MAX_CHANNELS];
+    uint16_t corr[MAX_CHANNELS];
+    int i, t, c;
 
-    /* Register address (2 byte) + Read number (2 byte) */       
-    input_data[0] = 0x00; 
-    input_data[1] = 0x08; 
-    input_data[2] = 0x00; 
-    input_data[3] = 8;
+    /* Adjacent ranges, the planner reads both at once */
+    regplan_init(&plan, 0, 0);
+    t = regplan_add(&plan, REG_TEMPERATURE, MAX_CHANNELS, temp);
+    c = regplan_add(&plan, REG_CORRECTION, MAX_CHANNELS, corr);
+    if (t < 0 || c < 0) {
+        return ERROR_READ_CORRECTION;
+    }
+
+    regplan_execute(&plan, fd, adr);
+    if (plan.range[c].status != STATUS_OK) {
+        return ERROR_READ_CORRECTION;
+    }
 
-    printf("Temperature correction [C]\n");
+    printf("Channel          ");
     for (i=1; i<=MAX_CHANNELS; i++) {
         printf("  Ch%d",i);
-    }  
+    }
     printf("\n");
 
-    status = monada(fd, adr, '\x03', 4, input_data, p_pr, verb, "read_correction", 0, &p_data);
-    if (status != STATUS_OK) {
-        return ERROR_READ_CORRECTION;
+    printf("Temperature [C]  ");
+    for (i=0; i<MAX_CHANNELS; i++) {
+        float T = (float)(int16_t)temp[i]/10;
+        if (plan.range[t].status == STATUS_OK && T >= MIN_TEMPERATURE && T <= MAX_TEMPERATURE)
+            printf(" %.1f", T);
+        else
+            printf("  NaN");
     }
+    printf("\n");
 
+    printf("Correction [C]   ");
     for (i=0; i<MAX_CHANNELS; i++) {
-        T = (float)INT16(p_data[2*i+1], p_data[2*i])/10; /* Temperature [C] */
-        printf(" %.1f", T);
+        printf(" %.1f", (float)(int16_t)corr[i]/10);
     }
     printf("\n\n");
-    
+
     return STATUS_OK;
 }
 
 /**
  * Read and print temperature from 1..n channels
  */
-AppStatus read_temp(int fd, uint8_t adr, int n, int dt, int m_f,
-                    int maf_f, int maf_window, int one_shot)
+AppStatus read_temp(int fd, uint8_t adr, int n, long period_ms, TickerPolicy policy,
+                    int m_f, int maf_f, int maf_window, int one_shot)
 {
     int verb = 0;
     PACKET pr;
     PACKET *p_pr = &pr;
     uint8_t *p_data;
-    uint8_t input_data[DMAX];
+    ModbusCtx ctx;
+    WireFrame request;
     int i;
     int rc;
     float T[MAX_CHANNELS];
     float T_f[MAX_CHANNELS];
     float T_maf[MAX_CHANNELS];
-    char *sample_time = NULL;
-    char sample_t_f[DBUF];  /* Sample time after filtering */
-    char sample_t_maf[DBUF]; /* Sample time after MAF filtering */
+    Timestamp sample_time;
+    Timestamp sample_t_f;   /* Sample time after filtering */
+    Timestamp sample_t_maf; /* Sample time after MAF filtering */
+    char time_text[DBUF];
+    Ticker tick;
     AppStatus status;
 
     /* Input validation */
@@ -87,7 +169,7 @@ AppStatus read_temp(int fd, uint8_t adr, int n, int dt, int m_f,
         return ERROR_INVALID_CHANNEL;
     }
 
-    if (dt < 0) {
+    if (period_ms < 0) {
         return ERROR_INVALID_TIME;
     }
 
@@ -103,11 +185,9 @@ AppStatus read_temp(int fd, uint8_t adr, int n, int dt, int m_f,
         }
     }
 
-    /* Register address (2 byte) + Read number (2 byte) */       
-    input_data[0] = 0x00; 
-    input_data[1] = 0x00; 
-    input_data[2] = 0x00; 
-    input_data[3] = n;
+    /* Request is the same for every sample, encode it once */
+    modbus_ctx_init_shared(&ctx, fd);
+    packet_encode_read(&request, adr, '\x03', 0x0000, (uint16_t)n);
 
     if (!one_shot) {
       printf("# Date                ");
@@ -118,17 +198,14 @@ AppStatus read_temp(int fd, uint8_t adr, int n, int dt, int m_f,
     }
 
     /* Modified loop to allow termination with Ctrl+C */
+    ticker_init(&tick, period_ms, policy);
     while (running) {
-        status = monada(fd, adr, '\x03', 4, input_data, p_pr, verb, "read_temp", 0, &p_data);
+        status = modbus_request(&ctx, &request, p_pr, verb, "read_temp", &p_data);
         if (status != STATUS_OK) {
             return ERROR_READ_TEMPERATURE;
         }
 
-        sample_time = now();
-        if (sample_time == NULL) {
-            fprintf(stderr, "read_temp: Failed to get current time\n");
-            return ERROR_READ_TEMPERATURE;
-        }
+        modbus_request_time(&ctx, &sample_time);
 
         for (i=0; i<n; i++) {
             T[i] = (float)INT16(p_data[2*i+1], p_data[2*i])/10; /* Temperature [C] */
@@ -137,33 +214,32 @@ AppStatus read_temp(int fd, uint8_t adr, int n, int dt, int m_f,
         }
 
         if (m_f) {
-          rc = median_filter(sample_time, n, T, sample_t_f, T_f);
+          rc = median_filter(&sample_time, n, T, &sample_t_f, T_f);
           if (rc != MF_SUCCESS) {
             fprintf(stderr, "Median filter failed with code %d\n", rc);
             return ERROR_MEDIAN_FILTER;
           }
-          strncpy(sample_time, sample_t_f, DBUF - 1);
-          sample_time[DBUF - 1] = '\0';
+          sample_time = sample_t_f;
           for (i=0; i<n; i++) {
             T[i] = T_f[i];
           }
         }
 
         if (maf_f) {
-          rc = maf_filter(sample_time, n, T, sample_t_maf, T_maf);
+          rc = maf_filter(&sample_time, n, T, &sample_t_maf, T_maf);
           if (rc != MAF_SUCCESS) {
             fprintf(stderr, "MAF filter failed with code %d\n", rc);
             return ERROR_MAF_FILTER;
           }
-          strncpy(sample_time, sample_t_maf, DBUF - 1);
-          sample_time[DBUF - 1] = '\0';
+          sample_time = sample_t_maf;
           for (i=0; i<n; i++) {
             T[i] = T_maf[i];
           }
         }
 
         if (!one_shot) {
-          printf("%s ", sample_time);
+          timestamp_format(&sample_time, time_text, sizeof(time_text));
+          printf("%s ", time_text);
         }
 
         for (i=0; i<n; i++) {
@@ -173,15 +249,439 @@ AppStatus read_temp(int fd, uint8_t adr, int n, int dt, int m_f,
             printf("  NaN");
         }
         printf("\n");
-        
-        if (!one_shot && dt > 0) {
-          struct timespec ts = { .tv_sec = dt, .tv_nsec = 0 };
-          nanosleep(&ts, NULL);
+
+        if (one_shot) {
+          break;
         }
+        next_sample(&tick, "read_temp");
+    }
+    if (!one_shot) {
+      PacketBusStats stats;
+      int sig = get_received_signal();
+      if (sig == SIGINT) {
+          printf("\nReceived SIGINT (Ctrl+C), measurement stopped\n");
+      } else if (sig == SIGTERM) {
+          printf("\nReceived SIGTERM, measurement stopped\n");
+      } else {
+          printf("\nMeasurement stopped\n");
+      }
+      print_ticker(&tick);
+      packet_get_bus_stats(&stats);
+      if (stats.resync_bytes > 0) {
+          printf("Resync: %lu responses recovered, %lu bytes discarded\n",
+                 stats.resync_frames, stats.resync_bytes);
+      }
+    }
+    return STATUS_OK;
+}
+
+/**
+ * Run back-to-back temperature reads and report bus throughput
+ */
+AppStatus poll_benchmark(int fd, uint8_t adr, int n, int count)
+{
+    PACKET pr;
+    uint8_t *p_data;
+    ModbusCtx ctx;
+    WireFrame request;
+    struct timespec t_start, t_end;
+    PacketBusStats stats;
+    double elapsed, polls, legacy_elapsed, legacy_polls;
+    int i;
+    AppStatus status;
+
+    if (n < 1 || n > MAX_CHANNELS) {
+        return ERROR_INVALID_CHANNEL;
+    }
+
+    if (count < 1) {
+        return ERROR_INVALID_TIME;
+    }
+
+    modbus_ctx_init_shared(&ctx, fd);
+    packet_encode_read(&request, adr, '\x03', 0x0000, (uint16_t)n);
+
+    init_signal_handlers();
+    packet_reset_bus_stats();
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+    for (i = 0; i < count && running; i++) {
+        status = modbus_request(&ctx, &request, &pr, 0, "poll_benchmark", &p_data);
+        if (status != STATUS_OK) {
+            return ERROR_READ_TEMPERATURE;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    packet_get_bus_stats(&stats);
+
+    if (i == 0) {
+        return STATUS_OK;
+    }
+
+    elapsed = (double)(t_end.tv_sec - t_start.tv_sec) +
+              (double)(t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+    polls = i / elapsed;
+
+    /* Same run with the gap waits replaced by the old fixed delay */
+    legacy_elapsed = elapsed - stats.gap_wait_us / 1e6 + i * (LEGACY_DELAY_US / 1e6);
+    legacy_polls = i / legacy_elapsed;
+
+    printf("Poll benchmark: %d transactions, %d channel(s), address %d\n", i, n, adr);
+    if (transport_fd_type(fd) == TRANSPORT_SERIAL) {
+        printf("  Baud rate:            %d (applied by driver)\n", serial_get_baud(fd, 0));
+    } else {
+        printf("  Transport:            %s\n", transport_fd_type(fd) == TRANSPORT_MODBUS_TCP ?
+               "Modbus TCP" : "RTU over TCP");
+    }
+    printf("  Elapsed:              %.3f s\n", elapsed);
+    printf("  Polls per second:     %.1f\n", polls);
+    printf("  Mean transaction:     %.2f ms\n", elapsed * 1000.0 / i);
+    printf("  Inter-frame gap:      %lu waits, %.2f ms total\n",
+           stats.gap_waits, stats.gap_wait_us / 1000.0);
+    printf("  With fixed 8 ms gap:  %.1f polls/s (estimated)\n", legacy_polls);
+    printf("  Gain:                 %+.0f %%\n", (polls / legacy_polls - 1.0) * 100.0);
+    if (packet_default_bus()->rtt != NULL) {
+        const RttDevice *d = &packet_default_bus()->rtt->dev[adr];
+        printf("  Round trip:           SRTT %.2f ms, RTTVAR %.2f ms, timeout %.2f ms\n",
+               d->srtt_us / 1000.0, d->rttvar_us / 1000.0, d->rto_us / 1000.0);
+    }
+    if (packet_default_bus()->resync) {
+        printf("  Resync:               %lu responses recovered, %lu bytes discarded\n",
+               stats.resync_frames, stats.resync_bytes);
+    }
+
+    return STATUS_OK;
+}
+
+/**
+ * Measure round trip, apply the low-latency profile and measure again
+ */
+AppStatus latency_benchmark(int fd, const char *device, uint8_t adr, int n, int count)
+{
+    ModbusCtx ctx;
+    WireFrame request;
+    SerialTuning tuning;
+    RttSummary before, after;
+    AppStatus status;
+
+    if (n < 1 || n > MAX_CHANNELS) {
+        return ERROR_INVALID_CHANNEL;
+    }
+
+    if (count < 1) {
+        return ERROR_INVALID_TIME;
+    }
+
+    modbus_ctx_init_shared(&ctx, fd);
+    packet_encode_read(&request, adr, '\x03', 0x0000, (uint16_t)n);
+    init_signal_handlers();
+
+    status = measure_rtt(&ctx, &request, count, &before);
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    serial_tune_low_latency(fd, device, &tuning);
+    packet_set_host_latency(serial_host_latency_us(&tuning));
+    serial_tune_print(stdout, device, &tuning);
+
+    status = measure_rtt(&ctx, &request, count, &after);
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    printf("Latency benchmark: %d transactions per pass, %d channel(s), address %d\n",
+           after.count, n, adr);
+    printf("                     mean ms    min ms    max ms\n");
+    printf("  Default:          %8.2f  %8.2f  %8.2f\n",
+           before.mean_ms, before.min_ms, before.max_ms);
+    printf("  Low-latency:      %8.2f  %8.2f  %8.2f\n",
+           after.mean_ms, after.min_ms, after.max_ms);
+    if (before.mean_ms > 0.0) {
+        printf("  Change:           %+7.0f %%\n",
+               (after.mean_ms / before.mean_ms - 1.0) * 100.0);
+    }
+
+    return STATUS_OK;
+}
+
+/**
+ * Read and print temperature from devices on several ports at once
+ */
+AppStatus read_temp_ports(ModbusCtx ctx[], char *const ports[], int n_ports,
+                          uint8_t adr, int n, long period_ms, TickerPolicy policy,
+                          int one_shot)
+{
+    Poller poller;
+    PortRead port[POLLER_MAX_BUSES];
+    uint8_t *p_data;
+    float T;
+    int i, k;
+    Ticker tick;
+    char time_text[DBUF];
+    AppStatus status;
+
+    if (n < 1 || n > MAX_CHANNELS) {
+        return ERROR_INVALID_CHANNEL;
+    }
+
+    if (period_ms < 0) {
+        return ERROR_INVALID_TIME;
+    }
+
+    init_signal_handlers();
+
+    status = start_poller(&poller, ctx, port, n_ports, adr, n);
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    if (!one_shot) {
+      printf("# Date                  Port        ");
+      for (i=1; i<=n; i++) {
+        printf("  Ch%d",i);
+      }
+      printf("\n");
+    }
+
+    ticker_init(&tick, period_ms, policy);
+    while (running) {
+        /* One request per bus, all buses at once */
+        for (k = 0; k < n_ports; k++) {
+            poller_submit(&poller, k, &port[k].request, read_done, &port[k]);
+        }
+        if (poller_drain(&poller) != STATUS_OK) {
+            poller_close(&poller);
+            return ERROR_READ_TEMPERATURE;
+        }
+
+        for (k = 0; k < n_ports; k++) {
+            if (!one_shot) {
+              timestamp_format(&port[k].sample_time, time_text, sizeof(time_text));
+              printf("%s  %-12s", time_text, ports[k]);
+            }
+            if (port[k].status != STATUS_OK) {
+                fprintf(stderr, "read_temp: %s: %s\n", ports[k],
+                        get_error_message(port[k].status));
+            }
+            p_data = NULL;
+            if (port[k].status == STATUS_OK) {
+                modbus_request_result(port[k].ctx, NULL, &p_data);
+            }
+            for (i=0; i<n; i++) {
+              T = ERRRESP;
+              if (p_data != NULL) {
+                T = (float)INT16(p_data[2*i+1], p_data[2*i])/10; /* Temperature [C] */
+                if (T < MIN_TEMPERATURE || T > MAX_TEMPERATURE)
+                  T = ERRRESP;
+              }
+              if (T != ERRRESP)
+                printf(" %.1f", T);
+              else
+                printf("  NaN");
+            }
+            printf("\n");
+        }
+
         if (one_shot) {
           break;
         }
+        next_sample(&tick, "read_temp");
     }
+
+    poller_close(&poller);
+
+    if (!one_shot) {
+      printf("\nMeasurement stopped\n");
+      print_ticker(&tick);
+      for (k = 0; k < n_ports; k++) {
+          printf("%s: %lu transactions, %lu responses, %lu timeouts, %lu CRC errors\n",
+                 ports[k], ctx[k].stats.transactions, ctx[k].stats.responses,
+                 ctx[k].stats.timeouts, ctx[k].stats.crc_errors);
+      }
+    }
+    return STATUS_OK;
+}
+
+/**
+ * Run back-to-back temperature reads on several ports at once
+ */
+AppStatus poll_benchmark_ports(ModbusCtx ctx[], char *const ports[], int n_ports,
+                               uint8_t adr, int n, int count)
+{
+    Poller poller;
+    PortRead port[POLLER_MAX_BUSES];
+    struct timespec t_start;
+    double elapsed, port_elapsed;
+    int k, total = 0;
+    TransportStats ts;
+    UringStats us;
+    PollerBackend backend;
+    AppStatus status;
+
+    if (n < 1 || n > MAX_CHANNELS) {
+        return ERROR_INVALID_CHANNEL;
+    }
+
+    if (count < 1) {
+        return ERROR_INVALID_TIME;
+    }
+
+    status = start_poller(&poller, ctx, port, n_ports, adr, n);
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    init_signal_handlers();
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+    for (k = 0; k < n_ports; k++) {
+        port[k].remaining = count - 1;
+        port[k].t_end = t_start;
+        poller_submit(&poller, k, &port[k].request, bench_done, &port[k]);
+    }
+
+    /* bench_done() keeps every bus busy until its count is reached */
+    while (poller.outstanding > 0) {
+        if (poller_run(&poller, -1) < 0) {
+            poller_close(&poller);
+            return ERROR_READ_TEMPERATURE;
+        }
+        if (!running) {
+            for (k = 0; k < n_ports; k++) {
+                port[k].remaining = 0;
+            }
+        }
+    }
+    backend = poller.backend;
+    us = poller.ring.stats;
+    poller_close(&poller);
+
+    printf("Poll benchmark: %d port(s), %d channel(s), address %d\n", n_ports, n, adr);
+    elapsed = 0.0;
+    for (k = 0; k < n_ports; k++) {
+        port_elapsed = (double)(port[k].t_end.tv_sec - t_start.tv_sec) +
+                       (double)(port[k].t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+        if (port_elapsed > elapsed) {
+            elapsed = port_elapsed;
+        }
+        total += port[k].done;
+        printf("  %-20s %d transactions, %lu responses, %.1f polls/s\n",
+               ports[k], port[k].done, ctx[k].stats.responses,
+               port_elapsed > 0.0 ? port[k].done / port_elapsed : 0.0);
+    }
+    if (elapsed > 0.0) {
+        printf("  All ports:           %d transactions in %.3f s, %.1f polls/s\n",
+               total, elapsed, total / elapsed);
+    }
+    if (backend == POLLER_URING && total > 0) {
+        printf("  io_uring:            %.2f io_uring_enter() per transaction, "
+               "up to %lu completions per wait\n",
+               (double)us.enters / total, us.batch_max);
+    } else {
+        printf("  Backend:             epoll\n");
+    }
+
+    /* A port listed again shares the Modbus TCP connection of its first entry */
+    for (k = 0; k < n_ports; k++) {
+        int first = 1;
+        for (int j = 0; j < k; j++) {
+            if (strcmp(ports[j], ports[k]) == 0) {
+                first = 0;
+            }
+        }
+        if (first && transport_get_stats(ctx[k].fd, &ts) == 0) {
+            printf("  %-20s %d in flight at most, %lu stale, %lu evicted\n",
+                   ports[k], ts.inflight_max, ts.stale, ts.evicted);
+        }
+    }
+
+    return STATUS_OK;
+}
+
+/**
+ * Print temperatures the device pushes in automatic report mode
+ */
+AppStatus read_temp_auto(int fd, uint8_t adr, int n, int interval, int one_shot)
+{
+    ModbusCtx ctx;
+    AutoReport ar;
+    AutoPrint out;
+    struct pollfd pfd;
+    struct timespec t;
+    int i, rc, wait_ms, silent = 0;
+    AppStatus status = STATUS_OK;
+
+    if (n < 1 || n > MAX_CHANNELS) {
+        return ERROR_INVALID_CHANNEL;
+    }
+
+    if (interval < 1 || interval > AUTOREPORT_MAX) {
+        return ERROR_INVALID_TIME;
+    }
+
+    init_signal_handlers();
+
+    modbus_ctx_init_shared(&ctx, fd);
+    if (autoreport_set(&ctx, adr, interval) != STATUS_OK) {
+        return ERROR_AUTO_REPORT;
+    }
+
+    memset(&out, 0, sizeof(out));
+    out.n = n;
+    out.one_shot = one_shot;
+    clock_gettime(CLOCK_MONOTONIC, &out.last);
+
+    autoreport_init(&ar, fd, ctx.bus);
+    autoreport_route(&ar, adr, auto_print, &out);
+    out.ar = &ar;
+
+    if (!one_shot) {
+      printf("# Automatic report every %d s\n", interval);
+      printf("# Date                ");
+      for (i=1; i<=n; i++) {
+        printf("  Ch%d",i);
+      }
+      printf("\n");
+    }
+
+    /* No requests: wait for the line, a partial frame or a second to pass */
+    while (running && !(one_shot && out.samples > 0)) {
+        wait_ms = autoreport_wait_ms(&ar);
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        rc = poll(&pfd, 1, wait_ms >= 0 && wait_ms < 1000 ? wait_ms : 1000);
+        if (rc < 0) {
+            continue;  /* Interrupted by a signal */
+        }
+        if (autoreport_advance(&ar, rc > 0 && (pfd.revents & POLLIN)) < 0) {
+            status = ERROR_RECEIVE_PACKET;
+            break;
+        }
+
+        /* Device silent for two intervals: report it once */
+        clock_gettime(CLOCK_MONOTONIC, &t);
+        if (t.tv_sec - out.last.tv_sec > 2 * interval) {
+            if (!silent) {
+                fprintf(stderr, "read_temp: no report for %ld s\n",
+                        (long)(t.tv_sec - out.last.tv_sec));
+            }
+            silent = 1;
+        } else {
+            silent = 0;
+        }
+    }
+
+    /* Back to query mode, the device stays in push mode otherwise */
+    if (autoreport_set(&ctx, adr, 0) != STATUS_OK) {
+        fprintf(stderr, "read_temp: automatic report of device %d not switched off\n", adr);
+        if (status == STATUS_OK) {
+            status = ERROR_AUTO_REPORT;
+        }
+    }
+
     if (!one_shot) {
       int sig = get_received_signal();
       if (sig == SIGINT) {
@@ -191,6 +691,203 @@ AppStatus read_temp(int fd, uint8_t adr, int n, int dt, int m_f,
       } else {
           printf("\nMeasurement stopped\n");
       }
+      printf("Automatic report: %lu reports, %lu of other devices, %lu bytes dropped\n",
+             ar.stats.frames, ar.stats.unrouted, ar.stats.noise_bytes);
+    }
+    return status;
+}
+
+/**
+ * Read and print the automatic report interval
+ */
+AppStatus read_auto_report(int fd, uint8_t adr)
+{
+    ModbusCtx ctx;
+    int seconds;
+
+    modbus_ctx_init_shared(&ctx, fd);
+    if (autoreport_get(&ctx, adr, &seconds) != STATUS_OK) {
+        return ERROR_AUTO_REPORT;
+    }
+
+    if (seconds == 0) {
+        printf("Automatic report: off (query mode)\n");
+    } else {
+        printf("Automatic report: every %d s\n", seconds);
+    }
+
+    return STATUS_OK;
+}
+
+/* Local functions */
+
+/*
+ *  Store result and time of a read
+ */
+static void read_done(Poller *poller, int bus, AppStatus status, void *arg)
+{
+    PortRead *port = arg;
+
+    (void)poller;
+    (void)bus;
+
+    port->status = status;
+    modbus_request_time(port->ctx, &port->sample_time);
+}
+
+/*
+ *  Print one pushed report
+ */
+static void auto_print(uint8_t addr, const PACKET *p, void *arg)
+{
+    AutoPrint *out = arg;
+    Timestamp ts;
+    char sample_time[DBUF];
+    float T;
+    int i;
+
+    (void)addr;
+
+    if (out->one_shot && out->samples > 0) {
+        return;  /* Second report in the same read */
+    }
+    out->samples++;
+    clock_gettime(CLOCK_MONOTONIC, &out->last);
+
+    if (!out->one_shot) {
+      autoreport_time(out->ar, &ts);
+      timestamp_format(&ts, sample_time, sizeof(sample_time));
+      printf("%s ", sample_time);
+    }
+
+    for (i=0; i<out->n; i++) {
+      T = ERRRESP;
+      if (2*i+1 < p->len) {
+        T = (float)INT16(p->data[2*i+1], p->data[2*i])/10; /* Temperature [C] */
+        if (T < MIN_TEMPERATURE || T > MAX_TEMPERATURE)
+          T = ERRRESP;
+      }
+      if (T != ERRRESP)
+        printf(" %.1f", T);
+      else
+        printf("  NaN");
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+/*
+ *  Count a benchmark transaction and start the next one on the same bus
+ */
+static void bench_done(Poller *poller, int bus, AppStatus status, void *arg)
+{
+    PortRead *port = arg;
+
+    port->status = status;
+    port->done++;
+    clock_gettime(CLOCK_MONOTONIC, &port->t_end);
+
+    if (port->remaining > 0) {
+        port->remaining--;
+        poller_submit(poller, bus, &port->request, bench_done, port);
+    }
+}
+
+/*
+ *  Register the ports with a new poller and encode their read requests
+ */
+static AppStatus start_poller(Poller *poller, ModbusCtx ctx[], PortRead port[],
+                              int n_ports, uint8_t adr, int n)
+{
+    AppStatus status;
+
+    if (n_ports < 1 || n_ports > POLLER_MAX_BUSES) {
+        return ERROR_INVALID_PORT;
+    }
+
+    status = poller_init(poller);
+    if (status != STATUS_OK) {
+        return status;
+    }
+
+    for (int k = 0; k < n_ports; k++) {
+        memset(&port[k], 0, sizeof(PortRead));
+        port[k].ctx = &ctx[k];
+        port[k].status = ERROR_PACKET_TIMEOUT;
+        packet_encode_read(&port[k].request, adr, '\x03', 0x0000, (uint16_t)n);
+        if (poller_add(poller, &ctx[k]) < 0) {
+            poller_close(poller);
+            return ERROR_PORT_INIT;
+        }
     }
+
     return STATUS_OK;
 }
+
+/*
+ *  Time count back-to-back transactions
+ */
+static AppStatus measure_rtt(ModbusCtx *ctx, const WireFrame *request, int count,
+                             RttSummary *sum)
+{
+    PACKET pr;
+    uint8_t *p_data;
+    struct timespec t0, t1;
+    double ms, total = 0.0;
+    int i;
+
+    memset(sum, 0, sizeof(RttSummary));
+
+    for (i = 0; i < count && running; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        if (modbus_request(ctx, request, &pr, 0, "latency_benchmark", &p_data) != STATUS_OK) {
+            return ERROR_READ_TEMPERATURE;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        ms = (double)(t1.tv_sec - t0.tv_sec) * 1e3 +
+             (double)(t1.tv_nsec - t0.tv_nsec) / 1e6;
+        total += ms;
+        if (i == 0 || ms < sum->min_ms) {
+            sum->min_ms = ms;
+        }
+        if (ms > sum->max_ms) {
+            sum->max_ms = ms;
+        }
+    }
+
+    sum->count = i;
+    sum->mean_ms = i > 0 ? total / i : 0.0;
+
+    return STATUS_OK;
+}
+
+/*
+ *  Wait for the next sample time, report an overrun of the time step
+ */
+static void next_sample(Ticker *tick, const char *func)
+{
+    unsigned long skipped = tick->skipped;
+
+    if (ticker_wait(tick, &running) != 1) {
+        return;
+    }
+    if (tick->policy == TICKER_SKIP) {
+        fprintf(stderr, "%s: overrun by %.1f ms, %lu sample(s) skipped\n",
+                func, tick->late_us / 1000.0, tick->skipped - skipped);
+    } else {
+        fprintf(stderr, "%s: overrun by %.1f ms, catching up\n",
+                func, tick->late_us / 1000.0);
+    }
+}
+
+/*
+ *  Print overruns of the time step
+ */
+static void print_ticker(const Ticker *tick)
+{
+    if (tick->overruns > 0) {
+        printf("Overruns: %lu of %lu samples, %lu skipped, max %.1f ms late\n",
+               tick->overruns, tick->ticks, tick->skipped, tick->late_max_us / 1000.0);
+    }
+}
@@ -1,12 +1,19 @@
 /*
  * Temperature reading functions
  * V1.0/2025-04-17
+ * V1.1/2026-10-16 Several ports polled at once
+ * V1.2/2026-10-16 Low-latency profile benchmark
+ * V1.3/2026-10-16 Temperature shown next to the correction
+ * V1.4/2026-10-16 Automatic report mode
+ * V1.5/2026-10-16 Millisecond time step on a drift-free ticker
  */
 #ifndef READ_FUNCTIONS_H
 #define READ_FUNCTIONS_H
 
 #include <stdint.h>
 #include "error.h"
+#include "modbus_ctx.h"
+#include "ticker.h"
 
 /**
  * Read and print temperature from 1..n channels
@@ -14,7 +21,8 @@
  * @param fd File descriptor for the serial port
  * @param adr Device address
  * @param n Number of channels to read (1-8)
- * @param dt Time step between measurements in seconds
+ * @param period_ms Time step between measurements in milliseconds (0 = back-to-back)
+ * @param policy Skip or catch up samples missed when a cycle overruns the time step
  * @param m_f Flag to enable (1) or disable (0) three-point median filter
  * @param maf_f Flag to enable (1) or disable (0) MAF filter
  * @param maf_window MAF window size (3-15, odd)
@@ -22,12 +30,15 @@
  *
  * @return STATUS_OK on success, otherwise an error code from AppStatus enum
  */
-AppStatus read_temp(int fd, uint8_t adr, int n, int dt, int m_f,
-                    int maf_f, int maf_window, int one_shot);
+AppStatus read_temp(int fd, uint8_t adr, int n, long period_ms, TickerPolicy policy,
+                    int m_f, int maf_f, int maf_window, int one_shot);
 
 /**
- * Read and print correction temperature for all channels
- * 
+ * Read and print temperature and correction for all channels
+ *
+ * Both register ranges come back in one planned read (regplan), so a
+ * calibration check costs a single round trip.
+ *
  * @param fd File descriptor for the serial port
  * @param adr Device address
  * 
@@ -35,4 +46,97 @@ AppStatus read_temp(int fd, uint8_t adr, int n, int dt, int m_f,
  */
 AppStatus read_correction(int fd, uint8_t adr);
 
+/**
+ * Run back-to-back temperature reads and report bus throughput
+ *
+ * Prints polls per second, mean round trip and the time spent keeping
+ * the t3.5 inter-frame gap, together with an estimate for the fixed
+ * 8 ms post-receive delay used before V1.14.
+ *
+ * @param fd File descriptor for the serial port
+ * @param adr Device address
+ * @param n Number of channels to read (1-8)
+ * @param count Number of transactions
+ *
+ * @return STATUS_OK on success, otherwise an error code from AppStatus enum
+ */
+AppStatus poll_benchmark(int fd, uint8_t adr, int n, int count);
+
+/**
+ * Measure round trip, apply the low-latency RS485 profile and measure again
+ *
+ * Prints what the driver accepted of the profile and mean, shortest and
+ * longest round trip of both passes. The profile stays applied.
+ *
+ * @param fd File descriptor for the serial port
+ * @param device Path to the serial device
+ * @param adr Device address
+ * @param n Number of channels to read (1-8)
+ * @param count Number of transactions per pass
+ *
+ * @return STATUS_OK on success, otherwise an error code from AppStatus enum
+ */
+AppStatus latency_benchmark(int fd, const char *device, uint8_t adr, int n, int count);
+
+/**
+ * Read and print temperature from devices on several ports at once
+ * One line per port and sample; the reads on all ports overlap in time.
+ * A port that does not answer prints NaN and is read again next time.
+ * @param ctx Contexts of the open ports
+ * @param ports Port names
+ * @param n_ports Number of ports
+ * @param adr Device address (same on every port)
+ * @param n Number of channels to read (1-8)
+ * @param period_ms Time step between measurements in milliseconds (0 = back-to-back)
+ * @param policy Skip or catch up samples missed when a cycle overruns the time step
+ * @param one_shot Flag to enable (1) or disable (0) one shot measure without timestamp
+ * @return STATUS_OK on success, otherwise an error code from AppStatus enum
+ */
+AppStatus read_temp_ports(ModbusCtx ctx[], char *const ports[], int n_ports,
+                          uint8_t adr, int n, long period_ms, TickerPolicy policy,
+                          int one_shot);
+
+/**
+ * Run back-to-back temperature reads on several ports at once
+ * Every port runs count transactions; reports polls per second per port
+ * and for all ports together.
+ * @param ctx Contexts of the open ports
+ * @param ports Port names
+ * @param n_ports Number of ports
+ * @param adr Device address (same on every port)
+ * @param n Number of channels to read (1-8)
+ * @param count Number of transactions per port
+ * @return STATUS_OK on success, otherwise an error code from AppStatus enum
+ */
+AppStatus poll_benchmark_ports(ModbusCtx ctx[], char *const ports[], int n_ports,
+                               uint8_t adr, int n, int count);
+
+/**
+ * Print temperatures the device pushes in automatic report mode
+ *
+ * Sets register 0x00FD to the interval and listens without sending any
+ * request; reports of other addresses on the bus are skipped. The device
+ * is switched back to query mode on Ctrl+C (after the first report with
+ * one_shot).
+ *
+ * @param fd File descriptor for the serial port
+ * @param adr Device address
+ * @param n Number of channels to print (1-8)
+ * @param interval Report interval in seconds (1-255)
+ * @param one_shot Flag to enable (1) or disable (0) one shot measure without timestamp
+ *
+ * @return STATUS_OK on success, otherwise an error code from AppStatus enum
+ */
+AppStatus read_temp_auto(int fd, uint8_t adr, int n, int interval, int one_shot);
+
+/**
+ * Read and print the automatic report interval
+ *
+ * @param fd File descriptor for the serial port
+ * @param adr Device address
+ *
+ * @return STATUS_OK on success, otherwise an error code from AppStatus enum
+ */
+AppStatus read_auto_report(int fd, uint8_t adr);
+
 #endif /* READ_FUNCTIONS_H */
@@ -0,0 +1,215 @@
+/*
+ *  Real-time execution: SCHED_FIFO, locked memory and CPU pinning
+ *  V1.0/2026-10-16
+ */
+#define _GNU_SOURCE  /* CPU_SET, pthread_setaffinity_np */
+
+#include <stdio.h>        /* snprintf, /proc/self/status */
+#include <stdlib.h>       /* strtol */
+#include <string.h>       /* strerror, strlen */
+#include <errno.h>        /* errno */
+#include <sched.h>        /* SCHED_FIFO, cpu_set_t */
+#include <pthread.h>      /* pthread_setschedparam */
+#include <sys/mman.h>     /* mlockall */
+#include <sys/resource.h> /* RLIMIT_RTPRIO, RLIMIT_MEMLOCK */
+
+#include "realtime.h"
+
+/* Capability bits (linux/capability.h) */
+#define CAP_BIT_IPC_LOCK 14
+#define CAP_BIT_SYS_NICE 23
+
+/*
+ *  Local function prototypes
+ */
+static int has_capability(int bit);
+static void append(char *msg, size_t len, const char *text);
+
+/**********************************************************************/
+
+/*
+ *  Parse a real-time setting "prio[:cpu]"
+ */
+int realtime_parse(const char *spec, RealtimeConfig *rt)
+{
+    char *end;
+    long prio, cpu = -1;
+
+    prio = strtol(spec, &end, 10);
+    if (end == spec || prio < 1 || prio > 99) {
+        return -1;
+    }
+    if (*end == ':') {
+        spec = end + 1;
+        cpu = strtol(spec, &end, 10);
+        if (end == spec || cpu < 0 || cpu >= CPU_SETSIZE) {
+            return -1;
+        }
+    }
+    if (*end != '\0') {
+        return -1;
+    }
+
+    rt->priority = (int)prio;
+    rt->cpu = (int)cpu;
+    return 0;
+}
+
+/*
+ *  Check that the process may use a real-time setting
+ */
+int realtime_check(const RealtimeConfig *rt, char *msg, size_t len)
+{
+    struct rlimit lim = { 0, 0 };
+    cpu_set_t allowed;
+    char text[128];
+
+    msg[0] = '\0';
+
+    if (rt->priority < sched_get_priority_min(SCHED_FIFO) ||
+        rt->priority > sched_get_priority_max(SCHED_FIFO)) {
+        snprintf(text, sizeof(text), "SCHED_FIFO priority %d is not %d..%d", rt->priority,
+                 sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+        append(msg, len, text);
+    } else if (!has_capability(CAP_BIT_SYS_NICE) &&
+               (getrlimit(RLIMIT_RTPRIO, &lim) != 0 ||
+                (lim.rlim_cur != RLIM_INFINITY && lim.rlim_cur < (rlim_t)rt->priority))) {
+        snprintf(text, sizeof(text),
+                 "SCHED_FIFO %d needs CAP_SYS_NICE or RLIMIT_RTPRIO >= %d (is %lu)",
+                 rt->priority, rt->priority, (unsigned long)lim.rlim_cur);
+        append(msg, len, text);
+    }
+
+    if (!has_capability(CAP_BIT_IPC_LOCK) &&
+        (getrlimit(RLIMIT_MEMLOCK, &lim) != 0 || lim.rlim_cur != RLIM_INFINITY)) {
+        snprintf(text, sizeof(text),
+                 "mlockall() needs CAP_IPC_LOCK or unlimited RLIMIT_MEMLOCK (is %lu kB)",
+                 (unsigned long)(lim.rlim_cur / 1024));
+        append(msg, len, text);
+    }
+
+    if (rt->cpu >= 0 &&
+        (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 ||
+         !CPU_ISSET(rt->cpu, &allowed))) {
+        snprintf(text, sizeof(text), "CPU %d is not available to this process", rt->cpu);
+        append(msg, len, text);
+    }
+
+    return msg[0] == '\0' ? 0 : -1;
+}
+
+/*
+ *  Lock all memory and move the calling thread off the polling CPU
+ */
+int realtime_prepare(const RealtimeConfig *rt, char *msg, size_t len)
+{
+    cpu_set_t others;
+    int rc;
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        snprintf(msg, len, "mlockall: %s", strerror(errno));
+        return -1;
+    }
+
+    if (rt->cpu < 0 || sched_getaffinity(0, sizeof(others), &others) != 0) {
+        return 0;
+    }
+
+    /* Threads created from here on stay off the polling CPU */
+    CPU_CLR(rt->cpu, &others);
+    if (CPU_COUNT(&others) == 0) {
+        return 0;  /* Single CPU, everything shares it */
+    }
+    rc = pthread_setaffinity_np(pthread_self(), sizeof(others), &others);
+    if (rc != 0) {
+        snprintf(msg, len, "CPU affinity of other threads: %s", strerror(rc));
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ *  Pin the calling thread to the polling CPU and raise it to SCHED_FIFO
+ */
+int realtime_enter(const RealtimeConfig *rt, char *msg, size_t len)
+{
+    volatile char stack[REALTIME_STACK_PREFAULT];
+    struct sched_param param;
+    cpu_set_t cpu;
+    size_t i;
+    int rc;
+
+    /* Fault in the stack now, memory is locked from here on */
+    for (i = 0; i < sizeof(stack); i++) {
+        stack[i] = 0;
+    }
+
+    if (rt->cpu >= 0) {
+        CPU_ZERO(&cpu);
+        CPU_SET(rt->cpu, &cpu);
+        rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu), &cpu);
+        if (rc != 0) {
+            snprintf(msg, len, "pinning to CPU %d: %s", rt->cpu, strerror(rc));
+            return -1;
+        }
+    }
+
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = rt->priority;
+    rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        snprintf(msg, len, "SCHED_FIFO %d: %s", rt->priority, strerror(rc));
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ *  Format a real-time setting as "prio[:cpu]"
+ */
+void realtime_format(const RealtimeConfig *rt, char *buf, size_t len)
+{
+    if (rt->cpu >= 0) {
+        snprintf(buf, len, "%d:%d", rt->priority, rt->cpu);
+    } else {
+        snprintf(buf, len, "%d", rt->priority);
+    }
+}
+
+/* Local functions */
+
+/*
+ *  Is a capability in the effective set of the process
+ */
+static int has_capability(int bit)
+{
+    FILE *f = fopen("/proc/self/status", "r");
+    char line[128];
+    unsigned long long caps = 0;
+
+    if (f == NULL) {
+        return 0;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (sscanf(line, "CapEff: %llx", &caps) == 1) {
+            break;
+        }
+    }
+    fclose(f);
+
+    return (caps >> bit) & 1;
+}
+
+/*
+ *  Append a text to a "; " separated message
+ */
+static void append(char *msg, size_t len, const char *text)
+{
+    size_t used = strlen(msg);
+
+    if (used + 1 < len) {
+        snprintf(msg + used, len - used, "%s%s", used > 0 ? "; " : "", text);
+    }
+}
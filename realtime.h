@@ -0,0 +1,88 @@
+/*
+ *  Real-time execution: SCHED_FIFO, locked memory and CPU pinning
+ *  V1.0/2026-10-16
+ *
+ *  The polling thread runs under SCHED_FIFO on a CPU of its own with all
+ *  memory locked, so a load spike of other programs neither preempts a
+ *  transaction nor pages out the code and buffers it needs.
+ *
+ *  realtime_prepare() locks the memory and moves the calling thread off
+ *  the polling CPU; threads created after it (the MQTT network thread)
+ *  inherit the other CPUs and the normal policy. realtime_enter() then
+ *  pins the polling thread and raises it to SCHED_FIFO.
+ */
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <stddef.h>  /* For size_t */
+
+/* Text of a real-time setting: "prio[:cpu]" */
+#define REALTIME_SPEC_MAX 16
+
+/* Stack the polling thread touches once, so it never faults under SCHED_FIFO */
+#define REALTIME_STACK_PREFAULT (64 * 1024)
+
+/**
+ * Real-time setting
+ */
+typedef struct {
+    int priority;            /* SCHED_FIFO priority 1-99, 0 = off */
+    int cpu;                 /* CPU of the polling thread, -1 = not pinned */
+} RealtimeConfig;
+
+/**
+ * Parse a real-time setting
+ *
+ * @param spec "prio" or "prio:cpu", e.g. "50:3"
+ * @param rt   Pointer to store the setting
+ * @return     0 on success, -1 if spec is invalid
+ */
+extern int realtime_parse(const char *spec, RealtimeConfig *rt);
+
+/**
+ * Check that the process may use a real-time setting
+ *
+ * SCHED_FIFO needs CAP_SYS_NICE or an RLIMIT_RTPRIO of at least the
+ * priority, mlockall() CAP_IPC_LOCK or an unlimited RLIMIT_MEMLOCK, and
+ * the CPU must be one the process may run on. Every missing item is
+ * written to msg, separated by "; ".
+ *
+ * @param rt  Real-time setting
+ * @param msg Buffer for the missing privileges
+ * @param len Size of msg
+ * @return    0 if everything is available, -1 otherwise
+ */
+extern int realtime_check(const RealtimeConfig *rt, char *msg, size_t len);
+
+/**
+ * Lock all memory and move the calling thread off the polling CPU
+ *
+ * Call before other threads are created, they inherit the affinity.
+ *
+ * @param rt  Real-time setting
+ * @param msg Buffer for the error
+ * @param len Size of msg
+ * @return    0 on success, -1 on error
+ */
+extern int realtime_prepare(const RealtimeConfig *rt, char *msg, size_t len);
+
+/**
+ * Pin the calling thread to the polling CPU and raise it to SCHED_FIFO
+ *
+ * @param rt  Real-time setting
+ * @param msg Buffer for the error
+ * @param len Size of msg
+ * @return    0 on success, -1 on error
+ */
+extern int realtime_enter(const RealtimeConfig *rt, char *msg, size_t len);
+
+/**
+ * Format a real-time setting as "prio[:cpu]"
+ *
+ * @param rt  Real-time setting
+ * @param buf Output buffer, REALTIME_SPEC_MAX bytes are always enough
+ * @param len Size of buf
+ */
+extern void realtime_format(const RealtimeConfig *rt, char *buf, size_t len);
+
+#endif /* REALTIME_H */
@@ -0,0 +1,207 @@
+/*
+ *  Register-range transaction planner
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Merged reads quiet, a split goes on from the rejected read
+ */
+#include <stdio.h>   /* fprintf */
+#include <stdint.h>  /* Specific width integer types */
+#include <string.h>  /* memset */
+
+#include "typedef.h"     /* PACKET */
+#include "modbus_ctx.h"  /* Device communication */
+#include "regplan.h"
+
+/* Read holding registers */
+#define FUNC_READ_HOLDING 0x03
+
+/*
+ *  Local function prototypes
+ */
+static AppStatus read_range(ModbusCtx *ctx, const RegRead *rd, uint8_t adr, uint8_t **data);
+static void decode(RegPlan *plan, int read, const uint8_t *data);
+
+/**********************************************************************/
+
+/*
+ *  Initialize an empty plan
+ */
+void regplan_init(RegPlan *plan, uint16_t max_regs, uint16_t max_gap)
+{
+    memset(plan, 0, sizeof(RegPlan));
+
+    if (max_regs == 0 || max_regs > REGPLAN_MODBUS_MAX) {
+        max_regs = REGPLAN_MODBUS_MAX;
+    }
+    plan->max_regs = max_regs;
+    plan->max_gap = max_gap;
+}
+
+/*
+ *  Add a wanted register range
+ */
+int regplan_add(RegPlan *plan, uint16_t start, uint16_t count, uint16_t *values)
+{
+    RegRange *r;
+
+    if (plan->n_range >= REGPLAN_MAX_RANGES || values == NULL ||
+        count == 0 || count > plan->max_regs || start + count > 0x10000) {
+        return -1;
+    }
+
+    r = &plan->range[plan->n_range];
+    r->start = start;
+    r->count = count;
+    r->values = values;
+    r->read = -1;
+    r->status = STATUS_OK;
+
+    plan->n_read = 0;  /* Build again */
+    return plan->n_range++;
+}
+
+/*
+ *  Merge the wanted ranges into reads
+ */
+int regplan_build(RegPlan *plan)
+{
+    int order[REGPLAN_MAX_RANGES];
+    int i, j, k;
+    long end = 0;
+
+    /* Ranges by first register */
+    for (i = 0; i < plan->n_range; i++) {
+        k = i;
+        for (j = i; j > 0 && plan->range[order[j - 1]].start > plan->range[k].start; j--) {
+            order[j] = order[j - 1];
+        }
+        order[j] = k;
+    }
+
+    plan->n_read = 0;
+    for (i = 0; i < plan->n_range; i++) {
+        RegRange *r = &plan->range[order[i]];
+        RegRead *rd = plan->n_read > 0 ? &plan->read[plan->n_read - 1] : NULL;
+        long r_end = (long)r->start + r->count;
+        long new_end = r_end > end ? r_end : end;
+
+        if (rd != NULL && !plan->split &&
+            r->start <= end + plan->max_gap &&
+            new_end - rd->start <= plan->max_regs) {
+            rd->count = (uint16_t)(new_end - rd->start);
+            rd->ranges++;
+            end = new_end;
+        } else {
+            rd = &plan->read[plan->n_read++];
+            rd->start = r->start;
+            rd->count = r->count;
+            rd->ranges = 1;
+            end = r_end;
+        }
+        r->read = plan->n_read - 1;
+    }
+
+    return plan->n_read;
+}
+
+/*
+ *  Run the planned reads and decode the values into every range
+ */
+AppStatus regplan_execute(RegPlan *plan, int fd, uint8_t adr)
+{
+    ModbusCtx ctx;
+    AppStatus status, first = STATUS_OK;
+    uint8_t *data;
+    int i, k, n_done = 0;
+
+    if (plan->n_read == 0 && regplan_build(plan) == 0) {
+        return STATUS_OK;
+    }
+
+    modbus_ctx_init_shared(&ctx, fd);
+
+    for (i = 0; i < plan->n_read; i++) {
+        /* A rejected merged read is retried split, its errors are not the user's */
+        ctx.quiet = plan->read[i].ranges > 1;
+        status = read_range(&ctx, &plan->read[i], adr, &data);
+
+        /*
+         * Device does not return this span at once, read ranges one by one.
+         * Both plans take the ranges in the same order, so the split read
+         * of the first range not read yet is read n_done.
+         */
+        if (status == ERROR_PACKET_EXCEPTION && plan->read[i].ranges > 1) {
+            plan->split = 1;
+            regplan_build(plan);
+            i = n_done - 1;
+            continue;
+        }
+        if (status != STATUS_OK && ctx.quiet) {
+            fprintf(stderr, "regplan: Reading %d registers from 0x%04X failed: %s\n",
+                    plan->read[i].count, plan->read[i].start, get_error_message(status));
+        }
+
+        if (status == STATUS_OK) {
+            decode(plan, i, data);
+        } else if (first == STATUS_OK) {
+            first = status;
+        }
+        for (k = 0; k < plan->n_range; k++) {
+            if (plan->range[k].read == i) {
+                plan->range[k].status = status;
+            }
+        }
+        n_done += plan->read[i].ranges;
+    }
+
+    return first;
+}
+
+/* Local functions */
+
+/*
+ *  Read one span of holding registers
+ */
+static AppStatus read_range(ModbusCtx *ctx, const RegRead *rd, uint8_t adr, uint8_t **data)
+{
+    PACKET pr;
+    uint8_t input_data[4];
+    AppStatus status;
+
+    /* Register address (2 byte) + Read number (2 byte) */
+    input_data[0] = (uint8_t)(rd->start >> 8);
+    input_data[1] = (uint8_t)(rd->start & 0xFF);
+    input_data[2] = (uint8_t)(rd->count >> 8);
+    input_data[3] = (uint8_t)(rd->count & 0xFF);
+
+    status = modbus_transaction(ctx, adr, FUNC_READ_HOLDING, 4, input_data, &pr, 0,
+                                "regplan", 0, data);
+    if (status != STATUS_OK) {
+        return status;
+    }
+    if (pr.len != 2 * rd->count) {
+        return ERROR_RECEIVE_PACKET;
+    }
+
+    return STATUS_OK;
+}
+
+/*
+ *  Copy the registers of one read to the ranges it covers
+ */
+static void decode(RegPlan *plan, int read, const uint8_t *data)
+{
+    const RegRead *rd = &plan->read[read];
+
+    for (int k = 0; k < plan->n_range; k++) {
+        RegRange *r = &plan->range[k];
+        const uint8_t *p;
+
+        if (r->read != read) {
+            continue;
+        }
+        p = data + 2 * (r->start - rd->start);
+        for (int j = 0; j < r->count; j++) {
+            r->values[j] = (uint16_t)((p[2 * j] << 8) | p[2 * j + 1]);  /* Big endian */
+        }
+    }
+}
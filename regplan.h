@@ -0,0 +1,107 @@
+/*
+ *  Register-range transaction planner
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Merged reads quiet, a split goes on from the rejected read
+ *
+ *  Callers register the holding register ranges they want from one
+ *  device, the planner merges them into the fewest Function 0x03 reads
+ *  the device allows and hands the decoded values back to each range.
+ *  A device that rejects a merged read with an exception gets one read
+ *  per range from then on.
+ */
+#ifndef REGPLAN_H
+#define REGPLAN_H
+
+#include <stdint.h>  /* For uint8_t, uint16_t */
+#include "error.h"   /* For AppStatus */
+
+/* Most registers in one 0x03 response (Modbus limit) */
+#define REGPLAN_MODBUS_MAX 125
+
+/* Most ranges in one plan */
+#define REGPLAN_MAX_RANGES 16
+
+/**
+ * One wanted register range
+ */
+typedef struct {
+    uint16_t start;      /* First register */
+    uint16_t count;      /* Number of registers */
+    uint16_t *values;    /* Decoded values, count entries (owned by caller) */
+    int read;            /* Index of the read that covers the range */
+    AppStatus status;    /* Result of the last regplan_execute() */
+} RegRange;
+
+/**
+ * One planned 0x03 read
+ */
+typedef struct {
+    uint16_t start;      /* First register */
+    uint16_t count;      /* Number of registers */
+    int ranges;          /* Number of ranges it covers */
+} RegRead;
+
+/**
+ * Transaction plan for one device
+ */
+typedef struct {
+    RegRange range[REGPLAN_MAX_RANGES];  /* Wanted ranges */
+    int n_range;                         /* Number of wanted ranges */
+    RegRead read[REGPLAN_MAX_RANGES];    /* Planned reads */
+    int n_read;                          /* Number of planned reads */
+    uint16_t max_regs;                   /* Most registers the device returns at once */
+    uint16_t max_gap;                    /* Most unwanted registers read over to merge */
+    int split;                           /* Device rejected a merged read */
+} RegPlan;
+
+/**
+ * Initialize an empty plan
+ *
+ * @param plan     Pointer to plan
+ * @param max_regs Most registers the device returns in one read
+ *                 (0 or above REGPLAN_MODBUS_MAX = Modbus limit)
+ * @param max_gap  Most registers between two ranges that may be read
+ *                 and discarded to merge them (0 = only adjacent or
+ *                 overlapping ranges are merged)
+ */
+extern void regplan_init(RegPlan *plan, uint16_t max_regs, uint16_t max_gap);
+
+/**
+ * Add a wanted register range
+ *
+ * @param plan   Pointer to plan
+ * @param start  First register
+ * @param count  Number of registers (1..max_regs)
+ * @param values Buffer for count decoded values
+ * @return       Range index, -1 if the plan is full or the range invalid
+ */
+extern int regplan_add(RegPlan *plan, uint16_t start, uint16_t count, uint16_t *values);
+
+/**
+ * Merge the wanted ranges into reads
+ *
+ * Called by regplan_execute() when ranges were added since the last
+ * build; call it directly to inspect the reads before executing.
+ *
+ * @param plan Pointer to plan
+ * @return     Number of reads
+ */
+extern int regplan_build(RegPlan *plan);
+
+/**
+ * Run the planned reads and decode the values into every range
+ *
+ * A merged read answered with a Modbus exception is retried as one read
+ * per range, and the plan stays split for later executions. Ranges read
+ * before the rejected read are not read again. The merged read reports
+ * no exception, only the reads whose result counts print their errors.
+ *
+ * @param plan Pointer to plan
+ * @param fd   File descriptor of the serial port
+ * @param adr  Device address
+ * @return     STATUS_OK if every range was read, else the first error
+ *             (the result of each range is in its status)
+ */
+extern AppStatus regplan_execute(RegPlan *plan, int fd, uint8_t adr);
+
+#endif /* REGPLAN_H */
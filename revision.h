@@ -1,5 +1,5 @@
 /*
 * revision.h - define the version number
 */
-#define VERSION "1.13"
-#define REVDATE "2026-01-28"
+#define VERSION "1.14"
+#define REVDATE "2026-10-16"
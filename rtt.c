@@ -0,0 +1,124 @@
+/*
+ *  Adaptive response timeouts from round-trip statistics
+ *  V1.0/2026-10-16
+ */
+#include <stdint.h>  /* Specific width integer types */
+#include <string.h>  /* memset */
+
+#include "rtt.h"
+
+/* Clock granularity term of RFC 6298, covers scheduling jitter */
+#define RTT_GRANULARITY_US 2000
+
+/*
+ *  Local function prototypes
+ */
+static long rtt_clamp(const RttTable *t, long us);
+
+/**********************************************************************/
+
+/*
+ *  Initialize table
+ */
+void rtt_init(RttTable *t, int floor_ms, int ceiling_ms)
+{
+    memset(t, 0, sizeof(RttTable));
+
+    if (floor_ms < 1) {
+        floor_ms = 1;
+    }
+    if (ceiling_ms < floor_ms) {
+        ceiling_ms = floor_ms;
+    }
+
+    t->floor_us = floor_ms * 1000L;
+    t->ceiling_us = ceiling_ms * 1000L;
+}
+
+/*
+ *  Get response timeout for a device
+ */
+int rtt_timeout_ms(const RttTable *t, uint8_t addr, int default_ms)
+{
+    const RttDevice *d = &t->dev[addr];
+    long us;
+
+    if (d->samples == 0) {
+        us = default_ms * 1000L;
+        if (us > t->ceiling_us) {
+            us = t->ceiling_us;
+        }
+        return (int)(us / 1000);
+    }
+
+    return (int)((d->rto_us + 999) / 1000);
+}
+
+/*
+ *  Account for a measured round trip
+ */
+void rtt_sample(RttTable *t, uint8_t addr, long rtt_us)
+{
+    RttDevice *d = &t->dev[addr];
+    long err;
+    long var;
+
+    if (rtt_us < 0) {
+        return;
+    }
+
+    if (d->samples == 0) {
+        d->srtt_us = rtt_us;
+        d->rttvar_us = rtt_us / 2;
+    } else {
+        /* RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, SRTT = 7/8 SRTT + 1/8 R */
+        err = d->srtt_us - rtt_us;
+        if (err < 0) {
+            err = -err;
+        }
+        d->rttvar_us += (err - d->rttvar_us) / 4;
+        d->srtt_us += (rtt_us - d->srtt_us) / 8;
+    }
+
+    var = 4 * d->rttvar_us;
+    if (var < RTT_GRANULARITY_US) {
+        var = RTT_GRANULARITY_US;
+    }
+
+    d->rto_us = rtt_clamp(t, d->srtt_us + var);
+    d->backoff = 0;
+    d->samples++;
+}
+
+/*
+ *  Account for a missed response
+ */
+void rtt_timeout(RttTable *t, uint8_t addr)
+{
+    RttDevice *d = &t->dev[addr];
+
+    d->timeouts++;
+
+    if (d->samples == 0 || d->backoff >= RTT_MAX_BACKOFF) {
+        return;
+    }
+
+    d->backoff++;
+    d->rto_us = rtt_clamp(t, d->rto_us * 2);
+}
+
+/* Local functions */
+
+/*
+ *  Limit timeout to floor and ceiling
+ */
+static long rtt_clamp(const RttTable *t, long us)
+{
+    if (us < t->floor_us) {
+        return t->floor_us;
+    }
+    if (us > t->ceiling_us) {
+        return t->ceiling_us;
+    }
+    return us;
+}
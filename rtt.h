@@ -0,0 +1,88 @@
+/*
+ *  Adaptive response timeouts from round-trip statistics
+ *  V1.0/2026-10-16
+ *
+ *  Smoothed round-trip time and its variance per device address, with
+ *  the timeout derived TCP-style (RFC 6298): RTO = SRTT + 4 * RTTVAR,
+ *  clamped to a configured floor and ceiling.
+ */
+#ifndef RTT_H
+#define RTT_H
+
+#include <stdint.h>  /* For uint8_t */
+
+/* Number of device addresses tracked (0 broadcast .. 255) */
+#define RTT_ADDRESSES 256
+
+/* Default floor and ceiling in milliseconds */
+#define RTT_DEFAULT_FLOOR_MS   20
+#define RTT_DEFAULT_CEILING_MS 500
+
+/* Most consecutive timeouts that double the timeout of a device */
+#define RTT_MAX_BACKOFF 2
+
+/**
+ * Round-trip statistics of one device
+ */
+typedef struct {
+    long srtt_us;            /* Smoothed round-trip time, 0 = no sample yet */
+    long rttvar_us;          /* Round-trip time variance */
+    long rto_us;             /* Current timeout */
+    int backoff;             /* Consecutive timeouts since last sample */
+    unsigned long samples;   /* Responses measured */
+    unsigned long timeouts;  /* Responses missed */
+} RttDevice;
+
+/**
+ * Round-trip statistics of all devices on one bus
+ */
+typedef struct {
+    long floor_us;                    /* Lowest timeout */
+    long ceiling_us;                  /* Highest timeout */
+    RttDevice dev[RTT_ADDRESSES];     /* Per address statistics */
+} RttTable;
+
+/**
+ * Initialize table
+ *
+ * @param t          Pointer to table
+ * @param floor_ms   Lowest timeout in milliseconds
+ * @param ceiling_ms Highest timeout in milliseconds
+ */
+extern void rtt_init(RttTable *t, int floor_ms, int ceiling_ms);
+
+/**
+ * Get response timeout for a device
+ *
+ * A device without samples gets the caller's default, limited to the
+ * ceiling, so the first request is never cut short.
+ *
+ * @param t          Pointer to table
+ * @param addr       Device address
+ * @param default_ms Timeout for a device without samples
+ * @return           Timeout in milliseconds
+ */
+extern int rtt_timeout_ms(const RttTable *t, uint8_t addr, int default_ms);
+
+/**
+ * Account for a measured round trip
+ *
+ * @param t      Pointer to table
+ * @param addr   Device address
+ * @param rtt_us Time from request to first response byte
+ */
+extern void rtt_sample(RttTable *t, uint8_t addr, long rtt_us);
+
+/**
+ * Account for a missed response
+ *
+ * Doubles the timeout of a device that has answered before, at most
+ * RTT_MAX_BACKOFF times in a row, so a device that slowed down is heard
+ * again while a dead one keeps costing only a few timeouts' worth.
+ *
+ * @param t    Pointer to table
+ * @param addr Device address
+ */
+extern void rtt_timeout(RttTable *t, uint8_t addr);
+
+#endif /* RTT_H */
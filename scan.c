@@ -1,64 +1,654 @@
 /*
  * RS485 bus scan functions
  * V1.0/2025-01-23
+ * V1.1/2026-10-16 Adaptive probe timeout, parallel ports, range hint, cache
+ * V1.2/2026-10-16 Baud rate detection, result saved for the MQTT daemon
+ * V1.3/2026-10-16 Bus scan over RTU over TCP and Modbus TCP
+ * V1.4/2026-10-16 Cached addresses outside the scanned range kept
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <unistd.h>
+#include <time.h>
+#include <pthread.h>
 
 #include "scan.h"
 #include "typedef.h"
 #include "packet.h"
+#include "serial.h"
+#include "transport.h"
+#include "rtt.h"
 #include "constants.h"
+#include "signal_handler.h"
+
+/* Pseudo address holding the bus-wide round trip (broadcast, never probed) */
+#define SCAN_BUS_RTT 0
+
+/* Longest cache line: port name, baud rate and up to 254 addresses */
+#define SCAN_CACHE_LINE 2048
+
+/* Scan of one port */
+typedef struct {
+    const char *port;                          /* Serial port device */
+    int baudrate;                              /* Baud rate */
+    uint8_t start_addr;                        /* Address range */
+    uint8_t end_addr;
+    uint8_t hint[MAX_DEVICE_ADDRESS + 1];      /* Addresses to probe first */
+    int hint_count;
+    uint8_t found[MAX_DEVICE_ADDRESS + 1];     /* Responding addresses */
+    int found_count;
+    int probes;                                /* Addresses probed */
+    double elapsed;                            /* Scan time [s] */
+    AppStatus status;
+} ScanJob;
+
+/* Baud rate detection on one port */
+typedef struct {
+    const char *port;                          /* Serial port device */
+    uint8_t addr;                              /* Device address */
+    int hint;                                  /* Rate to try first */
+    int baud;                                  /* Detected rate, 0 = none */
+    int tried;                                 /* Rates tried */
+    double elapsed;                            /* Detection time [s] */
+    AppStatus status;
+} BaudJob;
+
+/*
+ *  Local function prototypes
+ */
+static void scan_range(ModbusCtx *ctx, ScanJob *job);
+static void *scan_thread(void *arg);
+static void scan_print(const ScanJob *job, int with_port);
+static void *baud_thread(void *arg);
+static int cache_path(char *buf, size_t size);
+static int baud_path(char *buf, size_t size);
+static void cache_load(ScanJob *job);
+static void cache_store(ScanJob *jobs, int n_jobs);
+static int cmp_addr(const void *a, const void *b);
+
+/**********************************************************************/
+
+/*
+ * Probe one address with a read of register 0x0000
+ */
+int scan_probe(ModbusCtx *ctx, uint8_t addr, int timeout_ms)
+{
+    WireFrame req;
+    PACKET rx_packet;
+    AppStatus status;
+
+    packet_encode_read(&req, addr, 0x03, 0x0000, 1);
+    modbus_ctx_set_timeout(ctx, timeout_ms);
+
+    status = modbus_request(ctx, &req, &rx_packet, 0, "scan", NULL);
+
+    /* An exception is an answer too: the address is in use */
+    return (status == STATUS_OK || status == ERROR_PACKET_EXCEPTION) &&
+           ctx->rx_packet.addr == addr;
+}
 
 /*
  * Scan RS485 bus for Modbus RTU devices
  *
- * Sends a read register 0x0000 request to each address and collects responses.
- * Uses a short timeout (100ms) to keep total scan time reasonable.
+ * Sends a read register 0x0000 request to each address and collects
+ * responses. The timeout starts at SCAN_TIMEOUT_MS and tightens to the
+ * measured round trip after the first answer.
  */
 AppStatus scan_bus(int fd, uint8_t start_addr, uint8_t end_addr)
 {
-    uint8_t found[MAX_DEVICE_ADDRESS + 1];
-    int found_count = 0;
-    uint8_t input_data[4] = {0x00, 0x00, 0x00, 0x01}; /* Read register 0x0000, count 1 */
-    PACKET tx_packet;
-    PACKET rx_packet;
-    AppStatus status;
+    ModbusCtx ctx;
+    ScanJob job;
+
+    memset(&job, 0, sizeof(job));
+    job.start_addr = start_addr;
+    job.end_addr = end_addr;
+
+    modbus_ctx_init_shared(&ctx, fd);
+    scan_range(&ctx, &job);
+    scan_print(&job, 0);
+
+    return STATUS_OK;
+}
+
+/*
+ * Scan several RS485 buses in parallel
+ */
+AppStatus scan_ports(char *const ports[], int n_ports, int baudrate,
+                     uint8_t start_addr, uint8_t end_addr)
+{
+    ScanJob jobs[MAX_PORTS];
+    pthread_t threads[MAX_PORTS];
+    int started[MAX_PORTS];
+    int i, opened = 0;
+
+    if (n_ports < 1 || n_ports > MAX_PORTS) {
+        return ERROR_PORT_INIT;
+    }
+
+    for (i = 0; i < n_ports; i++) {
+        memset(&jobs[i], 0, sizeof(ScanJob));
+        jobs[i].port = ports[i];
+        jobs[i].baudrate = baudrate;
+        jobs[i].start_addr = start_addr;
+        jobs[i].end_addr = end_addr;
+        cache_load(&jobs[i]);
+    }
+
+    /* One port runs in this thread, more ports get a thread each */
+    if (n_ports == 1) {
+        scan_thread(&jobs[0]);
+    } else {
+        for (i = 0; i < n_ports; i++) {
+            started[i] = pthread_create(&threads[i], NULL, scan_thread, &jobs[i]) == 0;
+            if (!started[i]) {
+                scan_thread(&jobs[i]);
+            }
+        }
+        for (i = 0; i < n_ports; i++) {
+            if (started[i]) {
+                pthread_join(threads[i], NULL);
+            }
+        }
+    }
+
+    for (i = 0; i < n_ports; i++) {
+        if (jobs[i].status != STATUS_OK) {
+            fprintf(stderr, "Scan of %s failed: %s\n", jobs[i].port,
+                    get_error_message(jobs[i].status));
+            continue;
+        }
+        opened++;
+        scan_print(&jobs[i], n_ports > 1);
+    }
+
+    cache_store(jobs, n_ports);
+
+    return opened > 0 ? STATUS_OK : ERROR_PORT_INIT;
+}
+
+/*
+ * Find the baud rate a device answers at
+ */
+int scan_detect_baud(int fd, uint8_t addr, int hint, int *tried)
+{
+    static const int rates[] = SCAN_BAUD_RATES;
+    int n_rates = (int)(sizeof(rates) / sizeof(rates[0]));
+    ModbusCtx ctx;
+    int baud, applied, timeout_ms, count = 0;
+
+    for (int i = -1; i < n_rates; i++) {
+        baud = i < 0 ? hint : rates[i];
+        if (baud <= 0 || (i >= 0 && baud == hint)) {
+            continue;
+        }
+        if (set_port(fd, baud) < 0) {
+            continue;
+        }
+        count++;
+
+        applied = serial_get_baud(fd, baud);
+        modbus_ctx_init(&ctx, fd, applied);
+        ctx.quiet = 1;
+
+        /* Request (8 bytes) and response (7 bytes) on the wire come on top */
+        timeout_ms = SCAN_TIMEOUT_MS + (int)(15 * serial_char_time_us(applied) / 1000);
+        if (scan_probe(&ctx, addr, timeout_ms)) {
+            if (tried != NULL) {
+                *tried = count;
+            }
+            return baud;
+        }
+    }
+
+    if (tried != NULL) {
+        *tried = count;
+    }
+    return 0;
+}
+
+/*
+ * Detect the baud rate of a device on several ports in parallel
+ */
+AppStatus scan_baud_ports(char *const ports[], int n_ports, uint8_t addr, int hint)
+{
+    BaudJob jobs[MAX_PORTS];
+    pthread_t threads[MAX_PORTS];
+    int started[MAX_PORTS];
+    int i, opened = 0, found = 0;
+
+    if (n_ports < 1 || n_ports > MAX_PORTS) {
+        return ERROR_PORT_INIT;
+    }
+
+    for (i = 0; i < n_ports; i++) {
+        memset(&jobs[i], 0, sizeof(BaudJob));
+        jobs[i].port = ports[i];
+        jobs[i].addr = addr;
+        jobs[i].hint = scan_baud_load(ports[i], addr);
+        if (jobs[i].hint == 0) {
+            jobs[i].hint = hint;
+        }
+    }
+
+    /* Every port is probed in its own thread, one port in this thread */
+    if (n_ports == 1) {
+        baud_thread(&jobs[0]);
+    } else {
+        for (i = 0; i < n_ports; i++) {
+            started[i] = pthread_create(&threads[i], NULL, baud_thread, &jobs[i]) == 0;
+            if (!started[i]) {
+                baud_thread(&jobs[i]);
+            }
+        }
+        for (i = 0; i < n_ports; i++) {
+            if (started[i]) {
+                pthread_join(threads[i], NULL);
+            }
+        }
+    }
+
+    for (i = 0; i < n_ports; i++) {
+        if (jobs[i].status != STATUS_OK) {
+            fprintf(stderr, "Baud rate detection on %s failed: %s\n", jobs[i].port,
+                    get_error_message(jobs[i].status));
+            continue;
+        }
+        opened++;
+
+        if (n_ports > 1) {
+            printf("%s: ", jobs[i].port);
+        }
+        if (jobs[i].baud > 0) {
+            printf("Address %d answers at %d baud\n", addr, jobs[i].baud);
+            scan_baud_store(jobs[i].port, addr, jobs[i].baud);
+            found++;
+        } else {
+            printf("Address %d does not answer at any rate\n", addr);
+        }
+        printf("# %d rate(s) tried in %.2f s\n", jobs[i].tried, jobs[i].elapsed);
+    }
 
-    /* Scan all addresses in range */
-    for (uint8_t addr = start_addr; addr <= end_addr; addr++) {
-        /* Form read holding registers packet (function 0x03) */
-        form_packet(addr, 0x03, input_data, 4, &tx_packet);
+    if (opened == 0) {
+        return ERROR_PORT_INIT;
+    }
+    return found > 0 ? STATUS_OK : ERROR_RECEIVE_PACKET;
+}
 
-        /* Send packet */
-        status = send_packet(fd, &tx_packet, NULL);
-        if (status != STATUS_OK) {
-            continue; /* Skip to next address on send error */
+/*
+ * Get the saved baud rate of a device
+ *
+ * Line: <port> <addr> <baudrate>
+ */
+int scan_baud_load(const char *port, uint8_t addr)
+{
+    char path[512];
+    char line[512];
+    char name[256];
+    int a, baud, result = 0;
+    FILE *fp;
+
+    if (!baud_path(path, sizeof(path)) || (fp = fopen(path, "r")) == NULL) {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (sscanf(line, "%255s %d %d", name, &a, &baud) == 3 &&
+            strcmp(name, port) == 0 && a == addr &&
+            baud >= SERIAL_BAUD_MIN && baud <= SERIAL_BAUD_MAX) {
+            result = baud;
         }
+    }
+
+    fclose(fp);
+    return result;
+}
+
+/*
+ * Save the baud rate of a device, replacing an older entry
+ */
+void scan_baud_store(const char *port, uint8_t addr, int baud)
+{
+    char path[512], tmp[520];
+    char line[512];
+    char name[256];
+    int a;
+    FILE *in, *out;
+
+    if (!baud_path(path, sizeof(path))) {
+        return;
+    }
 
-        /* Try to receive response with short timeout, quiet mode */
-        status = received_packet_timeout(fd, &rx_packet, RECEIVE_MODE_TEMPERATURE,
-                                         SCAN_TIMEOUT_MS, 1);
-        if (status == STATUS_OK) {
-            /* Device responded - save address */
-            found[found_count++] = addr;
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    out = fopen(tmp, "w");
+    if (out == NULL) {
+        return;
+    }
+
+    in = fopen(path, "r");
+    if (in != NULL) {
+        while (fgets(line, sizeof(line), in) != NULL) {
+            if (sscanf(line, "%255s %d", name, &a) == 2 &&
+                strcmp(name, port) == 0 && a == addr) {
+                continue;
+            }
+            fputs(line, out);
         }
+        fclose(in);
+    }
 
-        /* Small inter-frame delay */
-        usleep(5000);
+    fprintf(out, "%s %d %d\n", port, addr, baud);
+
+    if (fclose(out) == 0) {
+        rename(tmp, path);
+    } else {
+        unlink(tmp);
     }
+}
 
-    /* Print results */
-    if (found_count == 0) {
+/* Local functions */
+
+/*
+ * Probe cached addresses first, then the rest of the range
+ */
+static void scan_range(ModbusCtx *ctx, ScanJob *job)
+{
+    uint8_t probed[MAX_DEVICE_ADDRESS + 1];
+    RttTable bus_rtt;
+    struct timespec t_start, t_end;
+    int addr, i, timeout_ms;
+
+    memset(probed, 0, sizeof(probed));
+    rtt_init(&bus_rtt, SCAN_FLOOR_MS, SCAN_TIMEOUT_MS);
+    ctx->quiet = 1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+
+    /* Pass 0: cached addresses, pass 1: whole range */
+    for (int pass = 0; pass < 2; pass++) {
+        int count = pass == 0 ? job->hint_count : job->end_addr - job->start_addr + 1;
+
+        for (i = 0; i < count && running; i++) {
+            addr = pass == 0 ? job->hint[i] : job->start_addr + i;
+            if (addr < job->start_addr || addr > job->end_addr || probed[addr]) {
+                continue;
+            }
+            probed[addr] = 1;
+            job->probes++;
+
+            timeout_ms = rtt_timeout_ms(&bus_rtt, SCAN_BUS_RTT, SCAN_TIMEOUT_MS);
+            if (scan_probe(ctx, (uint8_t)addr, timeout_ms)) {
+                job->found[job->found_count++] = (uint8_t)addr;
+                rtt_sample(&bus_rtt, SCAN_BUS_RTT, ctx->rx.latency_us);
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    job->elapsed = (double)(t_end.tv_sec - t_start.tv_sec) +
+                   (double)(t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+
+    qsort(job->found, (size_t)job->found_count, 1, cmp_addr);
+}
+
+/*
+ * Open port of a job and scan it
+ */
+static void *scan_thread(void *arg)
+{
+    ScanJob *job = arg;
+    ModbusCtx ctx;
+    int fd;
+
+    fd = transport_open(job->port);
+    if (fd < 0) {
+        job->status = ERROR_PORT_INIT;
+        return NULL;
+    }
+
+    /* No termios on a socket, only the gaps of the line behind it */
+    if (transport_fd_type(fd) != TRANSPORT_SERIAL) {
+        modbus_ctx_init(&ctx, fd, transport_pace_baud(transport_fd_type(fd), job->baudrate));
+    } else if (set_port(fd, job->baudrate) < 0) {
+        transport_close(fd);
+        job->status = ERROR_PORT_INIT;
+        return NULL;
+    } else {
+        modbus_ctx_init(&ctx, fd, serial_get_baud(fd, job->baudrate));
+    }
+    scan_range(&ctx, job);
+    transport_close(fd);
+
+    job->status = STATUS_OK;
+    return NULL;
+}
+
+/*
+ * Open port of a baud job and try the rates
+ */
+static void *baud_thread(void *arg)
+{
+    BaudJob *job = arg;
+    struct timespec t_start, t_end;
+    int fd;
+
+    if (transport_type(job->port) != TRANSPORT_SERIAL) {
+        fprintf(stderr, "%s: baud rate detection needs a serial port\n", job->port);
+        job->status = ERROR_INVALID_PORT;
+        return NULL;
+    }
+
+    fd = open_port(job->port);
+    if (fd < 0) {
+        job->status = ERROR_PORT_INIT;
+        return NULL;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t_start);
+    job->baud = scan_detect_baud(fd, job->addr, job->hint, &job->tried);
+    clock_gettime(CLOCK_MONOTONIC, &t_end);
+    close(fd);
+
+    job->elapsed = (double)(t_end.tv_sec - t_start.tv_sec) +
+                   (double)(t_end.tv_nsec - t_start.tv_nsec) / 1e9;
+    job->status = STATUS_OK;
+    return NULL;
+}
+
+/*
+ * Print result of one scan
+ */
+static void scan_print(const ScanJob *job, int with_port)
+{
+    if (with_port) {
+        printf("%s: ", job->port);
+    }
+
+    if (job->found_count == 0) {
         printf("No devices found.\n");
     } else {
-        printf("Found %d device(s):\n", found_count);
-        for (int i = 0; i < found_count; i++) {
-            printf("  %d\n", found[i]);
+        printf("Found %d device(s):\n", job->found_count);
+        for (int i = 0; i < job->found_count; i++) {
+            printf("  %d\n", job->found[i]);
         }
     }
+    printf("# %d address(es) scanned in %.2f s\n", job->probes, job->elapsed);
+}
 
-    return STATUS_OK;
+/*
+ * Get cache file path, 0 if caching is disabled
+ */
+static int cache_path(char *buf, size_t size)
+{
+    const char *env = getenv(SCAN_CACHE_ENV);
+    const char *home;
+
+    if (env != NULL) {
+        if (env[0] == '\0') {
+            return 0;  /* Set but empty: no cache */
+        }
+        snprintf(buf, size, "%s", env);
+        return 1;
+    }
+
+    home = getenv("HOME");
+    if (home == NULL || home[0] == '\0') {
+        return 0;
+    }
+    snprintf(buf, size, "%s/%s", home, SCAN_CACHE_NAME);
+    return 1;
+}
+
+/*
+ * Get path of the saved baud rates, 0 if saving is disabled
+ */
+static int baud_path(char *buf, size_t size)
+{
+    const char *env = getenv(SCAN_BAUD_ENV);
+    const char *home;
+
+    if (env != NULL) {
+        if (env[0] == '\0') {
+            return 0;  /* Set but empty: nothing saved */
+        }
+        snprintf(buf, size, "%s", env);
+        return 1;
+    }
+
+    home = getenv("HOME");
+    if (home == NULL || home[0] == '\0') {
+        return 0;
+    }
+    snprintf(buf, size, "%s/%s", home, SCAN_BAUD_NAME);
+    return 1;
+}
+
+/*
+ * Read addresses found by the last scan of the job's port
+ *
+ * Cache line: <port> <baudrate> <addr> <addr> ...
+ */
+static void cache_load(ScanJob *job)
+{
+    char path[512];
+    char line[SCAN_CACHE_LINE];
+    char port[256];
+    uint8_t seen[MAX_DEVICE_ADDRESS + 1];
+    int baud, pos, addr, n;
+    FILE *fp;
+
+    if (!cache_path(path, sizeof(path)) || (fp = fopen(path, "r")) == NULL) {
+        return;
+    }
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (sscanf(line, "%255s %d%n", port, &baud, &pos) != 2 ||
+            strcmp(port, job->port) != 0 || baud != job->baudrate) {
+            continue;
+        }
+        job->hint_count = 0;
+        memset(seen, 0, sizeof(seen));
+        /* A hand-edited line may repeat addresses, keep each one once */
+        while (job->hint_count < (int)(sizeof(job->hint) / sizeof(job->hint[0])) &&
+               sscanf(line + pos, "%d%n", &addr, &n) == 1) {
+            pos += n;
+            if (addr >= MIN_DEVICE_ADDRESS && addr <= MAX_DEVICE_ADDRESS && !seen[addr]) {
+                seen[addr] = 1;
+                job->hint[job->hint_count++] = (uint8_t)addr;
+            }
+        }
+    }
+
+    fclose(fp);
+}
+
+/*
+ * Store scan results, keeping lines of other ports and baud rates
+ *
+ * The line of a scanned port is merged: addresses outside the scanned
+ * range stay, inside it only the ones that answered.
+ */
+static void cache_store(ScanJob *jobs, int n_jobs)
+{
+    char path[512], tmp[520];
+    char line[SCAN_CACHE_LINE];
+    char port[256];
+    uint8_t merged[MAX_PORTS][MAX_DEVICE_ADDRESS + 1];
+    int baud, start, pos, addr, n, i, j, keep;
+    FILE *in, *out;
+
+    if (!cache_path(path, sizeof(path))) {
+        return;
+    }
+
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    out = fopen(tmp, "w");
+    if (out == NULL) {
+        return;
+    }
+
+    memset(merged, 0, sizeof(merged));
+    for (i = 0; i < n_jobs && i < MAX_PORTS; i++) {
+        for (j = 0; j < jobs[i].found_count; j++) {
+            merged[i][jobs[i].found[j]] = 1;
+        }
+    }
+
+    in = fopen(path, "r");
+    if (in != NULL) {
+        while (fgets(line, sizeof(line), in) != NULL) {
+            keep = 1;
+            if (sscanf(line, "%255s %d%n", port, &baud, &start) == 2) {
+                for (i = 0; i < n_jobs && i < MAX_PORTS; i++) {
+                    if (jobs[i].status != STATUS_OK ||
+                        strcmp(port, jobs[i].port) != 0 || baud != jobs[i].baudrate) {
+                        continue;
+                    }
+                    keep = 0;
+                    /* Not probed this time, still a hint */
+                    pos = start;
+                    while (sscanf(line + pos, "%d%n", &addr, &n) == 1) {
+                        pos += n;
+                        if (addr >= MIN_DEVICE_ADDRESS && addr <= MAX_DEVICE_ADDRESS &&
+                            (addr < jobs[i].start_addr || addr > jobs[i].end_addr)) {
+                            merged[i][addr] = 1;
+                        }
+                    }
+                }
+            }
+            if (keep) {
+                fputs(line, out);
+            }
+        }
+        fclose(in);
+    }
+
+    for (i = 0; i < n_jobs && i < MAX_PORTS; i++) {
+        if (jobs[i].status != STATUS_OK) {
+            continue;
+        }
+        fprintf(out, "%s %d", jobs[i].port, jobs[i].baudrate);
+        for (addr = MIN_DEVICE_ADDRESS; addr <= MAX_DEVICE_ADDRESS; addr++) {
+            if (merged[i][addr]) {
+                fprintf(out, " %d", addr);
+            }
+        }
+        fprintf(out, "\n");
+    }
+
+    if (fclose(out) == 0) {
+        rename(tmp, path);
+    } else {
+        unlink(tmp);
+    }
+}
+
+/*
+ * Compare addresses for qsort
+ */
+static int cmp_addr(const void *a, const void *b)
+{
+    return *(const uint8_t *)a - *(const uint8_t *)b;
 }
@@ -1,16 +1,43 @@
 /*
  * RS485 bus scan functions
  * V1.0/2025-01-23
+ * V1.1/2026-10-16 Adaptive probe timeout, parallel ports, range hint, cache
+ * V1.2/2026-10-16 Baud rate detection
  */
 #ifndef SCAN_H
 #define SCAN_H
 
 #include <stdint.h>
 #include "error.h"
+#include "modbus_ctx.h"
 
-/* Scan timeout in milliseconds */
+/* Scan timeout in milliseconds (until the bus has answered a probe) */
 #define SCAN_TIMEOUT_MS 100
 
+/* Lowest probe timeout once the bus round trip is known */
+#define SCAN_FLOOR_MS 10
+
+/* Cache of the last scan result: $R4DCB08_SCAN_CACHE or $HOME/.r4dcb08-scan */
+#define SCAN_CACHE_ENV  "R4DCB08_SCAN_CACHE"
+#define SCAN_CACHE_NAME ".r4dcb08-scan"
+
+/* Detected baud rates: $R4DCB08_BAUD_CACHE or $HOME/.r4dcb08-baud */
+#define SCAN_BAUD_ENV  "R4DCB08_BAUD_CACHE"
+#define SCAN_BAUD_NAME ".r4dcb08-baud"
+
+/* Device baud rates in order of likelihood (factory default first) */
+#define SCAN_BAUD_RATES { 9600, 19200, 4800, 2400, 1200 }
+
+/**
+ * Probe one address with a read of register 0x0000
+ *
+ * @param ctx        Modbus context of the port
+ * @param addr       Device address
+ * @param timeout_ms Response timeout
+ * @return           1 if a device answered (also with an exception), 0 otherwise
+ */
+int scan_probe(ModbusCtx *ctx, uint8_t addr, int timeout_ms);
+
 /**
  * Scan RS485 bus for Modbus RTU devices
  *
@@ -21,4 +48,72 @@
  */
 AppStatus scan_bus(int fd, uint8_t start_addr, uint8_t end_addr);
 
+/**
+ * Scan several RS485 buses in parallel (one thread per port)
+ *
+ * Addresses found by the previous scan of a port at the same baud rate
+ * (cache file) are probed first; the probe timeout tightens to the
+ * measured bus round trip once a device has answered. The result is
+ * printed per port and stored in the cache.
+ *
+ * @param ports      Serial port devices
+ * @param n_ports    Number of ports (1..MAX_PORTS)
+ * @param baudrate   Baud rate of all ports
+ * @param start_addr Starting address for scan
+ * @param end_addr   Ending address for scan
+ * @return           STATUS_OK on success, ERROR_PORT_INIT if no port could be opened
+ */
+AppStatus scan_ports(char *const ports[], int n_ports, int baudrate,
+                     uint8_t start_addr, uint8_t end_addr);
+
+/**
+ * Find the baud rate a device answers at
+ *
+ * Sets the port to each candidate rate in turn and probes the address
+ * once; the first response with a valid CRC (also an exception) wins.
+ * The hint (e.g. the saved rate) is tried first, then SCAN_BAUD_RATES.
+ * The port is left at the detected rate.
+ *
+ * @param fd    File descriptor of the serial port
+ * @param addr  Device address
+ * @param hint  Rate to try first, 0 = none
+ * @param tried Pointer to store the number of rates tried (optional)
+ * @return      Detected baud rate, 0 if the device answered at no rate
+ */
+int scan_detect_baud(int fd, uint8_t addr, int hint, int *tried);
+
+/**
+ * Detect the baud rate of a device on several ports in parallel
+ *
+ * One thread per port; the saved rate of a port is tried first. The
+ * result is printed per port and saved for the MQTT daemon.
+ *
+ * @param ports   Serial port devices
+ * @param n_ports Number of ports (1..MAX_PORTS)
+ * @param addr    Device address
+ * @param hint    Rate to try first if none is saved, 0 = none
+ * @return        STATUS_OK if the device answered on any port,
+ *                ERROR_PORT_INIT if no port could be opened,
+ *                ERROR_RECEIVE_PACKET if it answered nowhere
+ */
+AppStatus scan_baud_ports(char *const ports[], int n_ports, uint8_t addr, int hint);
+
+/**
+ * Get the saved baud rate of a device
+ *
+ * @param port Serial port device
+ * @param addr Device address
+ * @return     Saved baud rate, 0 if none
+ */
+int scan_baud_load(const char *port, uint8_t addr);
+
+/**
+ * Save the baud rate of a device, replacing an older entry
+ *
+ * @param port Serial port device
+ * @param addr Device address
+ * @param baud Detected baud rate
+ */
+void scan_baud_store(const char *port, uint8_t addr, int baud);
+
 #endif /* SCAN_H */
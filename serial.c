@@ -5,6 +5,10 @@
  *  V1.2/250308 Optimized version (AI)
  *  V1.3/250313 Updated to return error codes instead of exiting
  *  V1.4/250829 Add iserial lock (flock())
+ *  V1.5/261016 Add Modbus RTU character and frame gap timing
+ *  V1.6/261016 Arbitrary baud rates via termios2/BOTHER, applied rate read back
+ *  V1.7/261016 Low-latency RS485 profile (TIOCSRS485, ASYNC_LOW_LATENCY, latency_timer)
+ *  V1.8/261016 Settings changed by the profile restored by serial_close()
  */
 #include <stdio.h>   /* Standard input/output definitions */
 #include <stdlib.h>  /* Standard lib */
@@ -14,38 +18,101 @@
 #include <errno.h>   /* Error number definitions */
 #include <termios.h> /* POSIX terminal control definitions */
 #include <sys/file.h> /* File locking definitions */
+#include <sys/ioctl.h> /* ioctl, TCGETS2/TCSETS2 on Linux */
+#include <libgen.h>   /* basename */
+#include <limits.h>   /* PATH_MAX */
+#include <pthread.h>  /* pthread_mutex */
+#ifdef __linux__
+#include <linux/serial.h> /* serial_rs485, serial_struct, ASYNC_LOW_LATENCY */
+#endif
 
 #include "serial.h"
 
+/* Bits per RTU character: start + 8 data + parity/stop + stop */
+#define RTU_CHAR_BITS 11
+
 /*
- *  Converts numeric baud rate to system constant
- *  Returns speed_t value or B0 for unsupported baud rates
+ *  Linux termios2 with separate input/output speed fields. <asm/termbits.h>
+ *  clashes with <termios.h>, so the (asm-generic) layout is declared here.
  */
-static speed_t get_baud(int baud)
-{
-    static const struct {
-        int rate;
-        speed_t speed;
-    } baud_table[] = {
-        { 1200, B1200 },
-        { 2400, B2400 },
-        { 4800, B4800 },
-        { 9600, B9600 },
-        { 19200, B19200 },
-        { 38400, B38400 },
-        { 57600, B57600 },
-        { 115200, B115200 },
-        { 0, 0 }
-    };
+#if defined(__linux__) && defined(TCGETS2)
+#define SERIAL_TERMIOS2 1
+#define SERIAL_NCCS2    19
+#ifndef BOTHER
+#define BOTHER 0010000  /* Speed in c_ispeed/c_ospeed */
+#endif
+struct termios2 {
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_line;
+    cc_t c_cc[SERIAL_NCCS2];
+    speed_t c_ispeed;
+    speed_t c_ospeed;
+};
+#endif
 
-    for (int i = 0; baud_table[i].rate != 0; i++) {
-        if (baud_table[i].rate == baud)
-            return baud_table[i].speed;
-    }
+/* Most ports tuned at once, more are tuned but not restored */
+#define SERIAL_TUNED_MAX 16
 
-    fprintf(stderr, "Incorrect baud rate %d!\n", baud);
-    return B0;  /* 0 baud rate signifies error */
-}
+/*
+ *  What the low-latency profile changed on a port, to undo on close
+ */
+typedef struct {
+    int used;                          /* Entry in use */
+    int fd;                            /* Tuned port */
+    int rs485_saved;                   /* rs485 holds the mode before */
+#if defined(__linux__) && defined(TIOCSRS485)
+    struct serial_rs485 rs485;         /* RS485 mode before */
+#endif
+    int low_latency_set;               /* ASYNC_LOW_LATENCY was off before */
+    int latency_timer_old;             /* Timer to write back [ms], -1 = unchanged */
+    char tty[64];                      /* Name in /sys/class/tty of the timer */
+} TunedPort;
+
+static TunedPort tuned[SERIAL_TUNED_MAX];
+static pthread_mutex_t tuned_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Standard baud rates and their system constants */
+static const struct {
+    int rate;
+    speed_t speed;
+} baud_table[] = {
+    { 1200, B1200 },
+    { 2400, B2400 },
+    { 4800, B4800 },
+    { 9600, B9600 },
+    { 19200, B19200 },
+    { 38400, B38400 },
+    { 57600, B57600 },
+    { 115200, B115200 },
+#ifdef B230400
+    { 230400, B230400 },
+#endif
+#ifdef B460800
+    { 460800, B460800 },
+#endif
+#ifdef B921600
+    { 921600, B921600 },
+#endif
+    { 0, 0 }
+};
+
+/*
+ *  Local function prototypes
+ */
+static speed_t get_baud(int baud);
+static int set_custom_baud(int fd, int baud);
+static int tune_rs485(int fd, TunedPort *saved);
+static int tune_low_latency(int fd, TunedPort *saved);
+static int tune_latency_timer(const char *device, int *old_ms, int *new_ms,
+                              TunedPort *saved);
+static int write_latency_timer(const char *path, int ms);
+static void restore_tuning(const TunedPort *t);
+static int errno_result(int err);
+
+/**********************************************************************/
 
 /*
  *  Opens the serial port
@@ -101,17 +168,29 @@ int set_port(int fd, int baud)
 {
     struct termios options;  /* Terminal configuration struct */
     speed_t baud_rate;
+    int custom = 0;          /* Rate without Bxxx constant */
     
     /* Validate file descriptor */
     if (fd < 0) {
         fprintf(stderr, "set_port: Invalid file descriptor\n");
         return SERIAL_ERROR_ATTR;
     }
+
+    if (baud < SERIAL_BAUD_MIN || baud > SERIAL_BAUD_MAX) {
+        fprintf(stderr, "Incorrect baud rate %d!\n", baud);
+        return SERIAL_ERROR_BAUD;
+    }
     
-    /* Get baud rate constant */
+    /* Get baud rate constant, other rates are set with termios2 below */
     baud_rate = get_baud(baud);
     if (baud_rate == B0) {
+#ifdef SERIAL_TERMIOS2
+        baud_rate = B9600;
+        custom = 1;
+#else
+        fprintf(stderr, "Incorrect baud rate %d!\n", baud);
         return SERIAL_ERROR_BAUD;
+#endif
     }
 
     /* Get current port settings */
@@ -143,6 +222,412 @@ int set_port(int fd, int baud)
         return SERIAL_ERROR_CONFIG;
     }
 
+    if (custom && set_custom_baud(fd, baud) != 0) {
+        return SERIAL_ERROR_BAUD;
+    }
+
 //    fprintf(stderr, "Serial port configured at %d baud\n", baud);
     return SERIAL_SUCCESS;
 }
+
+/*
+ *  Reads back the baud rate the driver actually applied
+ */
+int serial_get_baud(int fd, int fallback)
+{
+    struct termios options;
+    speed_t speed;
+
+#ifdef SERIAL_TERMIOS2
+    struct termios2 tio2;
+
+    /* The kernel stores the effective rate in c_ospeed for every speed */
+    if (ioctl(fd, TCGETS2, &tio2) == 0 && tio2.c_ospeed > 0) {
+        return (int)tio2.c_ospeed;
+    }
+#endif
+
+    if (tcgetattr(fd, &options) == -1) {
+        return fallback;
+    }
+    speed = cfgetospeed(&options);
+    for (int i = 0; baud_table[i].rate != 0; i++) {
+        if (baud_table[i].speed == speed)
+            return baud_table[i].rate;
+    }
+
+    return fallback;
+}
+
+/*
+ *  Applies the opt-in low-latency RS485 profile
+ */
+int serial_tune_low_latency(int fd, const char *device, SerialTuning *result)
+{
+    TunedPort saved;
+    int k;
+
+    memset(&saved, 0, sizeof(saved));
+    saved.used = 1;
+    saved.fd = fd;
+    saved.latency_timer_old = -1;
+
+    result->rs485 = tune_rs485(fd, &saved);
+    result->low_latency = tune_low_latency(fd, &saved);
+    result->latency_timer = tune_latency_timer(device, &result->latency_timer_old,
+                                               &result->latency_timer_ms, &saved);
+
+    /* Remember what to undo, a port tuned twice keeps the first state */
+    if (saved.rs485_saved || saved.low_latency_set || saved.latency_timer_old >= 0) {
+        pthread_mutex_lock(&tuned_lock);
+        for (k = 0; k < SERIAL_TUNED_MAX && !(tuned[k].used && tuned[k].fd == fd); k++) {
+        }
+        if (k == SERIAL_TUNED_MAX) {
+            for (k = 0; k < SERIAL_TUNED_MAX && tuned[k].used; k++) {
+            }
+            if (k < SERIAL_TUNED_MAX) {
+                tuned[k] = saved;
+            } else {
+                fprintf(stderr, "serial: %s: too many tuned ports, settings stay after close\n",
+                        device);
+            }
+        }
+        pthread_mutex_unlock(&tuned_lock);
+    }
+
+    return (result->rs485 == SERIAL_TUNE_OK) +
+           (result->low_latency == SERIAL_TUNE_OK) +
+           (result->latency_timer == SERIAL_TUNE_OK);
+}
+
+/*
+ *  Undo the low-latency profile of a port and close it
+ */
+void serial_close(int fd)
+{
+    if (fd < 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&tuned_lock);
+    for (int k = 0; k < SERIAL_TUNED_MAX; k++) {
+        if (tuned[k].used && tuned[k].fd == fd) {
+            restore_tuning(&tuned[k]);
+            tuned[k].used = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&tuned_lock);
+
+    close(fd);
+}
+
+/*
+ *  Text for a SERIAL_TUNE_* result
+ */
+const char *serial_tune_text(int result)
+{
+    switch (result) {
+        case SERIAL_TUNE_OK:
+            return "accepted";
+        case SERIAL_TUNE_UNSUPPORTED:
+            return "not supported by driver";
+        case SERIAL_TUNE_DENIED:
+            return "permission denied";
+        default:
+            return "rejected by driver";
+    }
+}
+
+/*
+ *  Print what the driver accepted of the low-latency profile
+ */
+void serial_tune_print(FILE *fp, const char *device, const SerialTuning *t)
+{
+    fprintf(fp, "# Low-latency RS485 profile on %s\n", device);
+    fprintf(fp, "#   RS485 mode (RTS on send):  %s\n", serial_tune_text(t->rs485));
+    fprintf(fp, "#   ASYNC_LOW_LATENCY:         %s\n", serial_tune_text(t->low_latency));
+    if (t->latency_timer_old >= 0) {
+        fprintf(fp, "#   USB latency timer:         %s (%d ms -> %d ms)\n",
+                serial_tune_text(t->latency_timer), t->latency_timer_old,
+                t->latency_timer_ms);
+    } else {
+        fprintf(fp, "#   USB latency timer:         %s\n", serial_tune_text(t->latency_timer));
+    }
+}
+
+/*
+ *  Delay added by the host between bytes of one frame
+ */
+long serial_host_latency_us(const SerialTuning *t)
+{
+    if (t == NULL) {
+        return 0;
+    }
+    if (t->latency_timer_ms >= 0) {
+        /* USB adapter flushes its buffer after latency_timer ms of silence */
+        return t->latency_timer_ms * 1000L + 1000L;
+    }
+    if (t->low_latency == SERIAL_TUNE_OK) {
+        return 2000L;  /* Native UART, bytes pushed without scheduler delay */
+    }
+    return 0;
+}
+
+/*
+ *  Time to transmit one RTU character in microseconds
+ */
+long serial_char_time_us(int baud)
+{
+    if (baud <= 0) {
+        return 0;
+    }
+    return (RTU_CHAR_BITS * 1000000L + baud - 1) / baud;
+}
+
+/*
+ *  Modbus RTU inter-frame silence t3.5 in microseconds
+ */
+long serial_frame_gap_us(int baud)
+{
+    if (baud <= 0) {
+        return 0;
+    }
+    if (baud > SERIAL_GAP_FIXED_BAUD) {
+        return SERIAL_GAP_FIXED_US;
+    }
+    return (35 * RTU_CHAR_BITS * 1000000L / baud + 9) / 10;
+}
+
+/* Local functions */
+
+/*
+ *  Converts numeric baud rate to system constant
+ *  Returns speed_t value or B0 for rates without a constant
+ */
+static speed_t get_baud(int baud)
+{
+    for (int i = 0; baud_table[i].rate != 0; i++) {
+        if (baud_table[i].rate == baud)
+            return baud_table[i].speed;
+    }
+
+    return B0;
+}
+
+/*
+ *  Sets a rate without Bxxx constant through termios2/BOTHER
+ *  Returns 0 on success, -1 on failure
+ */
+static int set_custom_baud(int fd, int baud)
+{
+#ifdef SERIAL_TERMIOS2
+    struct termios2 tio2;
+
+    if (ioctl(fd, TCGETS2, &tio2) == -1) {
+        fprintf(stderr, "set_port: TCGETS2 failed - %s\n", strerror(errno));
+        return -1;
+    }
+
+    tio2.c_cflag &= ~(tcflag_t)CBAUD;
+    tio2.c_cflag |= BOTHER;
+    tio2.c_ispeed = (speed_t)baud;
+    tio2.c_ospeed = (speed_t)baud;
+
+    if (ioctl(fd, TCSETS2, &tio2) == -1) {
+        fprintf(stderr, "set_port: baud rate %d not supported - %s\n",
+                baud, strerror(errno));
+        return -1;
+    }
+    return 0;
+#else
+    (void)fd;
+    fprintf(stderr, "Incorrect baud rate %d!\n", baud);
+    return -1;
+#endif
+}
+
+/*
+ *  Kernel RS485 mode: RTS high while sending, no turnaround delays
+ */
+static int tune_rs485(int fd, TunedPort *saved)
+{
+#if defined(__linux__) && defined(TIOCSRS485)
+    struct serial_rs485 rs485;
+
+    memset(&rs485, 0, sizeof(rs485));
+    if (ioctl(fd, TIOCGRS485, &rs485) == -1) {
+        return errno_result(errno);
+    }
+    saved->rs485 = rs485;
+
+    rs485.flags |= SER_RS485_ENABLED | SER_RS485_RTS_ON_SEND;
+    rs485.flags &= ~(__u32)(SER_RS485_RTS_AFTER_SEND | SER_RS485_RX_DURING_TX);
+    rs485.delay_rts_before_send = 0;
+    rs485.delay_rts_after_send = 0;
+
+    if (ioctl(fd, TIOCSRS485, &rs485) == -1) {
+        return errno_result(errno);
+    }
+    saved->rs485_saved = 1;
+
+    /* The driver may silently drop flags it cannot do */
+    if (ioctl(fd, TIOCGRS485, &rs485) == 0 && !(rs485.flags & SER_RS485_ENABLED)) {
+        return SERIAL_TUNE_UNSUPPORTED;
+    }
+    return SERIAL_TUNE_OK;
+#else
+    (void)fd;
+    (void)saved;
+    return SERIAL_TUNE_UNSUPPORTED;
+#endif
+}
+
+/*
+ *  ASYNC_LOW_LATENCY: push received bytes to the reader without delay
+ */
+static int tune_low_latency(int fd, TunedPort *saved)
+{
+#if defined(__linux__) && defined(TIOCGSERIAL)
+    struct serial_struct ss;
+
+    if (ioctl(fd, TIOCGSERIAL, &ss) == -1) {
+        return errno_result(errno);
+    }
+    if (ss.flags & ASYNC_LOW_LATENCY) {
+        return SERIAL_TUNE_OK;
+    }
+
+    ss.flags |= ASYNC_LOW_LATENCY;
+    if (ioctl(fd, TIOCSSERIAL, &ss) == -1) {
+        return errno_result(errno);
+    }
+    saved->low_latency_set = 1;
+    return SERIAL_TUNE_OK;
+#else
+    (void)fd;
+    (void)saved;
+    return SERIAL_TUNE_UNSUPPORTED;
+#endif
+}
+
+/*
+ *  USB-serial latency timer (/sys/class/tty/<tty>/device/latency_timer)
+ */
+static int tune_latency_timer(const char *device, int *old_ms, int *new_ms,
+                              TunedPort *saved)
+{
+    char real[PATH_MAX];
+    char path[PATH_MAX + 64];
+    FILE *fp;
+    int ms;
+
+    *old_ms = -1;
+    *new_ms = -1;
+
+    if (device == NULL || realpath(device, real) == NULL) {
+        return SERIAL_TUNE_UNSUPPORTED;
+    }
+    snprintf(path, sizeof(path), "/sys/class/tty/%s/device/latency_timer", basename(real));
+
+    fp = fopen(path, "r");
+    if (fp == NULL) {
+        return SERIAL_TUNE_UNSUPPORTED;  /* Not an FTDI-style adapter */
+    }
+    if (fscanf(fp, "%d", &ms) != 1) {
+        fclose(fp);
+        return SERIAL_TUNE_UNSUPPORTED;
+    }
+    fclose(fp);
+    *old_ms = ms;
+    *new_ms = ms;
+
+    if (ms <= SERIAL_LATENCY_TIMER_MS) {
+        return SERIAL_TUNE_OK;
+    }
+
+    if (write_latency_timer(path, SERIAL_LATENCY_TIMER_MS) != 0) {
+        return errno_result(errno);
+    }
+    if (strlen(basename(real)) < sizeof(saved->tty)) {
+        strcpy(saved->tty, basename(real));
+        saved->latency_timer_old = *old_ms;
+    }
+
+    /* Read back what the driver applied */
+    fp = fopen(path, "r");
+    if (fp != NULL) {
+        if (fscanf(fp, "%d", &ms) == 1) {
+            *new_ms = ms;
+        }
+        fclose(fp);
+    }
+
+    return *new_ms <= SERIAL_LATENCY_TIMER_MS ? SERIAL_TUNE_OK : SERIAL_TUNE_FAILED;
+}
+
+/*
+ *  Write the USB-serial latency timer, 0 on success, -1 with errno set
+ */
+static int write_latency_timer(const char *path, int ms)
+{
+    FILE *fp = fopen(path, "w");
+
+    if (fp == NULL) {
+        return -1;
+    }
+    fprintf(fp, "%d\n", ms);
+    return fclose(fp) != 0 ? -1 : 0;
+}
+
+/*
+ *  Put back what the low-latency profile changed on a port
+ */
+static void restore_tuning(const TunedPort *t)
+{
+    char path[128];
+
+    if (t->latency_timer_old >= 0) {
+        snprintf(path, sizeof(path), "/sys/class/tty/%s/device/latency_timer", t->tty);
+        if (write_latency_timer(path, t->latency_timer_old) != 0) {
+            fprintf(stderr, "serial: restoring %s: %s\n", path, strerror(errno));
+        }
+    }
+
+#if defined(__linux__) && defined(TIOCGSERIAL)
+    if (t->low_latency_set) {
+        struct serial_struct ss;
+
+        if (ioctl(t->fd, TIOCGSERIAL, &ss) == 0) {
+            ss.flags &= ~ASYNC_LOW_LATENCY;
+            ioctl(t->fd, TIOCSSERIAL, &ss);
+        }
+    }
+#endif
+
+#if defined(__linux__) && defined(TIOCSRS485)
+    if (t->rs485_saved) {
+        struct serial_rs485 rs485 = t->rs485;
+
+        ioctl(t->fd, TIOCSRS485, &rs485);
+    }
+#endif
+}
+
+/*
+ *  Map errno of a failed setting to a SERIAL_TUNE_* result
+ */
+static int errno_result(int err)
+{
+    switch (err) {
+        case ENOTTY:
+        case EINVAL:
+        case EOPNOTSUPP:
+            return SERIAL_TUNE_UNSUPPORTED;
+        case EPERM:
+        case EACCES:
+            return SERIAL_TUNE_DENIED;
+        default:
+            return SERIAL_TUNE_FAILED;
+    }
+}
@@ -4,11 +4,17 @@
  *  V1.1/250109 Add baud rate selection
  *  V1.2/250313 Updated API with error codes
  *  V1.3/250829 Add iserial lock (flock())
+ *  V1.4/261016 Add Modbus RTU character and frame gap timing
+ *  V1.5/261016 Arbitrary baud rates (termios2/BOTHER), applied rate read back
+ *  V1.6/261016 Low-latency RS485 profile
+ *  V1.7/261016 serial_close() undoes the low-latency profile
  */
 
 #ifndef SERIAL_H
 #define SERIAL_H
 
+#include <stdio.h>  /* For FILE */
+
 /* Error codes for serial port operations */
 #define SERIAL_SUCCESS       0
 #define SERIAL_ERROR_OPEN   -1
@@ -27,14 +33,118 @@
  */
 extern int open_port(const char *device);
 
+/* Lowest and highest baud rate accepted by set_port() */
+#define SERIAL_BAUD_MIN 50
+#define SERIAL_BAUD_MAX 4000000
+
 /**
  * Configures the serial port with the specified baud rate and settings.
  * Uses blocking mode with 1.5 second timeout.
+ * Rates without a Bxxx constant are set through termios2/BOTHER (Linux);
+ * the driver may round them, see serial_get_baud().
  *
  * @param fd File descriptor for the serial port
- * @param baud Baud rate (2400, 4800, 9600, 19200, 38400, 57600, 115200)
+ * @param baud Baud rate (SERIAL_BAUD_MIN..SERIAL_BAUD_MAX)
  * @return 0 on success, negative error code on failure
  */
 extern int set_port(int fd, int baud);
 
+/**
+ * Reads back the baud rate the driver actually applied.
+ *
+ * @param fd File descriptor for the serial port
+ * @param fallback Value returned if the rate cannot be read
+ * @return Output baud rate of the port
+ */
+extern int serial_get_baud(int fd, int fallback);
+
+/* Result of one setting of the low-latency profile */
+#define SERIAL_TUNE_OK           0   /* Accepted by the driver */
+#define SERIAL_TUNE_UNSUPPORTED -1   /* Driver or adapter has no such setting */
+#define SERIAL_TUNE_DENIED      -2   /* Setting exists, no permission */
+#define SERIAL_TUNE_FAILED      -3   /* Driver rejected the value */
+
+/* FTDI latency timer set by the low-latency profile [ms] */
+#define SERIAL_LATENCY_TIMER_MS 1
+
+/**
+ * What the driver accepted of the low-latency RS485 profile
+ */
+typedef struct {
+    int rs485;             /* Kernel RS485 mode (TIOCSRS485) */
+    int low_latency;       /* ASYNC_LOW_LATENCY (TIOCSSERIAL) */
+    int latency_timer;     /* USB-serial latency_timer in sysfs */
+    int latency_timer_old; /* Latency timer before [ms], -1 = none */
+    int latency_timer_ms;  /* Latency timer now [ms], -1 = none */
+} SerialTuning;
+
+/**
+ * Applies the opt-in low-latency RS485 profile
+ *
+ * Kernel RS485 mode with RTS direction control and zero turnaround
+ * delays, ASYNC_LOW_LATENCY, and the USB-serial (FTDI) latency timer
+ * lowered from 16 ms to SERIAL_LATENCY_TIMER_MS. Settings the driver
+ * does not support are skipped; the result says what was accepted.
+ * Everything changed is put back by serial_close(); the latency timer is
+ * a setting of the adapter and stays lowered if the process is killed.
+ *
+ * @param fd File descriptor for the serial port
+ * @param device Path to the serial device (for the sysfs latency timer)
+ * @param result What the driver accepted
+ * @return Number of settings accepted
+ */
+extern int serial_tune_low_latency(int fd, const char *device, SerialTuning *result);
+
+/**
+ * Closes a serial port, undoing serial_tune_low_latency() first
+ *
+ * @param fd File descriptor for the serial port
+ */
+extern void serial_close(int fd);
+
+/**
+ * Text for a SERIAL_TUNE_* result
+ *
+ * @param result Result code
+ * @return Static string
+ */
+extern const char *serial_tune_text(int result);
+
+/**
+ * Print what the driver accepted of the low-latency profile
+ *
+ * @param fp Output stream
+ * @param device Path to the serial device
+ * @param t Result of serial_tune_low_latency()
+ */
+extern void serial_tune_print(FILE *fp, const char *device, const SerialTuning *t);
+
+/**
+ * Delay added by the host between bytes of one frame
+ *
+ * @param t Result of serial_tune_low_latency(), NULL = untuned
+ * @return Microseconds to allow for USB bursts, 0 = keep the default
+ */
+extern long serial_host_latency_us(const SerialTuning *t);
+
+/* Modbus RTU: t3.5 is fixed to 1750 us above 19200 baud */
+#define SERIAL_GAP_FIXED_BAUD 19200
+#define SERIAL_GAP_FIXED_US   1750
+
+/**
+ * Time to transmit one RTU character (start + 8 data + parity/stop + stop).
+ *
+ * @param baud Baud rate
+ * @return Character time in microseconds, 0 for invalid baud rate
+ */
+extern long serial_char_time_us(int baud);
+
+/**
+ * Modbus RTU inter-frame silence t3.5 for the given baud rate.
+ *
+ * @param baud Baud rate
+ * @return Silence time in microseconds, 0 for invalid baud rate
+ */
+extern long serial_frame_gap_us(int baud);
+
 #endif /* SERIAL_H */
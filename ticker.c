@@ -0,0 +1,93 @@
+/*
+ *  Drift-free periodic ticker on absolute CLOCK_MONOTONIC deadlines
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Period and deadline arithmetic in int64_t
+ */
+#include <string.h>  /* memset */
+#include <errno.h>   /* EINTR */
+
+#include "ticker.h"
+
+/*
+ *  Local function prototypes
+ */
+static void add_ns(struct timespec *t, int64_t ns);
+static int64_t diff_ns(const struct timespec *a, const struct timespec *b);
+
+/**********************************************************************/
+
+/*
+ *  Start a ticker, tick 0 is now
+ */
+void ticker_init(Ticker *t, long period_ms, TickerPolicy policy)
+{
+    memset(t, 0, sizeof(Ticker));
+    /* A 32-bit long holds only 2147 ms in nanoseconds */
+    t->period_ns = period_ms > 0 ? (int64_t)period_ms * 1000000 : 0;
+    t->policy = policy;
+    clock_gettime(CLOCK_MONOTONIC, &t->next);
+}
+
+/*
+ *  Wait for the next tick
+ */
+int ticker_wait(Ticker *t, volatile sig_atomic_t *running)
+{
+    struct timespec now;
+    int64_t late_ns, missed;
+    int rc;
+
+    if (t->period_ns == 0) {
+        return *running ? 0 : -1;
+    }
+
+    t->ticks++;
+    add_ns(&t->next, t->period_ns);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    late_ns = diff_ns(&now, &t->next);
+    if (late_ns >= 0) {
+        t->overruns++;
+        t->late_us = late_ns / 1000;
+        if (t->late_us > t->late_max_us) {
+            t->late_max_us = t->late_us;
+        }
+        if (t->policy == TICKER_CATCH_UP) {
+            return 1;  /* Deadline stays on the grid, the next ticks come early */
+        }
+
+        /* Drop every tick that is gone, wait for the first one ahead */
+        missed = late_ns / t->period_ns + 1;
+        t->skipped += (unsigned long)missed;
+        add_ns(&t->next, missed * t->period_ns);
+    }
+
+    do {
+        rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t->next, NULL);
+    } while (rc == EINTR && *running);
+
+    if (!*running) {
+        return -1;
+    }
+    return late_ns >= 0 ? 1 : 0;
+}
+
+/* Local functions */
+
+/*
+ *  Add nanoseconds to a time
+ */
+static void add_ns(struct timespec *t, int64_t ns)
+{
+    ns += t->tv_nsec;
+    t->tv_sec += (time_t)(ns / 1000000000);
+    t->tv_nsec = (long)(ns % 1000000000);
+}
+
+/*
+ *  Difference a - b in nanoseconds
+ */
+static int64_t diff_ns(const struct timespec *a, const struct timespec *b)
+{
+    return (int64_t)(a->tv_sec - b->tv_sec) * 1000000000 + (a->tv_nsec - b->tv_nsec);
+}
@@ -0,0 +1,62 @@
+/*
+ *  Drift-free periodic ticker on absolute CLOCK_MONOTONIC deadlines
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Period and lateness in int64_t, no overflow of a 32-bit long
+ *
+ *  Tick k is due at start + k * period, whatever the work between two
+ *  ticks cost, so the sample period does not stretch by the round trip
+ *  of every cycle. The wait is clock_nanosleep(TIMER_ABSTIME) on the
+ *  deadline itself. A tick that is already past when waited for is an
+ *  overrun: TICKER_SKIP drops the ticks that are gone and waits for the
+ *  next one on the grid, TICKER_CATCH_UP returns at once until the
+ *  ticker has caught up with the grid.
+ */
+#ifndef TICKER_H
+#define TICKER_H
+
+#include <stdint.h>  /* For int64_t */
+#include <signal.h>  /* For sig_atomic_t */
+#include <time.h>    /* For struct timespec */
+
+/**
+ * What to do with ticks missed by an overrun
+ */
+typedef enum {
+    TICKER_SKIP = 0,         /* Drop them, keep the phase */
+    TICKER_CATCH_UP = 1      /* Run them back-to-back, keep the count */
+} TickerPolicy;
+
+/**
+ * Ticker state and statistics
+ */
+typedef struct {
+    struct timespec next;    /* Deadline of the last tick */
+    int64_t period_ns;       /* Period, 0 = no waiting */
+    TickerPolicy policy;
+    unsigned long ticks;     /* Ticks waited for */
+    unsigned long overruns;  /* Ticks already past when waited for */
+    unsigned long skipped;   /* Ticks dropped (TICKER_SKIP) */
+    int64_t late_us;         /* How late the last overrun was */
+    int64_t late_max_us;     /* Latest overrun */
+} Ticker;
+
+/**
+ * Start a ticker, tick 0 is now
+ *
+ * @param t         Ticker
+ * @param period_ms Period in milliseconds, 0 = every wait returns at once
+ * @param policy    Handling of overruns
+ */
+extern void ticker_init(Ticker *t, long period_ms, TickerPolicy policy);
+
+/**
+ * Wait for the next tick
+ *
+ * @param t       Ticker
+ * @param running Flag cleared by the signal handler, the wait ends early
+ * @return        0 if the tick was waited for, 1 on an overrun (see
+ *                late_us, skipped), -1 if running was cleared
+ */
+extern int ticker_wait(Ticker *t, volatile sig_atomic_t *running);
+
+#endif /* TICKER_H */
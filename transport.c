@@ -0,0 +1,716 @@
+/*
+ *  Transport of Modbus RTU frames: serial port, RTU over TCP, Modbus TCP
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Input flush of an idle port
+ *  V1.2/2026-10-16 Serial ports closed through serial_close()
+ *  V1.3/2026-10-16 Connection state under a lock of its own, timed out requests released
+ */
+#include <stdio.h>        /* Standard input/output definitions */
+#include <string.h>       /* memcpy, strncmp */
+#include <unistd.h>       /* close, read, write */
+#include <fcntl.h>        /* fcntl */
+#include <errno.h>        /* Error numbers */
+#include <poll.h>         /* poll */
+#include <termios.h>      /* tcflush */
+#include <sys/ioctl.h>    /* FIONREAD */
+#include <pthread.h>      /* pthread_mutex */
+#include <netdb.h>        /* getaddrinfo */
+#include <sys/socket.h>   /* socket, connect, send, recv */
+#include <netinet/in.h>   /* IPPROTO_TCP */
+#include <netinet/tcp.h>  /* TCP_NODELAY */
+
+#include "transport.h"
+#include "serial.h"
+#include "crc16.h"
+#include "frame.h"
+
+/* Port name prefixes */
+#define PREFIX_RTU_TCP    "rtu-tcp://"
+#define PREFIX_MODBUS_TCP "tcp://"
+
+/* Longest port name of a network port */
+#define TRANSPORT_NAME_MAX 128
+
+/* MBAP header: transaction ID, protocol ID, length, unit ID */
+#define MBAP_HEADER_SIZE 7
+
+/* Receive buffer of a connection: a full window of the largest responses */
+#define LINK_INPUT_SIZE (TRANSPORT_MAX_INFLIGHT * (MBAP_HEADER_SIZE + FRAME_MAX_SIZE))
+
+/**
+ * State of a request slot
+ */
+typedef enum {
+    SLOT_FREE = 0,   /* Unused */
+    SLOT_WAITING,    /* Request sent, response not in yet */
+    SLOT_READY       /* Response in, not read yet */
+} SlotState;
+
+/**
+ * One Modbus TCP request in flight
+ */
+typedef struct {
+    SlotState state;                /* Slot state */
+    uint16_t tid;                   /* Transaction ID */
+    unsigned long seq;              /* Send order, the oldest is given up first */
+    uint8_t frame[FRAME_MAX_SIZE];  /* Response as RTU frame */
+    int len;                        /* Bytes of the response left to read */
+} LinkSlot;
+
+/**
+ * One network connection, shared by the file descriptors opened on it
+ */
+typedef struct {
+    int refs;                               /* File descriptors on it, 0 = free */
+    pthread_mutex_t lock;                   /* Slots, input, TIDs and statistics */
+    TransportType type;                     /* RTU over TCP or Modbus TCP */
+    char name[TRANSPORT_NAME_MAX];          /* Port name, to share the connection */
+    uint16_t next_tid;                      /* Transaction ID of the next request */
+    unsigned long seq;                      /* Requests sent */
+    LinkSlot slot[TRANSPORT_MAX_INFLIGHT];  /* Requests in flight */
+    uint8_t in[LINK_INPUT_SIZE];            /* Bytes of incomplete ADUs */
+    int in_len;                             /* Bytes in in[] */
+    TransportStats stats;                   /* Statistics */
+} Link;
+
+/*
+ *  Connections and the file descriptors on them. The tables are searched
+ *  and changed under table_lock, a connection is used under its own lock
+ *  (table_lock first): threads share a Modbus TCP connection.
+ */
+static Link links[TRANSPORT_MAX_LINKS];
+static struct {
+    int fd;
+    Link *link;                     /* NULL = entry free */
+} fds[TRANSPORT_MAX_LINKS];
+static int n_fds = 0;
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ *  Local function prototypes
+ */
+static Link *lock_link(int fd);
+static int add_fd(int fd, Link *l);
+static int connect_tcp(const char *address);
+static int send_all(int fd, const uint8_t *buf, int len);
+static int pump(int fd, Link *l);
+static void deliver(Link *l, uint16_t tid, const uint8_t *unit_pdu, int len);
+static LinkSlot *take_slot(Link *l);
+static LinkSlot *find_slot(Link *l, uint16_t tid, SlotState state);
+
+/**********************************************************************/
+
+/*
+ *  Get the transport a port name selects
+ */
+TransportType transport_type(const char *port)
+{
+    if (port == NULL) {
+        return TRANSPORT_SERIAL;
+    }
+    if (strncmp(port, PREFIX_RTU_TCP, strlen(PREFIX_RTU_TCP)) == 0) {
+        return TRANSPORT_RTU_TCP;
+    }
+    if (strncmp(port, PREFIX_MODBUS_TCP, strlen(PREFIX_MODBUS_TCP)) == 0) {
+        return TRANSPORT_MODBUS_TCP;
+    }
+
+    return TRANSPORT_SERIAL;
+}
+
+/*
+ *  Open a port
+ */
+int transport_open(const char *port)
+{
+    TransportType type = transport_type(port);
+    const char *address;
+    Link *l = NULL;
+    int fd = -1, k;
+
+    if (type == TRANSPORT_SERIAL) {
+        return open_port(port);
+    }
+    if (strlen(port) >= TRANSPORT_NAME_MAX) {
+        fprintf(stderr, "transport: port name too long: %s\n", port);
+        return SERIAL_ERROR_OPEN;
+    }
+    address = port + strlen(type == TRANSPORT_RTU_TCP ? PREFIX_RTU_TCP : PREFIX_MODBUS_TCP);
+
+    pthread_mutex_lock(&table_lock);
+
+    /* Modbus TCP responses carry their transaction ID: one connection serves all */
+    if (type == TRANSPORT_MODBUS_TCP) {
+        for (k = 0; k < TRANSPORT_MAX_LINKS; k++) {
+            if (fds[k].link != NULL && fds[k].link->type == type &&
+                strcmp(fds[k].link->name, port) == 0) {
+                fd = fcntl(fds[k].fd, F_DUPFD_CLOEXEC, 0);
+                l = fds[k].link;
+                break;
+            }
+        }
+    }
+
+    if (l == NULL) {
+        for (k = 0; k < TRANSPORT_MAX_LINKS && links[k].refs > 0; k++) {
+        }
+        if (k == TRANSPORT_MAX_LINKS || n_fds == TRANSPORT_MAX_LINKS) {
+            pthread_mutex_unlock(&table_lock);
+            fprintf(stderr, "transport: more than %d network ports\n", TRANSPORT_MAX_LINKS);
+            return SERIAL_ERROR_OPEN;
+        }
+        l = &links[k];
+        memset(l, 0, sizeof(Link));
+        pthread_mutex_init(&l->lock, NULL);
+        l->type = type;
+        strcpy(l->name, port);  /* Length checked above */
+        l->next_tid = 1;
+        fd = connect_tcp(address);
+    }
+
+    if (fd < 0 || add_fd(fd, l) < 0) {
+        if (l->refs == 0) {
+            pthread_mutex_destroy(&l->lock);
+        }
+        pthread_mutex_unlock(&table_lock);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return SERIAL_ERROR_OPEN;
+    }
+
+    pthread_mutex_unlock(&table_lock);
+    return fd;
+}
+
+/*
+ *  Get the transport of an open file descriptor
+ */
+TransportType transport_fd_type(int fd)
+{
+    Link *l = lock_link(fd);
+    TransportType type = TRANSPORT_SERIAL;
+
+    if (l != NULL) {
+        type = l->type;
+        pthread_mutex_unlock(&l->lock);
+    }
+
+    return type;
+}
+
+/*
+ *  Get the baud rate requests are paced with
+ */
+int transport_pace_baud(TransportType type, int baud)
+{
+    /* The gateway of a Modbus TCP port runs its bus itself */
+    return type == TRANSPORT_MODBUS_TCP ? 0 : baud;
+}
+
+/*
+ *  Send one RTU frame
+ */
+int transport_write(int fd, const uint8_t *frame, int len, uint16_t *tid)
+{
+    Link *l = lock_link(fd);
+    uint8_t adu[MBAP_HEADER_SIZE + FRAME_MAX_SIZE];
+    LinkSlot *s;
+    int pdu_len, result;
+
+    *tid = 0;
+    if (l == NULL) {
+        return (int)write(fd, frame, (size_t)len);
+    }
+    if (l->type == TRANSPORT_RTU_TCP) {
+        result = send_all(fd, frame, len);
+        pthread_mutex_unlock(&l->lock);
+        return result;
+    }
+
+    /* Modbus TCP: unit ID and PDU behind the MBAP header, no CRC */
+    if (len < FRAME_MIN_SIZE || len > FRAME_MAX_SIZE) {
+        pthread_mutex_unlock(&l->lock);
+        errno = EINVAL;
+        return -1;
+    }
+    pdu_len = len - 3;
+
+    s = take_slot(l);
+    s->tid = l->next_tid++;
+    if (l->next_tid == 0) {
+        l->next_tid = 1;  /* 0 means no transaction */
+    }
+
+    adu[0] = (uint8_t)(s->tid >> 8);
+    adu[1] = (uint8_t)(s->tid & 0xFF);
+    adu[2] = 0x00;  /* Protocol ID: Modbus */
+    adu[3] = 0x00;
+    adu[4] = (uint8_t)((pdu_len + 1) >> 8);
+    adu[5] = (uint8_t)((pdu_len + 1) & 0xFF);
+    adu[6] = frame[0];
+    memcpy(adu + MBAP_HEADER_SIZE, frame + 1, (size_t)pdu_len);
+
+    /* Sent under the lock, ADUs of two threads never interleave */
+    if (send_all(fd, adu, MBAP_HEADER_SIZE + pdu_len) < 0) {
+        s->state = SLOT_FREE;
+        pthread_mutex_unlock(&l->lock);
+        return -1;
+    }
+
+    l->stats.sent++;
+    *tid = s->tid;
+    pthread_mutex_unlock(&l->lock);
+    return len;
+}
+
+/*
+ *  Read received bytes without blocking
+ */
+int transport_read(int fd, uint16_t tid, uint8_t *buf, int room)
+{
+    Link *l = lock_link(fd);
+    LinkSlot *s;
+    ssize_t n;
+
+    if (l == NULL) {
+        return (int)read(fd, buf, (size_t)room);
+    }
+
+    if (l->type == TRANSPORT_RTU_TCP) {
+        pthread_mutex_unlock(&l->lock);
+        n = recv(fd, buf, (size_t)room, MSG_DONTWAIT);
+        if (n == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+        return (int)n;
+    }
+
+    if (pump(fd, l) < 0) {
+        pthread_mutex_unlock(&l->lock);
+        return -1;
+    }
+
+    s = find_slot(l, tid, SLOT_READY);
+    if (s == NULL) {
+        pthread_mutex_unlock(&l->lock);
+        errno = EAGAIN;  /* Nothing for this transaction yet */
+        return -1;
+    }
+
+    n = s->len < room ? s->len : room;
+    memcpy(buf, s->frame, (size_t)n);
+    s->len -= (int)n;
+    if (s->len > 0) {
+        memmove(s->frame, s->frame + n, (size_t)s->len);
+    } else {
+        s->state = SLOT_FREE;
+    }
+
+    pthread_mutex_unlock(&l->lock);
+    return (int)n;
+}
+
+/*
+ *  Discard received bytes no transaction waits for, without blocking
+ */
+int transport_flush(int fd)
+{
+    Link *l = lock_link(fd);
+    uint8_t buf[256];
+    int queued = 0, total = 0;
+    ssize_t n;
+
+    if (l == NULL) {
+        /* A blocking read would wait VTIME, the queue is dropped instead */
+        if (ioctl(fd, FIONREAD, &queued) < 0) {
+            queued = 0;
+        }
+        return tcflush(fd, TCIFLUSH) < 0 ? -1 : queued;
+    }
+
+    if (l->type == TRANSPORT_MODBUS_TCP) {
+        while ((n = pump(fd, l)) > 0) {
+            /* Responses in flight go to their slots, late ones are dropped */
+        }
+        pthread_mutex_unlock(&l->lock);
+        return n < 0 ? -1 : 0;
+    }
+
+    pthread_mutex_unlock(&l->lock);
+    while ((n = recv(fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        total += (int)n;
+    }
+    if (n == 0) {
+        errno = ECONNRESET;
+        return -1;
+    }
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        return -1;
+    }
+
+    return total;
+}
+
+/*
+ *  Check for a response already taken off the connection
+ */
+int transport_pending(int fd, uint16_t tid)
+{
+    Link *l;
+    int ready;
+
+    if (tid == 0 || (l = lock_link(fd)) == NULL) {
+        return 0;
+    }
+
+    ready = find_slot(l, tid, SLOT_READY) != NULL;
+    pthread_mutex_unlock(&l->lock);
+    return ready;
+}
+
+/*
+ *  Give up a transaction
+ */
+void transport_release(int fd, uint16_t tid)
+{
+    Link *l;
+    LinkSlot *s;
+
+    if (tid == 0 || (l = lock_link(fd)) == NULL) {
+        return;
+    }
+
+    /* A response still on the way is counted as stale */
+    if ((s = find_slot(l, tid, SLOT_WAITING)) != NULL ||
+        (s = find_slot(l, tid, SLOT_READY)) != NULL) {
+        s->state = SLOT_FREE;
+    }
+    pthread_mutex_unlock(&l->lock);
+}
+
+/*
+ *  Get Modbus TCP statistics of the connection of a file descriptor
+ */
+int transport_get_stats(int fd, TransportStats *stats)
+{
+    Link *l = lock_link(fd);
+    int result = -1;
+
+    if (l == NULL) {
+        return -1;
+    }
+
+    if (l->type == TRANSPORT_MODBUS_TCP) {
+        *stats = l->stats;
+        result = 0;
+    }
+    pthread_mutex_unlock(&l->lock);
+    return result;
+}
+
+/*
+ *  Close a port opened with transport_open()
+ */
+void transport_close(int fd)
+{
+    int network = 0;
+
+    if (fd < 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&table_lock);
+    for (int k = 0; k < TRANSPORT_MAX_LINKS; k++) {
+        if (fds[k].link != NULL && fds[k].fd == fd) {
+            if (--fds[k].link->refs == 0) {
+                pthread_mutex_destroy(&fds[k].link->lock);
+            }
+            fds[k].link = NULL;
+            __atomic_sub_fetch(&n_fds, 1, __ATOMIC_RELEASE);
+            network = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&table_lock);
+
+    if (network) {
+        close(fd);
+    } else {
+        serial_close(fd);  /* Undoes the low-latency profile */
+    }
+}
+
+/* Local functions */
+
+/*
+ *  Get the connection of a file descriptor locked, NULL for a serial port
+ */
+static Link *lock_link(int fd)
+{
+    Link *l = NULL;
+
+    if (__atomic_load_n(&n_fds, __ATOMIC_ACQUIRE) == 0) {
+        return NULL;  /* Serial ports only */
+    }
+
+    pthread_mutex_lock(&table_lock);
+    for (int k = 0; k < TRANSPORT_MAX_LINKS; k++) {
+        if (fds[k].link != NULL && fds[k].fd == fd) {
+            l = fds[k].link;
+            pthread_mutex_lock(&l->lock);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&table_lock);
+
+    return l;
+}
+
+/*
+ *  Register a file descriptor on a connection (table locked)
+ */
+static int add_fd(int fd, Link *l)
+{
+    for (int k = 0; k < TRANSPORT_MAX_LINKS; k++) {
+        if (fds[k].link == NULL) {
+            fds[k].fd = fd;
+            fds[k].link = l;
+            l->refs++;
+            __atomic_add_fetch(&n_fds, 1, __ATOMIC_RELEASE);
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "transport: more than %d network ports\n", TRANSPORT_MAX_LINKS);
+    return -1;
+}
+
+/*
+ *  Connect to host[:port] or [IPv6]:port
+ */
+static int connect_tcp(const char *address)
+{
+    char host[TRANSPORT_NAME_MAX];
+    char service[16];
+    const char *colon;
+    struct addrinfo hints, *res, *ai;
+    struct pollfd pfd;
+    socklen_t errlen;
+    int fd = -1, rc, err = 0, one = 1;
+    size_t n;
+
+    /* Split host and port */
+    if (address[0] == '[' && (colon = strchr(address, ']')) != NULL) {
+        n = (size_t)(colon - address - 1);
+        memcpy(host, address + 1, n);
+        host[n] = '\0';
+        colon = colon[1] == ':' ? colon + 1 : NULL;
+    } else {
+        colon = strrchr(address, ':');
+        n = colon != NULL ? (size_t)(colon - address) : strlen(address);
+        memcpy(host, address, n);
+        host[n] = '\0';
+    }
+    if (colon != NULL) {
+        snprintf(service, sizeof(service), "%s", colon + 1);
+    } else {
+        snprintf(service, sizeof(service), "%d", TRANSPORT_TCP_PORT);
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    rc = getaddrinfo(host, service, &hints, &res);
+    if (rc != 0) {
+        fprintf(stderr, "transport: %s: %s\n", address, gai_strerror(rc));
+        return SERIAL_ERROR_OPEN;
+    }
+
+    for (ai = res; ai != NULL; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                    ai->ai_protocol);
+        if (fd < 0) {
+            err = errno;
+            continue;
+        }
+
+        /* Connect with a timeout instead of the kernel's minutes */
+        rc = connect(fd, ai->ai_addr, ai->ai_addrlen);
+        if (rc < 0 && errno == EINPROGRESS) {
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            rc = poll(&pfd, 1, TRANSPORT_CONNECT_TIMEOUT_MS);
+            errlen = sizeof(err);
+            if (rc == 0) {
+                err = ETIMEDOUT;
+            } else if (rc < 0 || getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errlen) < 0) {
+                err = errno;
+            }
+            rc = err == 0 ? 0 : -1;
+        } else if (rc < 0) {
+            err = errno;
+        }
+
+        if (rc == 0) {
+            break;
+        }
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+
+    if (fd < 0) {
+        fprintf(stderr, "transport: Unable to connect to %s - %s\n", address, strerror(err));
+        return SERIAL_ERROR_OPEN;
+    }
+
+    /* Blocking sends, requests go out at once */
+    fcntl(fd, F_SETFL, 0);
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    return fd;
+}
+
+/*
+ *  Send a whole buffer on a socket
+ */
+static int send_all(int fd, const uint8_t *buf, int len)
+{
+    ssize_t n;
+    int done = 0;
+
+    while (done < len) {
+        n = send(fd, buf + done, (size_t)(len - done), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        done += (int)n;
+    }
+
+    return len;
+}
+
+/*
+ *  Take what the connection has and hand complete ADUs to their requests
+ *  (connection locked)
+ */
+static int pump(int fd, Link *l)
+{
+    const uint8_t *p;
+    int off = 0, length;
+    ssize_t n;
+
+    n = recv(fd, l->in + l->in_len, sizeof(l->in) - (size_t)l->in_len, MSG_DONTWAIT);
+    if (n == 0) {
+        errno = ECONNRESET;
+        return -1;
+    }
+    if (n < 0) {
+        return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    }
+    l->in_len += (int)n;
+
+    while (l->in_len - off >= MBAP_HEADER_SIZE) {
+        p = l->in + off;
+        length = (p[4] << 8) | p[5];  /* Unit ID + PDU */
+
+        /* Not Modbus TCP: the stream cannot be split any more */
+        if (p[2] != 0 || p[3] != 0 || length < 2 || length > FRAME_MAX_SIZE - 2) {
+            l->in_len = 0;
+            errno = EPROTO;
+            return -1;
+        }
+        if (l->in_len - off < 6 + length) {
+            break;  /* Rest of the ADU still on the way */
+        }
+
+        deliver(l, (uint16_t)((p[0] << 8) | p[1]), p + 6, length);
+        off += 6 + length;
+    }
+
+    l->in_len -= off;
+    memmove(l->in, l->in + off, (size_t)l->in_len);
+
+    return (int)n;
+}
+
+/*
+ *  Store a response as RTU frame in the slot of its transaction
+ */
+static void deliver(Link *l, uint16_t tid, const uint8_t *unit_pdu, int len)
+{
+    LinkSlot *s = find_slot(l, tid, SLOT_WAITING);
+    uint16_t crc;
+
+    if (s == NULL) {
+        l->stats.stale++;  /* Answer to a request given up */
+        return;
+    }
+
+    memcpy(s->frame, unit_pdu, (size_t)len);
+    crc = crc16_modbus(s->frame, (size_t)len);
+    s->frame[len] = (uint8_t)(crc & 0xFF);
+    s->frame[len + 1] = (uint8_t)(crc >> 8);
+    s->len = len + 2;
+    s->state = SLOT_READY;
+    l->stats.matched++;
+}
+
+/*
+ *  Get a free request slot, giving up the oldest request if the window is full
+ *  (connection locked)
+ */
+static LinkSlot *take_slot(Link *l)
+{
+    LinkSlot *s = NULL;
+    int k, used = 0;
+
+    for (k = 0; k < TRANSPORT_MAX_INFLIGHT; k++) {
+        if (l->slot[k].state == SLOT_FREE) {
+            if (s == NULL) {
+                s = &l->slot[k];
+            }
+        } else {
+            used++;
+        }
+    }
+
+    if (s == NULL) {
+        s = &l->slot[0];
+        for (k = 1; k < TRANSPORT_MAX_INFLIGHT; k++) {
+            if (l->slot[k].seq < s->seq) {
+                s = &l->slot[k];
+            }
+        }
+        l->stats.evicted++;
+        used--;
+    }
+
+    s->state = SLOT_WAITING;
+    s->seq = l->seq++;
+    s->len = 0;
+    if (used + 1 > l->stats.inflight_max) {
+        l->stats.inflight_max = used + 1;
+    }
+
+    return s;
+}
+
+/*
+ *  Find the slot of a transaction in a state
+ */
+static LinkSlot *find_slot(Link *l, uint16_t tid, SlotState state)
+{
+    for (int k = 0; k < TRANSPORT_MAX_INFLIGHT; k++) {
+        if (l->slot[k].state == state && l->slot[k].tid == tid) {
+            return &l->slot[k];
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,177 @@
+/*
+ *  Transport of Modbus RTU frames: serial port, RTU over TCP, Modbus TCP
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Input flush of an idle port
+ *  V1.2/2026-10-16 Serial ports closed through serial_close()
+ *  V1.3/2026-10-16 Connection state under a lock of its own, timed out requests released
+ *
+ *  Everything above this layer sends and receives RTU frames (address,
+ *  PDU, CRC) on a file descriptor. The port name selects the transport:
+ *
+ *    /dev/ttyUSB0             local serial port (open_port(), flock)
+ *    rtu-tcp://host[:port]    raw RTU frames over TCP (serial device server)
+ *    tcp://host[:port]        Modbus TCP: MBAP header instead of the CRC
+ *
+ *  For Modbus TCP a request is sent with a new transaction ID, and the
+ *  response comes back as an RTU frame with its CRC recomputed, so the
+ *  frame assembler and everything above it work unchanged. Responses are
+ *  matched by transaction ID. Several requests can be in flight on one
+ *  connection, and a port opened twice shares it, also between threads.
+ */
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <stdint.h>  /* For uint8_t, uint16_t */
+
+/* Default TCP port of both network transports */
+#define TRANSPORT_TCP_PORT 502
+
+/* Most network file descriptors open at once */
+#define TRANSPORT_MAX_LINKS 16
+
+/* Most Modbus TCP requests in flight on one connection */
+#define TRANSPORT_MAX_INFLIGHT 8
+
+/* Connection timeout [ms] */
+#define TRANSPORT_CONNECT_TIMEOUT_MS 3000
+
+/**
+ * Transport of a port
+ */
+typedef enum {
+    TRANSPORT_SERIAL = 0,      /* Local tty */
+    TRANSPORT_RTU_TCP = 1,     /* RTU frames as they are over TCP */
+    TRANSPORT_MODBUS_TCP = 2   /* MBAP header + PDU over TCP */
+} TransportType;
+
+/**
+ * Modbus TCP statistics of one connection
+ */
+typedef struct {
+    unsigned long sent;        /* Requests sent */
+    unsigned long matched;     /* Responses matched to their request */
+    unsigned long stale;       /* Responses of unknown transaction ID (late) */
+    unsigned long evicted;     /* Requests given up to make room in the window */
+    int inflight_max;          /* Most requests in flight at once */
+} TransportStats;
+
+/**
+ * Get the transport a port name selects
+ *
+ * @param port Port name
+ * @return     Transport type
+ */
+extern TransportType transport_type(const char *port);
+
+/**
+ * Open a port
+ *
+ * A serial port is opened with open_port() and still needs set_port().
+ * A network port is connected. Opening a Modbus TCP port that is already
+ * open shares its connection through a new file descriptor.
+ *
+ * @param port Port name
+ * @return     File descriptor, negative error code (serial.h) on failure
+ */
+extern int transport_open(const char *port);
+
+/**
+ * Get the transport of an open file descriptor
+ *
+ * @param fd File descriptor
+ * @return   Transport type, TRANSPORT_SERIAL for any fd not opened here
+ */
+extern TransportType transport_fd_type(int fd);
+
+/**
+ * Get the baud rate requests are paced with (frame gap, character time)
+ *
+ * An RTU converter forwards frames as they come, so the RS485 rate behind
+ * it still sets the gaps. A Modbus TCP gateway paces its bus itself.
+ *
+ * @param type Transport of the port
+ * @param baud Baud rate of the serial line
+ * @return     Baud rate for bus_timing_init(), 0 = no gaps
+ */
+extern int transport_pace_baud(TransportType type, int baud);
+
+/**
+ * Send one RTU frame
+ *
+ * @param fd    File descriptor
+ * @param frame Frame with CRC
+ * @param len   Frame length
+ * @param tid   Pointer to store the transaction ID (0 if the transport has none)
+ * @return      len on success, -1 with errno set on failure
+ */
+extern int transport_write(int fd, const uint8_t *frame, int len, uint16_t *tid);
+
+/**
+ * Read received bytes without blocking
+ *
+ * For Modbus TCP only the response to the transaction is returned.
+ * Responses to other transactions on the connection are kept for their
+ * own readers.
+ *
+ * @param fd   File descriptor
+ * @param tid  Transaction ID from transport_write()
+ * @param buf  Buffer
+ * @param room Size of the buffer
+ * @return     Bytes read, -1 with errno EAGAIN if there is nothing yet,
+ *             -1 with another errno on failure (ECONNRESET if the peer closed)
+ */
+extern int transport_read(int fd, uint16_t tid, uint8_t *buf, int room);
+
+/**
+ * Discard received bytes no transaction waits for, without blocking
+ *
+ * A serial port drops its input queue (tcflush), RTU over TCP reads the
+ * socket empty. Modbus TCP only takes the responses off the connection:
+ * those of transactions in flight stay for their readers
+ * (transport_pending()), late ones are dropped and counted as stale.
+ *
+ * @param fd File descriptor
+ * @return   Bytes discarded, -1 with errno set on failure
+ */
+extern int transport_flush(int fd);
+
+/**
+ * Check for a response already taken off the connection
+ *
+ * Another reader of a shared connection may have read it, so the file
+ * descriptor does not become readable for it any more.
+ *
+ * @param fd  File descriptor
+ * @param tid Transaction ID
+ * @return    1 if transport_read() has data for tid, 0 otherwise
+ */
+extern int transport_pending(int fd, uint16_t tid);
+
+/**
+ * Give up a transaction
+ *
+ * Frees its slot in the Modbus TCP window, a response that still comes
+ * is dropped as stale. Does nothing for other transports or tid 0.
+ *
+ * @param fd  File descriptor
+ * @param tid Transaction ID from transport_write()
+ */
+extern void transport_release(int fd, uint16_t tid);
+
+/**
+ * Get Modbus TCP statistics of the connection of a file descriptor
+ *
+ * @param fd    File descriptor
+ * @param stats Pointer to store the statistics
+ * @return      0 on success, -1 if fd is not a Modbus TCP port
+ */
+extern int transport_get_stats(int fd, TransportStats *stats);
+
+/**
+ * Close a port opened with transport_open()
+ *
+ * @param fd File descriptor
+ */
+extern void transport_close(int fd);
+
+#endif /* TRANSPORT_H */
@@ -0,0 +1,410 @@
+/*
+ *  Minimal io_uring ring (raw system calls, no liburing)
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Free submission entries
+ */
+#include <string.h>       /* memset */
+#include <errno.h>        /* Error numbers */
+
+#include "uring.h"
+
+#ifndef NO_URING
+#include <unistd.h>       /* close, syscall */
+#include <poll.h>         /* POLLIN */
+#include <sys/mman.h>     /* mmap, munmap */
+#include <sys/syscall.h>  /* __NR_io_uring_setup, __NR_io_uring_enter */
+
+/* Ring memory is shared with the kernel */
+#define READ_ONCE(x)      __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define WRITE_ONCE(x, v)  __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+/*
+ *  Local function prototypes
+ */
+static struct io_uring_sqe *get_sqe(Uring *r);
+static uint8_t sqe_flags(unsigned flags);
+
+/**********************************************************************/
+
+/*
+ *  Set up a ring
+ */
+int uring_init(Uring *r, unsigned entries)
+{
+    struct io_uring_params p;
+    char *sq, *cq;
+
+    memset(r, 0, sizeof(Uring));
+    memset(&p, 0, sizeof(p));
+
+    r->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (r->fd < 0) {
+        r->fd = -1;
+        return -errno;
+    }
+
+    /* Timeouts of the wait itself (5.11), completions skipped on success (5.17) */
+    if (!(p.features & IORING_FEAT_EXT_ARG) || !(p.features & IORING_FEAT_CQE_SKIP)) {
+        uring_close(r);
+        return -ENOSYS;
+    }
+
+    r->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (r->cq_ring_size > r->sq_ring_size) {
+            r->sq_ring_size = r->cq_ring_size;
+        }
+        r->cq_ring_size = r->sq_ring_size;
+    }
+
+    r->sq_ring = mmap(NULL, r->sq_ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+    if (r->sq_ring == MAP_FAILED) {
+        r->sq_ring = NULL;
+        uring_close(r);
+        return -ENOMEM;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        r->cq_ring = r->sq_ring;
+    } else {
+        r->cq_ring = mmap(NULL, r->cq_ring_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+        if (r->cq_ring == MAP_FAILED) {
+            r->cq_ring = NULL;
+            uring_close(r);
+            return -ENOMEM;
+        }
+    }
+
+    r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, r->fd, IORING_OFF_SQES);
+    if (r->sqes == MAP_FAILED) {
+        r->sqes = NULL;
+        uring_close(r);
+        return -ENOMEM;
+    }
+
+    sq = r->sq_ring;
+    cq = r->cq_ring;
+    r->sq_head = (unsigned *)(sq + p.sq_off.head);
+    r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(sq + p.sq_off.array);
+    r->cq_head = (unsigned *)(cq + p.cq_off.head);
+    r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    r->sq_local_tail = *r->sq_tail;
+    r->sq_submitted = r->sq_local_tail;
+
+    return 0;
+}
+
+/*
+ *  Queue a read at the current file position
+ */
+int uring_read(Uring *r, int fd, void *buf, unsigned len, uint64_t user_data,
+               unsigned flags)
+{
+    struct io_uring_sqe *sqe = get_sqe(r);
+
+    if (sqe == NULL) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = (uint64_t)-1;  /* Stream: no offset */
+    sqe->user_data = user_data;
+    sqe->flags = sqe_flags(flags);
+
+    return 0;
+}
+
+/*
+ *  Queue a write at the current file position
+ */
+int uring_write(Uring *r, int fd, const void *buf, unsigned len,
+                uint64_t user_data, unsigned flags)
+{
+    struct io_uring_sqe *sqe = get_sqe(r);
+
+    if (sqe == NULL) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = (uint64_t)-1;
+    sqe->user_data = user_data;
+    sqe->flags = sqe_flags(flags);
+
+    return 0;
+}
+
+/*
+ *  Queue a timeout for the entry queued just before
+ */
+int uring_link_timeout(Uring *r, const UringTime *ts, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = get_sqe(r);
+
+    if (sqe == NULL) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_LINK_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t)(uintptr_t)ts;
+    sqe->len = 1;
+    sqe->timeout_flags = IORING_TIMEOUT_ABS;  /* CLOCK_MONOTONIC by default */
+    sqe->user_data = user_data;
+
+    return 0;
+}
+
+/*
+ *  Queue a wait the next entry is hard-linked to
+ */
+int uring_delay(Uring *r, const UringTime *ts, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = get_sqe(r);
+
+    if (sqe == NULL) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t)(uintptr_t)ts;
+    sqe->len = 1;
+    sqe->off = 0;  /* Pure timer, not a completion count */
+    sqe->timeout_flags = IORING_TIMEOUT_ABS | IORING_TIMEOUT_ETIME_SUCCESS;
+    sqe->user_data = user_data;
+    sqe->flags = sqe_flags(URING_LINK | URING_QUIET);  /* -ETIME counts as success */
+
+    return 0;
+}
+
+/*
+ *  Queue a one-shot readiness poll
+ */
+int uring_poll(Uring *r, int fd, uint64_t user_data)
+{
+    struct io_uring_sqe *sqe = get_sqe(r);
+
+    if (sqe == NULL) {
+        return -1;
+    }
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = user_data;
+
+    return 0;
+}
+
+/*
+ *  Get the number of free submission entries
+ */
+unsigned uring_sq_space(Uring *r)
+{
+    return *r->sq_mask + 1 - (r->sq_local_tail - READ_ONCE(*r->sq_head));
+}
+
+/*
+ *  Submit all queued entries and wait for completions in one system call
+ */
+int uring_submit_wait(Uring *r, unsigned wait_nr, int timeout_ms)
+{
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    unsigned to_submit;
+    unsigned flags = 0;
+    long rc;
+
+    /* Publish the new tail, the entries are filled in already */
+    to_submit = r->sq_local_tail - r->sq_submitted;
+    WRITE_ONCE(*r->sq_tail, r->sq_local_tail);
+    r->sq_submitted = r->sq_local_tail;
+
+    memset(&arg, 0, sizeof(arg));
+    if (wait_nr > 0) {
+        flags |= IORING_ENTER_GETEVENTS;
+        if (timeout_ms >= 0) {
+            ts.tv_sec = timeout_ms / 1000;
+            ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000LL;
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+        }
+    }
+    flags |= IORING_ENTER_EXT_ARG;
+
+    r->batch = 0;
+    r->stats.enters++;
+    r->stats.sqes += to_submit;
+    rc = syscall(__NR_io_uring_enter, r->fd, to_submit, wait_nr, flags, &arg, sizeof(arg));
+
+    return rc < 0 ? -errno : 0;
+}
+
+/*
+ *  Get the next completion without waiting
+ */
+int uring_next(Uring *r, uint64_t *user_data, int *res)
+{
+    unsigned head = *r->cq_head;
+    struct io_uring_cqe *cqe;
+
+    if (head == READ_ONCE(*r->cq_tail)) {
+        return 0;
+    }
+
+    cqe = &r->cqes[head & *r->cq_mask];
+    *user_data = cqe->user_data;
+    *res = cqe->res;
+    WRITE_ONCE(*r->cq_head, head + 1);
+
+    r->stats.cqes++;
+    if (++r->batch > r->stats.batch_max) {
+        r->stats.batch_max = r->batch;
+    }
+
+    return 1;
+}
+
+/*
+ *  Unmap the rings and close the instance
+ */
+void uring_close(Uring *r)
+{
+    if (r->sqes != NULL) {
+        munmap(r->sqes, r->sqes_size);
+        r->sqes = NULL;
+    }
+    if (r->cq_ring != NULL && r->cq_ring != r->sq_ring) {
+        munmap(r->cq_ring, r->cq_ring_size);
+    }
+    r->cq_ring = NULL;
+    if (r->sq_ring != NULL) {
+        munmap(r->sq_ring, r->sq_ring_size);
+        r->sq_ring = NULL;
+    }
+    if (r->fd >= 0) {
+        close(r->fd);
+        r->fd = -1;
+    }
+}
+
+/* Local functions */
+
+/*
+ *  Take a cleared submission entry, NULL if the queue is full
+ */
+static struct io_uring_sqe *get_sqe(Uring *r)
+{
+    unsigned tail = r->sq_local_tail;
+    unsigned index;
+
+    if (tail - READ_ONCE(*r->sq_head) >= *r->sq_mask + 1) {
+        return NULL;
+    }
+
+    index = tail & *r->sq_mask;
+    r->sq_array[index] = index;
+    r->sq_local_tail = tail + 1;
+    memset(&r->sqes[index], 0, sizeof(struct io_uring_sqe));
+
+    return &r->sqes[index];
+}
+
+/*
+ *  Translate entry flags
+ */
+static uint8_t sqe_flags(unsigned flags)
+{
+    return (uint8_t)(((flags & URING_LINK) ? IOSQE_IO_LINK : 0) |
+                     ((flags & URING_ASYNC) ? IOSQE_ASYNC : 0) |
+                     ((flags & URING_QUIET) ? IOSQE_CQE_SKIP_SUCCESS : 0));
+}
+
+#else /* NO_URING */
+
+/*
+ *  Built without io_uring: every call fails, the poller uses epoll
+ */
+int uring_init(Uring *r, unsigned entries)
+{
+    (void)entries;
+    memset(r, 0, sizeof(Uring));
+    r->fd = -1;
+    return -ENOSYS;
+}
+
+int uring_read(Uring *r, int fd, void *buf, unsigned len, uint64_t user_data,
+               unsigned flags)
+{
+    (void)r; (void)fd; (void)buf; (void)len; (void)user_data; (void)flags;
+    return -1;
+}
+
+int uring_write(Uring *r, int fd, const void *buf, unsigned len,
+                uint64_t user_data, unsigned flags)
+{
+    (void)r; (void)fd; (void)buf; (void)len; (void)user_data; (void)flags;
+    return -1;
+}
+
+int uring_link_timeout(Uring *r, const UringTime *ts, uint64_t user_data)
+{
+    (void)r; (void)ts; (void)user_data;
+    return -1;
+}
+
+int uring_delay(Uring *r, const UringTime *ts, uint64_t user_data)
+{
+    (void)r; (void)ts; (void)user_data;
+    return -1;
+}
+
+int uring_poll(Uring *r, int fd, uint64_t user_data)
+{
+    (void)r; (void)fd; (void)user_data;
+    return -1;
+}
+
+unsigned uring_sq_space(Uring *r)
+{
+    (void)r;
+    return 0;
+}
+
+int uring_submit_wait(Uring *r, unsigned wait_nr, int timeout_ms)
+{
+    (void)r; (void)wait_nr; (void)timeout_ms;
+    return -ENOSYS;
+}
+
+int uring_next(Uring *r, uint64_t *user_data, int *res)
+{
+    (void)r; (void)user_data; (void)res;
+    return 0;
+}
+
+void uring_close(Uring *r)
+{
+    r->fd = -1;
+}
+
+#endif /* NO_URING */
+
+/*
+ *  Convert a CLOCK_MONOTONIC time to a ring timeout
+ */
+void uring_time(const struct timespec *t, UringTime *ts)
+{
+    ts->tv_sec = t->tv_sec;
+    ts->tv_nsec = t->tv_nsec;
+}
@@ -0,0 +1,191 @@
+/*
+ *  Minimal io_uring ring (raw system calls, no liburing)
+ *  V1.0/2026-10-16
+ *  V1.1/2026-10-16 Free submission entries
+ *
+ *  Just what the poller needs: queue submission entries, submit them
+ *  and wait for completions in one io_uring_enter() with a timeout,
+ *  then walk the completions. Needs Linux 5.17 (IORING_FEAT_CQE_SKIP);
+ *  uring_init() fails on older kernels, where seccomp forbids io_uring
+ *  or when built with NO_URING, and the caller falls back to epoll.
+ */
+#ifndef URING_H
+#define URING_H
+
+#include <stddef.h>  /* For size_t */
+#include <stdint.h>  /* For uint64_t */
+#include <time.h>    /* For struct timespec */
+
+#ifndef NO_URING
+#include <linux/io_uring.h>  /* For io_uring_sqe, io_uring_cqe */
+#else
+struct io_uring_sqe;
+struct io_uring_cqe;
+#endif
+
+/* Flags of queued entries */
+#define URING_LINK  0x01  /* Next entry starts when this one has succeeded */
+#define URING_ASYNC 0x02  /* Run in a kernel worker, not inline in the task */
+#define URING_QUIET 0x04  /* No completion on success, only on failure */
+
+/* Absolute timeout of a linked read, same layout as struct __kernel_timespec */
+typedef struct {
+    long long tv_sec;
+    long long tv_nsec;
+} UringTime;
+
+/**
+ * Ring statistics
+ */
+typedef struct {
+    unsigned long enters;    /* io_uring_enter() calls */
+    unsigned long sqes;      /* Submission entries submitted */
+    unsigned long cqes;      /* Completions reaped */
+    unsigned long batch_max; /* Most completions reaped after one wait */
+} UringStats;
+
+/**
+ * Submission and completion rings of one io_uring instance
+ */
+typedef struct {
+    int fd;                      /* io_uring file descriptor, -1 = closed */
+    void *sq_ring;               /* Mapped submission ring */
+    void *cq_ring;               /* Mapped completion ring (may be sq_ring) */
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    struct io_uring_sqe *sqes;   /* Mapped submission entries */
+    size_t sqes_size;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    unsigned sq_local_tail;      /* Entries queued, not yet submitted */
+    unsigned sq_submitted;       /* Tail given to the kernel */
+    unsigned long batch;         /* Completions reaped since the last wait */
+    UringStats stats;            /* Statistics */
+} Uring;
+
+/**
+ * Set up a ring
+ *
+ * @param r       Ring
+ * @param entries Submission queue size (rounded up to a power of 2)
+ * @return        0 on success, negative errno if io_uring cannot be used
+ */
+extern int uring_init(Uring *r, unsigned entries);
+
+/**
+ * Queue a read (IORING_OP_READ) at the current file position
+ *
+ * @param r         Ring
+ * @param fd        File descriptor
+ * @param buf       Buffer, valid until the completion
+ * @param len       Size of the buffer
+ * @param user_data Tag of the completion
+ * @param flags     URING_LINK, URING_ASYNC, URING_QUIET
+ * @return          0, -1 if the submission queue is full
+ */
+extern int uring_read(Uring *r, int fd, void *buf, unsigned len, uint64_t user_data,
+                      unsigned flags);
+
+/**
+ * Queue a write (IORING_OP_WRITE) at the current file position
+ *
+ * @param r         Ring
+ * @param fd        File descriptor
+ * @param buf       Data, valid until the completion
+ * @param len       Number of bytes
+ * @param user_data Tag of the completion
+ * @param flags     URING_LINK, URING_ASYNC, URING_QUIET
+ * @return          0, -1 if the submission queue is full
+ */
+extern int uring_write(Uring *r, int fd, const void *buf, unsigned len,
+                       uint64_t user_data, unsigned flags);
+
+/**
+ * Queue a timeout for the entry queued just before (IORING_OP_LINK_TIMEOUT)
+ *
+ * The linked entry is cancelled (-ECANCELED) if it has not completed by
+ * the absolute CLOCK_MONOTONIC time ts.
+ *
+ * @param r         Ring
+ * @param ts        Absolute deadline, valid until the completion
+ * @param user_data Tag of the completion
+ * @return          0, -1 if the submission queue is full
+ */
+extern int uring_link_timeout(Uring *r, const UringTime *ts, uint64_t user_data);
+
+/**
+ * Queue a wait the next entry is linked to (IORING_OP_TIMEOUT)
+ *
+ * The next entry starts at the absolute CLOCK_MONOTONIC time ts. The
+ * wait posts no completion when it runs out (needs Linux 5.17).
+ *
+ * @param r         Ring
+ * @param ts        Absolute start of the next entry
+ * @param user_data Tag of the completion
+ * @return          0, -1 if the submission queue is full
+ */
+extern int uring_delay(Uring *r, const UringTime *ts, uint64_t user_data);
+
+/**
+ * Queue a one-shot readiness poll (IORING_OP_POLL_ADD, POLLIN)
+ *
+ * @param r         Ring
+ * @param fd        File descriptor (e.g. an epoll instance)
+ * @param user_data Tag of the completion
+ * @return          0, -1 if the submission queue is full
+ */
+extern int uring_poll(Uring *r, int fd, uint64_t user_data);
+
+/**
+ * Get the number of free submission entries
+ *
+ * A linked chain must fit as a whole: an entry queued with URING_LINK
+ * and nothing behind it links to whatever is queued next.
+ *
+ * @param r Ring
+ * @return  Entries that can be queued before the next submit
+ */
+extern unsigned uring_sq_space(Uring *r);
+
+/**
+ * Submit all queued entries and wait for completions in one system call
+ *
+ * @param r          Ring
+ * @param wait_nr    Completions to wait for (0 = only submit)
+ * @param timeout_ms Longest wait, -1 = no limit
+ * @return           0, -ETIME on timeout, other negative errno on failure
+ */
+extern int uring_submit_wait(Uring *r, unsigned wait_nr, int timeout_ms);
+
+/**
+ * Get the next completion without waiting
+ *
+ * @param r         Ring
+ * @param user_data Pointer to store the tag of the entry
+ * @param res       Pointer to store the result (bytes or negative errno)
+ * @return          1 if a completion was taken, 0 if there is none
+ */
+extern int uring_next(Uring *r, uint64_t *user_data, int *res);
+
+/**
+ * Unmap the rings and close the instance
+ *
+ * @param r Ring
+ */
+extern void uring_close(Uring *r);
+
+/**
+ * Convert a CLOCK_MONOTONIC time to a ring timeout
+ *
+ * @param t  Time
+ * @param ts Pointer to store the ring timeout
+ */
+extern void uring_time(const struct timespec *t, UringTime *ts);
+
+#endif /* URING_H */
@@ -1,6 +1,8 @@
 /*
  * Device settings modification functions
  * V1.0/2025-04-17
+ * V1.1/2026-10-16 All corrections of a device in one transaction
+ * V1.2/2026-10-16 Automatic report interval
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,6 +10,8 @@
 
 #include "write_functions.h"
 #include "monada.h"
+#include "modbus_ctx.h"
+#include "autoreport.h"
 #include "typedef.h"
 #include "constants.h"
 
@@ -144,6 +148,76 @@ AppStatus write_correction(int fd, uint8_t adr, uint8_t ch, float T_c)
     return STATUS_OK;
 }
 
+/*
+ * Write temperature corrections of channels 1..n in one transaction
+ */
+AppStatus write_corrections(int fd, uint8_t adr, const float T_c[], int n)
+{
+    uint16_t values[MAX_CHANNELS];
+    int i, single;
+    AppStatus status;
+
+    if (n < 1 || n > MAX_CHANNELS) {
+        fprintf(stderr, "Invalid number of corrections (%d) - must be 1-%d\n", n, MAX_CHANNELS);
+        return ERROR_INVALID_CHANNEL;
+    }
+
+    for (i = 0; i < n; i++) {
+        if (T_c[i] < MIN_TEMPERATURE || T_c[i] > MAX_TEMPERATURE) {
+            fprintf(stderr, "Temperature correction %.1f out of range (%.1f to %.1f)\n",
+                    T_c[i], MIN_TEMPERATURE, MAX_TEMPERATURE);
+            return ERROR_WRITE_CORRECTION;
+        }
+        values[i] = (uint16_t)(int16_t)(10*T_c[i]);
+    }
+
+    /* Registers 0x08..0x0F */
+    status = monada_write_registers(fd, adr, 0x0008, (uint16_t)n, values, 1,
+                                    "correction_temperatures", &single);
+    if (status != STATUS_OK) {
+        return ERROR_WRITE_CORRECTION;
+    }
+
+    printf("Write temperature corrections to channels 1-%d:", n);
+    for (i = 0; i < n; i++) {
+        printf(" %.1f", T_c[i]);
+    }
+    printf("\n");
+    if (single) {
+        printf("Device rejected Write Multiple Registers (0x10), written one by one (0x06)\n");
+    }
+
+    return STATUS_OK;
+}
+
+/*
+ * Write the automatic report interval
+ * Writes the interval to register 0x00FD
+ */
+AppStatus write_auto_report(int fd, uint8_t adr, int seconds)
+{
+    ModbusCtx ctx;
+
+    if (seconds < 0 || seconds > AUTOREPORT_MAX) {
+        fprintf(stderr, "Automatic report interval %d is not 0..%d!\n",
+                seconds, AUTOREPORT_MAX);
+        return ERROR_INVALID_TIME;
+    }
+
+    modbus_ctx_init_shared(&ctx, fd);
+    if (autoreport_set(&ctx, adr, seconds) != STATUS_OK) {
+        return ERROR_AUTO_REPORT;
+    }
+
+    if (seconds == 0) {
+        printf("Automatic report off (query mode)\n");
+    } else {
+        printf("Automatic report every %d s\n", seconds);
+    }
+
+    return STATUS_OK;
+}
+
 /*
  * Perform factory reset on the device
  * Writes value 5 to register 0x00FF
@@ -1,6 +1,8 @@
 /*
  * Device settings modification functions
  * V1.0/2025-04-17
+ * V1.1/2026-10-16 All corrections of a device in one transaction
+ * V1.2/2026-10-16 Automatic report interval
  */
 #ifndef WRITE_FUNCTIONS_H
 #define WRITE_FUNCTIONS_H
@@ -42,6 +44,35 @@ AppStatus write_baudrate(int fd, uint8_t adr, uint8_t cbr);
  */
 AppStatus write_correction(int fd, uint8_t adr, uint8_t ch, float T_c);
 
+/**
+ * Write temperature corrections of channels 1..n in one transaction
+ *
+ * Uses Write Multiple Registers (0x10); a device that rejects it gets
+ * one Write Single Register (0x06) per channel.
+ *
+ * @param fd File descriptor for the serial port
+ * @param adr Device address
+ * @param T_c Correction temperature values of channels 1..n
+ * @param n Number of channels (1-8)
+ *
+ * @return STATUS_OK on success, otherwise an error code from AppStatus enum
+ */
+AppStatus write_corrections(int fd, uint8_t adr, const float T_c[], int n);
+
+/**
+ * Write the automatic report interval (register 0x00FD)
+ *
+ * With an interval set the device pushes its temperatures on its own
+ * and needs no read requests; 0 returns it to query mode.
+ *
+ * @param fd File descriptor for the serial port
+ * @param adr Device address
+ * @param seconds Interval in seconds (1-255), 0 = off
+ *
+ * @return STATUS_OK on success, otherwise an error code from AppStatus enum
+ */
+AppStatus write_auto_report(int fd, uint8_t adr, int seconds);
+
 /**
  * Get baudrate value from code
  *